@@ -0,0 +1,76 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef WASP_BENCH_BENCH_UTILS_H_
+#define WASP_BENCH_BENCH_UTILS_H_
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "fmt/format.h"
+#include "wasp/base/errors_nop.h"
+#include "wasp/base/features.h"
+#include "wasp/base/span.h"
+#include "wasp/base/string_view.h"
+#include "wasp/binary/lazy_module.h"
+#include "wasp/binary/sections.h"
+
+namespace wasp::bench {
+
+// Runs `func` `iterations` times, and returns the fastest run in nanoseconds.
+template <typename F>
+double TimeBestOf(int iterations, F&& func) {
+  using Clock = std::chrono::steady_clock;
+  double best = 0;
+  for (int i = 0; i < iterations; ++i) {
+    auto start = Clock::now();
+    func();
+    auto end = Clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    best = i == 0 ? ns : std::min(best, ns);
+  }
+  return best;
+}
+
+inline void PrintResult(string_view name, double ns, size_t items) {
+  fmt::print("{:<24} {:>12.0f} ns {:>8.2f} ns/item\n", name, ns,
+             items ? ns / items : 0.0);
+}
+
+// Returns the body of every function in the module's code section.
+inline std::vector<SpanU8> GetCodeBodies(SpanU8 data) {
+  ErrorsNop errors;
+  Features features;
+  features.EnableAll();
+  auto module = binary::ReadModule(data, features, errors);
+  std::vector<SpanU8> result;
+  for (auto section : module.sections) {
+    if (section->is_known() &&
+        section->known()->id == binary::SectionId::Code) {
+      auto code_section =
+          binary::ReadCodeSection(section->known(), module.context);
+      for (auto code : code_section.sequence) {
+        result.push_back(code->body->data);
+      }
+    }
+  }
+  return result;
+}
+
+}  // namespace wasp::bench
+
+#endif  // WASP_BENCH_BENCH_UTILS_H_
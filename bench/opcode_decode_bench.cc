@@ -0,0 +1,191 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+// Compares the table-driven encoding::Opcode::Decode with the switch-based
+// decoding it replaced. The opcodes are taken from the code sections of the
+// given modules, or, if no modules are given, every opcode in opcode.def.
+//
+// Usage: opcode_decode_bench [filenames...]
+
+#include <vector>
+
+#include "bench/bench_utils.h"
+#include "fmt/format.h"
+#include "wasp/base/errors_nop.h"
+#include "wasp/base/file.h"
+#include "wasp/base/macros.h"
+#include "wasp/base/optional.h"
+#include "wasp/binary/encoding.h"
+#include "wasp/binary/lazy_expression.h"
+#include "wasp/binary/read/context.h"
+
+using namespace ::wasp;
+using namespace ::wasp::binary;
+
+namespace {
+
+struct OpcodeBytes {
+  u8 prefix;  // 0 if there is no prefix.
+  u32 code;
+};
+
+// The switch-based decoders are kept out of line, so they are called the same
+// way as the library functions.
+WASP_NOINLINE optional<::wasp::Opcode> SwitchDecode(u8 code,
+                                                    const Features& features) {
+  switch (code) {
+#define WASP_V(prefix, code, Name, str) \
+  case code:                            \
+    return ::wasp::Opcode::Name;
+#define WASP_FEATURE_V(prefix, code, Name, str, feature) \
+  case code:                                             \
+    if (features.feature##_enabled()) {                  \
+      return ::wasp::Opcode::Name;                       \
+    }                                                    \
+    break;
+#define WASP_PREFIX_V(...) /* Invalid. */
+#include "wasp/base/def/opcode.def"
+#undef WASP_V
+#undef WASP_FEATURE_V
+#undef WASP_PREFIX_V
+    default:
+      break;
+  }
+  return nullopt;
+}
+
+constexpr u64 MakePrefixCode(u8 prefix, u32 code) {
+  return (u64{prefix} << 32) | code;
+}
+
+WASP_NOINLINE optional<::wasp::Opcode> SwitchDecode(u8 prefix,
+                                                    u32 code,
+                                                    const Features& features) {
+  switch (MakePrefixCode(prefix, code)) {
+#define WASP_V(...) /* Invalid. */
+#define WASP_FEATURE_V(...) /* Invalid. */
+#define WASP_PREFIX_V(prefix, code, Name, str, feature) \
+  case MakePrefixCode(prefix, code):                    \
+    if (features.feature##_enabled()) {                 \
+      return ::wasp::Opcode::Name;                      \
+    }                                                   \
+    break;
+#include "wasp/base/def/opcode.def"
+#undef WASP_V
+#undef WASP_FEATURE_V
+#undef WASP_PREFIX_V
+    default:
+      break;
+  }
+  return nullopt;
+}
+
+void CollectCodes(SpanU8 body,
+                  const Features& features,
+                  std::vector<OpcodeBytes>* out) {
+  ErrorsNop errors;
+  Context context{features, errors};
+  for (const auto& instr : ReadExpression(body, context)) {
+    auto encoded = encoding::Opcode::Encode(*instr->opcode);
+    if (encoded.u32_code) {
+      out->push_back(OpcodeBytes{encoded.u8_code, *encoded.u32_code});
+    } else {
+      out->push_back(OpcodeBytes{0, encoded.u8_code});
+    }
+  }
+}
+
+std::vector<OpcodeBytes> AllCodes() {
+  std::vector<OpcodeBytes> result;
+#define WASP_V(prefix, code, Name, str) result.push_back(OpcodeBytes{0, code});
+#define WASP_FEATURE_V(prefix, code, Name, str, feature) \
+  result.push_back(OpcodeBytes{0, code});
+#define WASP_PREFIX_V(prefix, code, Name, str, feature) \
+  result.push_back(OpcodeBytes{prefix, code});
+#include "wasp/base/def/opcode.def"
+#undef WASP_V
+#undef WASP_FEATURE_V
+#undef WASP_PREFIX_V
+  return result;
+}
+
+template <bool Table>
+u64 DecodeAll(const std::vector<OpcodeBytes>& codes, const Features& features) {
+  u64 sum = 0;
+  for (auto code : codes) {
+    optional<::wasp::Opcode> decoded;
+    if constexpr (Table) {
+      decoded = code.prefix
+                    ? encoding::Opcode::Decode(code.prefix, code.code, features)
+                    : encoding::Opcode::Decode(code.code, features);
+    } else {
+      decoded = code.prefix ? SwitchDecode(code.prefix, code.code, features)
+                            : SwitchDecode(code.code, features);
+    }
+    sum = sum * 31 + (decoded ? static_cast<u64>(*decoded) + 1 : 0);
+  }
+  return sum;
+}
+
+void Run(string_view name, const std::vector<OpcodeBytes>& codes) {
+  constexpr int kIterations = 20;
+
+  Features features;
+  features.EnableAll();
+  u64 switch_sum = 0, table_sum = 0;
+  double switch_ns = bench::TimeBestOf(
+      kIterations, [&]() { switch_sum = DecodeAll<false>(codes, features); });
+  double table_ns = bench::TimeBestOf(
+      kIterations, [&]() { table_sum = DecodeAll<true>(codes, features); });
+
+  fmt::print("{}: {} opcodes\n", name, codes.size());
+  bench::PrintResult("switch", switch_ns, codes.size());
+  bench::PrintResult("table", table_ns, codes.size());
+  fmt::print("speedup: {:.2f}x{}\n", switch_ns / table_ns,
+             switch_sum == table_sum ? "" : " (MISMATCH)");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc == 1) {
+    auto all = AllCodes();
+    std::vector<OpcodeBytes> codes;
+    for (int i = 0; i < 1000; ++i) {
+      codes.insert(codes.end(), all.begin(), all.end());
+    }
+    Run("opcode.def", codes);
+    return 0;
+  }
+
+  for (int i = 1; i < argc; ++i) {
+    auto file = ReadFile(argv[i], MapFileTag{});
+    if (!file) {
+      fmt::print("Error reading file {}.\n", argv[i]);
+      return 1;
+    }
+
+    Features features;
+    features.EnableAll();
+    std::vector<OpcodeBytes> codes;
+    for (auto body : bench::GetCodeBodies(file->data())) {
+      CollectCodes(body, features, &codes);
+    }
+    Run(argv[i], codes);
+  }
+  return 0;
+}
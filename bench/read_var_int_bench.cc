@@ -0,0 +1,124 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Compares ReadVarInt with the byte-at-a-time ReadVarIntSlow, decoding every
+// LEB128 immediate found in the code sections of the given modules.
+//
+// Usage: read_var_int_bench <filenames...>
+
+#include <vector>
+
+#include "bench/bench_utils.h"
+#include "fmt/format.h"
+#include "wasp/base/errors_nop.h"
+#include "wasp/base/file.h"
+#include "wasp/binary/lazy_expression.h"
+#include "wasp/binary/read/context.h"
+#include "wasp/binary/read/read_var_int.h"
+
+using namespace ::wasp;
+using namespace ::wasp::binary;
+
+namespace {
+
+// Each immediate is decoded from its start to the end of the function body,
+// as it would be when reading the instruction stream.
+struct VarInts {
+  std::vector<SpanU8> indexes;
+  std::vector<SpanU8> s32s;
+  std::vector<SpanU8> s64s;
+
+  size_t size() const { return indexes.size() + s32s.size() + s64s.size(); }
+};
+
+void CollectVarInts(SpanU8 body, VarInts* out) {
+  ErrorsNop errors;
+  Features features;
+  features.EnableAll();
+  Context context{features, errors};
+  const u8* end = body.data() + body.size();
+  auto rest = [&](Location loc) {
+    return SpanU8{loc.data(), static_cast<span_extent_t>(end - loc.data())};
+  };
+  for (const auto& instr : ReadExpression(body, context)) {
+    if (instr->has_index_immediate()) {
+      out->indexes.push_back(rest(instr->index_immediate().loc()));
+    } else if (instr->has_s32_immediate()) {
+      out->s32s.push_back(rest(instr->s32_immediate().loc()));
+    } else if (instr->has_s64_immediate()) {
+      out->s64s.push_back(rest(instr->s64_immediate().loc()));
+    }
+  }
+}
+
+template <typename T, typename F>
+u64 DecodeAll(const std::vector<SpanU8>& spans, Context& context, F&& read) {
+  u64 sum = 0;
+  for (SpanU8 span : spans) {
+    auto value = read(&span, context, "bench");
+    sum += static_cast<u64>(**value);
+  }
+  return sum;
+}
+
+template <bool Fast>
+u64 DecodeVarInts(const VarInts& varints, Context& context) {
+  if constexpr (Fast) {
+    return DecodeAll<Index>(varints.indexes, context, ReadVarInt<Index>) +
+           DecodeAll<s32>(varints.s32s, context, ReadVarInt<s32>) +
+           DecodeAll<s64>(varints.s64s, context, ReadVarInt<s64>);
+  } else {
+    return DecodeAll<Index>(varints.indexes, context, ReadVarIntSlow<Index>) +
+           DecodeAll<s32>(varints.s32s, context, ReadVarIntSlow<s32>) +
+           DecodeAll<s64>(varints.s64s, context, ReadVarIntSlow<s64>);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  constexpr int kIterations = 20;
+
+  for (int i = 1; i < argc; ++i) {
+    auto file = ReadFile(argv[i], MapFileTag{});
+    if (!file) {
+      fmt::print("Error reading file {}.\n", argv[i]);
+      return 1;
+    }
+
+    VarInts varints;
+    for (auto body : bench::GetCodeBodies(file->data())) {
+      CollectVarInts(body, &varints);
+    }
+
+    ErrorsNop errors;
+    Context context{errors};
+    u64 slow_sum = 0, fast_sum = 0;
+    double slow = bench::TimeBestOf(kIterations, [&]() {
+      slow_sum = DecodeVarInts<false>(varints, context);
+    });
+    double fast = bench::TimeBestOf(kIterations, [&]() {
+      fast_sum = DecodeVarInts<true>(varints, context);
+    });
+
+    fmt::print("{}: {} varints\n", argv[i], varints.size());
+    bench::PrintResult("ReadVarIntSlow", slow, varints.size());
+    bench::PrintResult("ReadVarInt", fast, varints.size());
+    fmt::print("speedup: {:.2f}x{}\n", slow / fast,
+               slow_sum == fast_sum ? "" : " (MISMATCH)");
+  }
+  return 0;
+}
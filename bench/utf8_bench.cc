@@ -0,0 +1,139 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+// Compares the UTF-8 validators on names: the import, export and function
+// names of the given modules, or a generated set of mangled C++ names if no
+// modules are given.
+//
+// Usage: utf8_bench [<filenames...>]
+
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "bench/bench_utils.h"
+#include "fmt/format.h"
+#include "wasp/base/errors_nop.h"
+#include "wasp/base/features.h"
+#include "wasp/base/file.h"
+#include "wasp/base/utf8.h"
+#include "wasp/binary/lazy_module.h"
+#include "wasp/binary/lazy_module_utils.h"
+
+using namespace ::wasp;
+using namespace ::wasp::binary;
+
+namespace {
+
+std::vector<std::string> GenerateNames() {
+  const char* const parts[] = {"wasp",   "binary", "valid",  "Context",
+                               "Read",   "Visit",  "vector", "allocator",
+                               "string", "Index",  "At",     "optional"};
+  std::vector<std::string> names;
+  for (int i = 0; i < 200000; ++i) {
+    std::string name = "_ZN";
+    for (int j = 0; j < 2 + i % 5; ++j) {
+      const char* part = parts[(i * 7 + j * 3) % std::size(parts)];
+      name += fmt::format("{}{}", std::char_traits<char>::length(part), part);
+    }
+    name += "E";
+    if (i % 100 == 0) {
+      name += "\xe5\x90\x8d\xe5\x89\x8d";  // Some non-ASCII names.
+    }
+    names.push_back(name);
+  }
+  return names;
+}
+
+std::vector<std::string> CollectNames(SpanU8 data) {
+  ErrorsNop errors;
+  Features features;
+  features.EnableAll();
+  auto module = ReadModule(data, features, errors);
+  std::vector<std::string> names;
+  ForEachFunctionName(module, [&](const IndexNamePair& pair) {
+    names.push_back(std::string{pair.second});
+  });
+  return names;
+}
+
+void Run(string_view label, const std::vector<std::string>& names) {
+  constexpr int kIterations = 20;
+  const Utf8Validator validators[] = {Utf8Validator::Scalar,
+                                      Utf8Validator::Sse2,
+                                      Utf8Validator::Avx2};
+  const char* const validator_names[] = {"Scalar", "Sse2", "Avx2"};
+
+  size_t bytes = 0;
+  for (const auto& name : names) {
+    bytes += name.size();
+  }
+  fmt::print("{}: {} names, {} bytes\n", label, names.size(), bytes);
+
+  double scalar = 0;
+  size_t scalar_valid = 0;
+  for (size_t i = 0; i < std::size(validators); ++i) {
+    if (!IsUtf8ValidatorSupported(validators[i])) {
+      fmt::print("{:<24} unsupported\n", validator_names[i]);
+      continue;
+    }
+    size_t valid = 0;
+    double ns = bench::TimeBestOf(kIterations, [&]() {
+      valid = 0;
+      for (const auto& name : names) {
+        valid += IsValidUtf8(name, validators[i]);
+      }
+    });
+    if (i == 0) {
+      scalar = ns;
+      scalar_valid = valid;
+    }
+    bench::PrintResult(validator_names[i], ns, names.size());
+    fmt::print("speedup: {:.2f}x{}\n", scalar / ns,
+               valid == scalar_valid ? "" : " (MISMATCH)");
+  }
+
+  size_t valid = 0;
+  double ns = bench::TimeBestOf(kIterations, [&]() {
+    valid = 0;
+    for (const auto& name : names) {
+      valid += IsValidUtf8(name);
+    }
+  });
+  bench::PrintResult("IsValidUtf8", ns, names.size());
+  fmt::print("speedup: {:.2f}x{}\n", scalar / ns,
+             valid == scalar_valid ? "" : " (MISMATCH)");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc == 1) {
+    Run("generated", GenerateNames());
+    return 0;
+  }
+
+  for (int i = 1; i < argc; ++i) {
+    auto file = ReadFile(argv[i], MapFileTag{});
+    if (!file) {
+      fmt::print("Error reading file {}.\n", argv[i]);
+      return 1;
+    }
+    Run(argv[i], CollectNames(file->data()));
+  }
+  return 0;
+}
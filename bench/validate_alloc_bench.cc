@@ -0,0 +1,207 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+// Measures the heap allocations made while validating function bodies, per
+// instruction. The bodies are taken from the given modules, or from a
+// generated module dominated by small blocks if no modules are given. The
+// bodies are decoded before timing, so only the validator's allocations are
+// counted. Each module is validated once first, so buffers that are kept
+// between functions have already grown.
+//
+// Usage: validate_alloc_bench [<filenames...>]
+
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "bench/bench_utils.h"
+#include "fmt/format.h"
+#include "wasp/base/errors_nop.h"
+#include "wasp/base/features.h"
+#include "wasp/base/file.h"
+#include "wasp/binary/lazy_expression.h"
+#include "wasp/binary/lazy_module.h"
+#include "wasp/binary/visitor.h"
+#include "wasp/valid/validate.h"
+#include "wasp/valid/validate_visitor.h"
+
+namespace {
+
+size_t allocation_count = 0;
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+  ++allocation_count;
+  if (void* ptr = std::malloc(size ? size : 1)) {
+    return ptr;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+using namespace ::wasp;
+using namespace ::wasp::binary;
+
+namespace {
+
+void AppendU32(std::string& out, u32 value) {
+  do {
+    u8 byte = value & 0x7f;
+    value >>= 7;
+    out += static_cast<char>(value ? byte | 0x80 : byte);
+  } while (value);
+}
+
+void AppendSection(std::string& out, u8 id, const std::string& contents) {
+  out += static_cast<char>(id);
+  AppendU32(out, static_cast<u32>(contents.size()));
+  out += contents;
+}
+
+// Generates a module whose functions are made of many small blocks, loops and
+// ifs, with calls and branches between them.
+std::string GenerateModule() {
+  constexpr u32 kFunctionCount = 2000;
+  constexpr int kPatternsPerFunction = 40;
+
+  // Each pattern leaves the stack unchanged.
+  const std::string patterns[] = {
+      // block (result i32) local.get 0 end drop
+      std::string{"\x02\x7f\x20\x00\x0b\x1a", 6},
+      // loop local.get 0 br_if 0 end
+      std::string{"\x03\x40\x20\x00\x0d\x00\x0b", 7},
+      // local.get 0 if (result i32) i32.const 1 else i32.const 2 end drop
+      std::string{"\x20\x00\x04\x7f\x41\x01\x05\x41\x02\x0b\x1a", 11},
+      // local.get 0 call 0 drop
+      std::string{"\x20\x00\x10\x00\x1a", 5},
+      // local.get 0 block (type 0) i32.eqz end drop
+      std::string{"\x20\x00\x02\x00\x45\x0b\x1a", 7},
+      // block block br 1 end end
+      std::string{"\x02\x40\x02\x40\x0c\x01\x0b\x0b", 8},
+  };
+
+  std::string module{"\0asm\x01\0\0\0", 8};
+  // (type (func (param i32) (result i32)))
+  AppendSection(module, 1, std::string{"\x01\x60\x01\x7f\x01\x7f", 6});
+
+  std::string functions;
+  AppendU32(functions, kFunctionCount);
+  functions.append(kFunctionCount, '\0');
+  AppendSection(module, 3, functions);
+
+  std::string code;
+  AppendU32(code, kFunctionCount);
+  for (u32 i = 0; i < kFunctionCount; ++i) {
+    std::string body{"\0", 1};  // No locals.
+    for (int j = 0; j < kPatternsPerFunction; ++j) {
+      body += patterns[(i + j) % std::size(patterns)];
+    }
+    body += std::string{"\x20\x00\x0b", 3};  // local.get 0 end
+    AppendU32(code, static_cast<u32>(body.size()));
+    code += body;
+  }
+  AppendSection(module, 10, code);
+  return module;
+}
+
+void Run(string_view label, SpanU8 data) {
+  constexpr int kIterations = 10;
+
+  Features features;
+  features.EnableAll();
+  ErrorsNop errors;
+  auto module = ReadModule(data, features, errors);
+  valid::ValidateVisitor visitor{features, errors};
+  if (visit::Visit(module, visitor) != visit::Result::Ok) {
+    fmt::print("{}: not valid, skipping\n", label);
+    return;
+  }
+
+  // Decode the bodies up front.
+  std::vector<At<Code>> codes;
+  std::vector<InstructionList> bodies;
+  size_t instruction_count = 0;
+  for (auto section : module.sections) {
+    if (section->is_known() && section->known()->id == SectionId::Code) {
+      for (auto code :
+           ReadCodeSection(section->known(), module.context).sequence) {
+        InstructionList instrs;
+        for (const auto& instr : ReadExpression(code->body, module.context)) {
+          instrs.push_back(instr);
+        }
+        instruction_count += instrs.size();
+        codes.push_back(code);
+        bodies.push_back(std::move(instrs));
+      }
+    }
+  }
+
+  auto& context = visitor.context;
+  const Index first_code = context.code_count - codes.size();
+  auto validate_bodies = [&]() {
+    context.code_count = first_code;
+    for (size_t i = 0; i < codes.size(); ++i) {
+      valid::BeginCode(context, codes[i].loc());
+      valid::Validate(context, codes[i]->locals, valid::RequireDefaultable::Yes);
+      for (const auto& instr : bodies[i]) {
+        valid::Validate(context, instr);
+      }
+    }
+  };
+
+  validate_bodies();
+  allocation_count = 0;
+  double ns = bench::TimeBestOf(kIterations, validate_bodies);
+  size_t allocations = allocation_count / kIterations;
+
+  fmt::print("{}: {} functions, {} instructions\n", label, codes.size(),
+             instruction_count);
+  bench::PrintResult("validate", ns, instruction_count);
+  fmt::print("{:<24} {:>12} allocs {:>8.3f} allocs/item\n", "allocations",
+             allocations,
+             instruction_count ? double(allocations) / instruction_count : 0.0);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc == 1) {
+    auto module = GenerateModule();
+    Run("generated",
+        SpanU8{reinterpret_cast<const u8*>(module.data()), module.size()});
+    return 0;
+  }
+
+  for (int i = 1; i < argc; ++i) {
+    auto file = ReadFile(argv[i], MapFileTag{});
+    if (!file) {
+      fmt::print("Error reading file {}.\n", argv[i]);
+      return 1;
+    }
+    Run(argv[i], file->data());
+  }
+  return 0;
+}
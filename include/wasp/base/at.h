@@ -17,32 +17,174 @@
 #ifndef WASP_BASE_AT_H_
 #define WASP_BASE_AT_H_
 
+#include <cassert>
+#include <cstdint>
 #include <functional>
+#include <limits>
+#include <type_traits>
 #include <utility>
 
 #include "wasp/base/optional.h"
 #include "wasp/base/span.h"
+#include "wasp/base/types.h"
+
+// How At<T> stores the location of its value. This is chosen at build time
+// (see the WASP_AT_LOCATION CMake option):
+//
+//   WASP_AT_LOCATION_FULL:    The full Location (a pointer and a size_t).
+//   WASP_AT_LOCATION_COMPACT: A 32-bit offset from the current LocationBase
+//                             and a 32-bit length. For small values like
+//                             At<Index> this packs into 12 bytes instead of
+//                             24 (debug builds also keep the base, to check
+//                             that it is read with the same one). A location
+//                             that doesn't fit is dropped.
+//   WASP_AT_LOCATION_NONE:    No location at all, so At<T> is the same size as
+//                             T, and loc() always returns an empty Location.
+//                             Errors will not have locations.
+#define WASP_AT_LOCATION_FULL 0
+#define WASP_AT_LOCATION_COMPACT 1
+#define WASP_AT_LOCATION_NONE 2
+
+#ifndef WASP_AT_LOCATION
+#define WASP_AT_LOCATION WASP_AT_LOCATION_FULL
+#endif
 
 namespace wasp {
 
+// Sets the base address that compact locations are stored relative to, for
+// the current thread, until it is destroyed. It is usually created for the
+// whole buffer that is being read, such as a mapped file; each location must
+// then be within 2GiB of the buffer's start. Without a LocationBase, the base
+// is an address in the program's static data, near its string literals.
+//
+// A compact location must be read with the same base it was stored with. Any
+// At that outlives the LocationBase scope must not have its loc() read after
+// the scope ends. A location that is out of range of the base is not stored,
+// so loc() returns an empty Location.
+//
+// ThreadPool tasks use the base of the thread that enqueued them. The base is
+// only used by WASP_AT_LOCATION_COMPACT.
+class LocationBase {
+ public:
+  explicit LocationBase(const u8* base) : previous_{current_} {
+    current_ = base;
+  }
+  explicit LocationBase(SpanU8 buffer) : LocationBase{buffer.data()} {}
+  LocationBase(const LocationBase&) = delete;
+  LocationBase& operator=(const LocationBase&) = delete;
+  ~LocationBase() { current_ = previous_; }
+
+  static const u8* Get() { return current_; }
+
+ private:
+  static inline const u8 anchor_ = 0;
+  static inline thread_local const u8* current_ = &anchor_;
+
+  const u8* previous_;
+};
+
+#if WASP_AT_LOCATION == WASP_AT_LOCATION_FULL
+
 template <typename T>
-struct At : std::pair<Location, T> {
+struct AtBase : std::pair<Location, T> {
+  AtBase() = default;
+  explicit AtBase(Location loc, T v)
+      : std::pair<Location, T>{loc, std::move(v)} {}
+
+  Location loc() const { return this->first; }
+  void set_loc(Location loc) { this->first = loc; }
+};
+
+#elif WASP_AT_LOCATION == WASP_AT_LOCATION_COMPACT
+
+template <typename T>
+struct AtBase {
+  template <typename U = T,
+            typename = std::enable_if_t<std::is_default_constructible_v<U>>>
+  AtBase() : second{} {}
+  explicit AtBase(Location loc, T v) : second{std::move(v)} { set_loc(loc); }
+
+  Location loc() const {
+    if (loc_offset == kNoLocation) {
+      return Location{};
+    }
+    assert(loc_base == LocationBase::Get() &&
+           "Location is read with a different LocationBase");
+    return Location{LocationBase::Get() + loc_offset, loc_size};
+  }
+
+  void set_loc(Location loc) {
+    if (loc.data() == nullptr) {
+      loc_offset = kNoLocation;
+      loc_size = 0;
+      return;
+    }
+    auto offset = reinterpret_cast<std::intptr_t>(loc.data()) -
+                  reinterpret_cast<std::intptr_t>(LocationBase::Get());
+    bool in_range = offset > kNoLocation &&
+                    offset <= std::numeric_limits<s32>::max() &&
+                    loc.size() <= std::numeric_limits<u32>::max();
+    assert(in_range && "Location is too far from the LocationBase");
+    if (!in_range) {
+      // Drop the location rather than store one that points elsewhere.
+      loc_offset = kNoLocation;
+      loc_size = 0;
+      return;
+    }
+    loc_offset = static_cast<s32>(offset);
+    loc_size = static_cast<u32>(loc.size());
+#ifndef NDEBUG
+    loc_base = LocationBase::Get();
+#endif
+  }
+
+  static constexpr s32 kNoLocation = std::numeric_limits<s32>::min();
+
+  s32 loc_offset = kNoLocation;
+  u32 loc_size = 0;
+#ifndef NDEBUG
+  // The base that the offset is relative to, to check that it is read with
+  // the same one.
+  const u8* loc_base = nullptr;
+#endif
+  T second;
+};
+
+#elif WASP_AT_LOCATION == WASP_AT_LOCATION_NONE
+
+template <typename T>
+struct AtBase {
+  template <typename U = T,
+            typename = std::enable_if_t<std::is_default_constructible_v<U>>>
+  AtBase() : second{} {}
+  explicit AtBase(Location, T v) : second{std::move(v)} {}
+
+  Location loc() const { return Location{}; }
+  void set_loc(Location) {}
+
+  T second;
+};
+
+#else
+#error Unknown WASP_AT_LOCATION
+#endif
+
+template <typename T>
+struct At : AtBase<T> {
   using value_type = T;
 
   At() = default;
-  At(T v) : std::pair<Location, T>{{}, std::move(v)} {}
-  explicit At(Location loc, T v) : std::pair<Location, T>{loc, std::move(v)} {}
+  At(T v) : AtBase<T>{Location{}, std::move(v)} {}
+  explicit At(Location loc, T v) : AtBase<T>{loc, std::move(v)} {}
 
   At& operator=(T v) {
-    this->first = Location{};
+    this->set_loc(Location{});
     this->second = v;
     return *this;
   }
 
   operator const T&() const { return this->second; }
 
-  Location loc() const { return this->first; }
-
   const T& value() const { return this->second; }
   T& value() { return this->second; }
 
@@ -52,6 +194,24 @@ struct At : std::pair<Location, T> {
   T& operator*() { return this->second; }
 };
 
+#if WASP_AT_LOCATION != WASP_AT_LOCATION_FULL
+// These match the comparisons provided by std::pair in the full location
+// representation.
+template <typename T>
+bool operator==(const At<T>& lhs, const At<T>& rhs) {
+  return lhs.loc() == rhs.loc() && lhs.value() == rhs.value();
+}
+template <typename T>
+bool operator!=(const At<T>& lhs, const At<T>& rhs) {
+  return !(lhs == rhs);
+}
+template <typename T>
+bool operator<(const At<T>& lhs, const At<T>& rhs) {
+  return lhs.loc() < rhs.loc() ||
+         (!(rhs.loc() < lhs.loc()) && lhs.value() < rhs.value());
+}
+#endif
+
 // Deduction guides.
 template <typename T>
 At(T v) -> At<T>;
@@ -0,0 +1,100 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef WASP_BASE_CONCURRENT_ERRORS_H_
+#define WASP_BASE_CONCURRENT_ERRORS_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "wasp/base/error.h"
+#include "wasp/base/errors.h"
+#include "wasp/base/span.h"
+#include "wasp/base/string_view.h"
+#include "wasp/base/types.h"
+
+namespace wasp {
+
+// An Errors sink that can be shared by many threads.
+//
+// Each thread that reports to it gets its own context stack and its own
+// buffer of errors, so after a thread's first call no locks are taken. Once
+// the threads are done, the buffers are merged and sorted by location, so the
+// result doesn't depend on how the work was scheduled.
+//
+// The order is by location, not the order a sequential pass would report in.
+// That's why the parallel reader and validator don't use it: they must match
+// the sequential pass exactly (including errors without a location, and
+// dropping the errors after the first body that fails), so they record each
+// body's errors in a RecordingErrors and replay them in body order instead.
+class ConcurrentErrors : public Errors {
+ public:
+  // An error, along with the context that was pushed when it was reported.
+  // `context` is empty if context isn't tracked.
+  struct Entry {
+    std::vector<Error> context;
+    Error error;
+  };
+
+  explicit ConcurrentErrors(bool track_context = true);
+  ConcurrentErrors(const ConcurrentErrors&) = delete;
+  ConcurrentErrors& operator=(const ConcurrentErrors&) = delete;
+  ~ConcurrentErrors();
+
+  // True once any thread has reported an error. This can be polled by workers
+  // so they can stop early.
+  bool HasError() const { return has_error_.load(std::memory_order_relaxed); }
+
+  // The following must not be called while other threads are reporting
+  // errors.
+
+  // Returns the errors of all threads, ordered by location, then message.
+  auto GetEntries() const -> std::vector<Entry>;
+  // Reports the errors of all threads to `errors`, in the same order as
+  // GetEntries, pushing and popping each error's context around it.
+  void Replay(Errors&) const;
+  // Removes all errors, but keeps each thread's buffers.
+  void Clear();
+
+ protected:
+  void HandlePushContext(Location loc, string_view desc) override;
+  void HandlePopContext() override;
+  void HandleOnError(Location loc, string_view message) override;
+
+ private:
+  struct ThreadState {
+    std::vector<Error> context_stack;
+    std::vector<Entry> entries;
+  };
+
+  auto GetThreadState() -> ThreadState&;
+
+  // Distinguishes this object from any other ConcurrentErrors in the
+  // thread-local cache, even one later allocated at the same address.
+  const u64 id_;
+  std::atomic<bool> has_error_{false};
+  std::mutex mutex_;
+  std::unordered_map<std::thread::id, std::unique_ptr<ThreadState>> states_;
+};
+
+}  // namespace wasp
+
+#endif  // WASP_BASE_CONCURRENT_ERRORS_H_
@@ -24,7 +24,14 @@ namespace wasp {
 
 class Errors {
  public:
+  // Sinks that ignore the context can pass `track_context = false`. Then
+  // PushContext and PopContext return immediately, instead of making a virtual
+  // call for every item that is read.
+  explicit Errors(bool track_context = true) : track_context_{track_context} {}
   virtual ~Errors() {}
+
+  bool track_context() const { return track_context_; }
+
   void PushContext(Location loc, string_view desc);
   void PopContext();
   void OnError(Location loc, string_view message);
@@ -33,6 +40,9 @@ class Errors {
   virtual void HandlePushContext(Location loc, string_view desc) = 0;
   virtual void HandlePopContext() = 0;
   virtual void HandleOnError(Location loc, string_view message) = 0;
+
+ private:
+  bool track_context_;
 };
 
 }  // namespace wasp
@@ -22,6 +22,9 @@
 namespace wasp {
 
 class ErrorsNop : public Errors {
+ public:
+  ErrorsNop() : Errors{false} {}
+
  protected:
   void HandlePushContext(Location loc, string_view desc) override {}
   void HandlePopContext() override {}
@@ -21,12 +21,42 @@
 
 #include "wasp/base/buffer.h"
 #include "wasp/base/optional.h"
+#include "wasp/base/span.h"
 #include "wasp/base/string_view.h"
 #include "wasp/base/types.h"
 
 namespace wasp {
 
+// Tag used to select the MappedFile overload of ReadFile.
+struct MapFileTag {};
+
+// A read-only view of a file's contents. Where the platform supports it, the
+// file is memory-mapped so the data is read directly from the page cache,
+// otherwise it falls back to reading the file into a Buffer.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile(MappedFile&&) noexcept;
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile& operator=(MappedFile&&) noexcept;
+  ~MappedFile();
+
+  SpanU8 data() const;
+
+ private:
+  friend optional<MappedFile> ReadFile(string_view, MapFileTag);
+
+  void Unmap();
+
+  const u8* data_ = nullptr;
+  size_t size_ = 0;
+  bool mapped_ = false;
+  Buffer buffer_;  // Only used when the file could not be mapped.
+};
+
 optional<Buffer> ReadFile(string_view filename);
+optional<MappedFile> ReadFile(string_view filename, MapFileTag);
 
 }  // namespace wasp
 
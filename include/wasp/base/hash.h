@@ -20,6 +20,10 @@
 #include <iterator>
 
 #include "parallel_hashmap/phmap_utils.h"
+#include "wasp/base/operator_eq_ne_macros.h"
+#include "wasp/base/span.h"
+#include "wasp/base/std_hash_macros.h"
+#include "wasp/base/types.h"
 
 namespace wasp {
 
@@ -39,6 +43,22 @@ size_t HashContainer(const C& c) {
   return HashRange(std::begin(c), std::end(c));
 }
 
+// A fast, non-cryptographic 128-bit content hash (MurmurHash3 x64 128). Unlike
+// HashState, it is stable across platforms and releases, so it can be stored
+// or used as a cache key. Use `low` when 64 bits are enough.
+struct Hash128 {
+  u64 low = 0;
+  u64 high = 0;
+};
+
+auto HashBytes(SpanU8, u64 seed = 0) -> Hash128;
+
+#define WASP_BASE_HASH_STRUCTS(WASP_V) WASP_V(Hash128, 2, low, high)
+
+WASP_BASE_HASH_STRUCTS(WASP_DECLARE_OPERATOR_EQ_NE)
+
 }  // namespace wasp
 
+WASP_BASE_HASH_STRUCTS(WASP_DECLARE_STD_HASH)
+
 #endif  // WASP_BASE_HASH_H_
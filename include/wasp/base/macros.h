@@ -20,10 +20,12 @@
 #if defined(__GNUC__) || defined(__clang__)
 
 #define WASP_UNREACHABLE() __builtin_unreachable()
+#define WASP_NOINLINE __attribute__((noinline))
 
 #elif defined(_MSC_VER)
 
 #define WASP_UNREACHABLE() __assume(0)
+#define WASP_NOINLINE __declspec(noinline)
 
 #else
 
@@ -0,0 +1,61 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef WASP_BASE_RECORDING_ERRORS_H_
+#define WASP_BASE_RECORDING_ERRORS_H_
+
+#include <string>
+#include <vector>
+
+#include "wasp/base/errors.h"
+#include "wasp/base/span.h"
+#include "wasp/base/string_view.h"
+
+namespace wasp {
+
+// Records the calls made to an Errors object, so they can be replayed later on
+// another thread.
+class RecordingErrors : public Errors {
+ public:
+  RecordingErrors() = default;
+  explicit RecordingErrors(bool track_context) : Errors{track_context} {}
+
+  bool HasError() const { return has_error_; }
+
+  void Replay(Errors&) const;
+  // Removes all recorded calls, but keeps the buffer's capacity.
+  void Clear();
+
+ protected:
+  void HandlePushContext(Location loc, string_view desc) override;
+  void HandlePopContext() override;
+  void HandleOnError(Location loc, string_view message) override;
+
+ private:
+  struct Event {
+    enum Kind { PushContext, PopContext, Error } kind;
+    Location loc;
+    std::string text;
+  };
+
+  std::vector<Event> events_;
+  bool has_error_ = false;
+};
+
+}  // namespace wasp
+
+#endif  // WASP_BASE_RECORDING_ERRORS_H_
@@ -0,0 +1,77 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef WASP_BASE_THREAD_POOL_H_
+#define WASP_BASE_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace wasp {
+
+// A fixed set of worker threads that run tasks in FIFO order. The destructor
+// finishes all queued tasks before joining the workers.
+class ThreadPool {
+ public:
+  using Task = std::function<void()>;
+  using RangeCallback =
+      std::function<void(unsigned worker, size_t begin, size_t end)>;
+
+  // If `num_threads` is 0, one thread per hardware thread is used.
+  explicit ThreadPool(unsigned num_threads = 0);
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+  ~ThreadPool();
+
+  unsigned size() const;
+
+  // Each task runs with the LocationBase of the thread that enqueued it.
+  void Enqueue(Task);
+
+  // Calls `callback` with consecutive ranges of [0, count), each at most
+  // `chunk_size` long, on the threads of the pool. At most
+  // min(size(), chunk count) workers are used; `worker` identifies the one
+  // running the callback, so it can be used to index per-worker state.
+  //
+  // If given, `caller_task` runs on the calling thread while the ranges are
+  // being processed. Returns once it and all of the ranges are done. Must not
+  // be called from one of the pool's own threads.
+  void ParallelFor(size_t count,
+                   size_t chunk_size,
+                   const RangeCallback& callback,
+                   const Task& caller_task = {});
+
+  static unsigned DefaultThreadCount();
+
+ private:
+  void WorkerLoop();
+
+  std::vector<std::thread> threads_;
+  std::deque<Task> tasks_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stopping_ = false;
+};
+
+}  // namespace wasp
+
+#endif  // WASP_BASE_THREAD_POOL_H_
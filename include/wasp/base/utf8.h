@@ -21,8 +21,22 @@
 
 namespace wasp {
 
+// The implementations of IsValidUtf8. `Scalar` is always available; the
+// others are only used if the CPU supports them.
+enum class Utf8Validator {
+  Scalar,  // Byte-at-a-time DFA.
+  Sse2,    // DFA, skipping 16-byte blocks of ASCII.
+  Avx2,    // Vectorized validation of 32-byte blocks.
+};
+
+// Uses the fastest validator supported by the CPU.
 bool IsValidUtf8(string_view);
 
+// Uses the given validator, or `Scalar` if it isn't supported.
+bool IsValidUtf8(string_view, Utf8Validator);
+
+bool IsUtf8ValidatorSupported(Utf8Validator);
+
 }  // namespace wasp
 
 #endif  // WASP_BASE_UTF8_H_
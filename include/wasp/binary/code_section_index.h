@@ -0,0 +1,95 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef WASP_BINARY_CODE_SECTION_INDEX_H_
+#define WASP_BINARY_CODE_SECTION_INDEX_H_
+
+#include <vector>
+
+#include "wasp/base/optional.h"
+#include "wasp/base/span.h"
+#include "wasp/base/types.h"
+#include "wasp/binary/types.h"
+
+namespace wasp::binary {
+
+struct Context;
+
+// Provides random access to the function bodies of a code section.
+//
+// Construction makes a single pass over the section that only reads the
+// length of each body, and records where each one starts. After that, the
+// Code for any function can be read directly, without decoding the bodies
+// that come before it.
+//
+// Unlike LazyCodeSection, this does not check that the number of bodies
+// matches the section's count; entries after the first malformed one are not
+// indexed.
+class CodeSectionIndex {
+ public:
+  // `first_index` is the function index of the first body in this section,
+  // i.e. the number of imported functions.
+  explicit CodeSectionIndex(SpanU8, Context&, Index first_index = 0);
+  // Used when the body offsets are already known, e.g. from a ModuleIndex.
+  // `offsets` has the same layout as offsets(). If they are not strictly
+  // increasing from 0 to at most the data size, the section is scanned
+  // instead.
+  explicit CodeSectionIndex(SpanU8,
+                            Context&,
+                            Index first_index,
+                            std::vector<u32> offsets);
+
+  Index first_index() const { return first_index_; }
+  // The number of bodies that were indexed.
+  Index size() const { return static_cast<Index>(offsets_.size() - 1); }
+  bool empty() const { return size() == 0; }
+
+  bool contains(Index func_index) const;
+
+  // The section data following the count.
+  SpanU8 data() const { return data_; }
+  // The offset of each body from the start of data(), followed by the offset
+  // of the end of the last body.
+  const std::vector<u32>& offsets() const { return offsets_; }
+
+  // The bytes of the code entry for `func_index`, including its length.
+  // Returns an empty span if the function has no body in this section.
+  SpanU8 GetCodeData(Index func_index) const;
+
+  // Reads the code entry for `func_index`. Returns nullopt if the function has
+  // no body in this section, or if the entry is malformed.
+  OptAt<Code> GetCode(Index func_index) const;
+
+  OptAt<Index> count;
+
+ private:
+  void IndexBodies();
+  bool HasValidOffsets() const;
+
+  SpanU8 data_;
+  Context& context_;
+  Index first_index_;
+  std::vector<u32> offsets_;
+};
+
+auto ReadCodeSectionIndex(SpanU8, Context&, Index first_index = 0)
+    -> CodeSectionIndex;
+auto ReadCodeSectionIndex(KnownSection, Context&, Index first_index = 0)
+    -> CodeSectionIndex;
+
+}  // namespace wasp::binary
+
+#endif  // WASP_BINARY_CODE_SECTION_INDEX_H_
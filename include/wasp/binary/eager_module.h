@@ -0,0 +1,49 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef WASP_BINARY_EAGER_MODULE_H_
+#define WASP_BINARY_EAGER_MODULE_H_
+
+#include "wasp/base/span.h"
+#include "wasp/binary/types.h"
+
+namespace wasp {
+
+class Errors;
+class Features;
+
+}  // namespace wasp
+
+namespace wasp::binary {
+
+// Reads the entire module into a binary::Module in a single pass. Each
+// section's vector is reserved from the section's count before its items are
+// read, and each function body is collected in a reused scratch list and then
+// copied into an exactly-sized InstructionList.
+//
+// There is no arena: binary::Module uses std::vector with the default
+// allocator, so each vector owns its own allocation and they are freed one by
+// one by Module's destructor. Only the number of allocations is reduced.
+//
+// The result refers to the bytes of `data` (e.g. names and data segments), so
+// `data` must outlive it. Errors are reported to `errors`; reading continues in
+// the same way as visit::Visit, so the result may be partially filled.
+auto ReadModuleEager(SpanU8 data, const Features&, Errors&) -> Module;
+
+}  // namespace wasp::binary
+
+#endif  // WASP_BINARY_EAGER_MODULE_H_
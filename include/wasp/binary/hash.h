@@ -0,0 +1,78 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef WASP_BINARY_HASH_H_
+#define WASP_BINARY_HASH_H_
+
+#include <vector>
+
+#include "wasp/base/hash.h"
+#include "wasp/base/operator_eq_ne_macros.h"
+#include "wasp/base/span.h"
+#include "wasp/base/std_hash_macros.h"
+#include "wasp/base/string_view.h"
+#include "wasp/base/types.h"
+#include "wasp/binary/types.h"
+
+namespace wasp {
+
+class ThreadPool;
+
+namespace binary {
+
+class CodeSectionIndex;
+class LazyModule;
+
+struct SectionHash {
+  SectionId id;
+  string_view name;  // Only set for custom sections.
+  Hash128 hash;
+};
+
+// Hashes the contents of every section, in module order, on the threads of
+// `pool`. Known sections are seeded with their id, and custom sections with
+// the hash of their name.
+auto HashSections(LazyModule&, ThreadPool& pool) -> std::vector<SectionHash>;
+
+// Hashes every function body in `index` (its locals and instructions, but not
+// its length), on the threads of `pool`. Element `i` of the result is the
+// hash of function `index.first_index() + i`.
+auto HashFunctionBodies(const CodeSectionIndex&, ThreadPool& pool)
+    -> std::vector<Hash128>;
+
+// Combines section hashes into a module hash. Custom sections whose names are
+// in `ignored_custom_sections` are skipped, so that e.g. stripping the "name"
+// section doesn't change the hash.
+auto HashModule(const std::vector<SectionHash>&,
+                const std::vector<string_view>& ignored_custom_sections = {})
+    -> Hash128;
+auto HashModule(LazyModule&,
+                ThreadPool& pool,
+                const std::vector<string_view>& ignored_custom_sections = {})
+    -> Hash128;
+
+#define WASP_BINARY_HASH_STRUCTS(WASP_V) \
+  WASP_V(binary::SectionHash, 3, id, name, hash)
+
+WASP_BINARY_HASH_STRUCTS(WASP_DECLARE_OPERATOR_EQ_NE)
+
+}  // namespace binary
+}  // namespace wasp
+
+WASP_BINARY_HASH_STRUCTS(WASP_DECLARE_STD_HASH)
+
+#endif  // WASP_BINARY_HASH_H_
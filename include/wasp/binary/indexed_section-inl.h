@@ -0,0 +1,154 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <algorithm>
+
+#include "wasp/base/errors_nop.h"
+#include "wasp/base/thread_pool.h"
+#include "wasp/binary/read.h"
+#include "wasp/binary/read/context.h"
+
+namespace wasp::binary {
+
+template <typename T>
+IndexedSection<T>::IndexedSection(SpanU8 data, Context& context, Index stride)
+    : count{ReadCount(&data, context)},
+      data_{data},
+      features_{context.features},
+      stride_{std::max<Index>(stride, 1)} {
+  Build(context);
+}
+
+template <typename T>
+IndexedSection<T>::IndexedSection(const LazySection<T>& section,
+                                  Context& context,
+                                  Index stride)
+    : count{section.count},
+      data_{section.sequence.data()},
+      features_{context.features},
+      stride_{std::max<Index>(stride, 1)} {
+  Build(context);
+}
+
+template <typename T>
+void IndexedSection<T>::Build(const Context& outer_context) {
+  // Reading some elements updates the Context's counters (e.g. code_count),
+  // which must only change when the section is read in order. Use a copy, so
+  // the counts that EndModule checks are unaffected.
+  Context context = outer_context;
+  if (count) {
+    offsets_.reserve(*count / stride_ + 1);
+  }
+
+  bool same_size = true;
+  u32 first_size = 0;
+  SpanU8 rest = data_;
+  while (!rest.empty()) {
+    const u8* begin = rest.begin();
+    if (!Read<T>(&rest, context)) {
+      break;
+    }
+    auto offset = static_cast<u32>(begin - data_.begin());
+    auto size = static_cast<u32>(rest.begin() - begin);
+    if (size_ % stride_ == 0) {
+      offsets_.push_back(offset);
+    }
+    if (size_ == 0) {
+      first_size = size;
+    } else if (size != first_size) {
+      same_size = false;
+    }
+    ++size_;
+  }
+
+  if (size_ != 0 && same_size) {
+    element_size_ = first_size;
+    offsets_.clear();
+    offsets_.shrink_to_fit();
+  }
+
+  // Some elements (e.g. element segments with memory.init in their
+  // expressions) depend on the data count.
+  declared_data_count_ = context.declared_data_count;
+}
+
+template <typename T>
+SpanU8 IndexedSection<T>::DataAt(Index index) const {
+  size_t offset = is_fixed_size() ? size_t{index} * element_size_
+                                  : offsets_[index / stride_];
+  return data_.subspan(offset);
+}
+
+template <typename T>
+OptAt<T> IndexedSection<T>::operator[](Index index) const {
+  if (index >= size_) {
+    return nullopt;
+  }
+  ErrorsNop errors;
+  Context context{features_, errors};
+  context.declared_data_count = declared_data_count_;
+  SpanU8 data = DataAt(index);
+  if (!is_fixed_size()) {
+    for (Index skip = index % stride_; skip > 0; --skip) {
+      Read<T>(&data, context);
+    }
+  }
+  return Read<T>(&data, context);
+}
+
+template <typename T>
+void IndexedSection<T>::ReadRange(Index begin,
+                                  Index end,
+                                  const Callback& callback) const {
+  ErrorsNop errors;
+  Context context{features_, errors};
+  context.declared_data_count = declared_data_count_;
+  SpanU8 data = DataAt(begin);
+  if (!is_fixed_size()) {
+    for (Index skip = begin % stride_; skip > 0; --skip) {
+      Read<T>(&data, context);
+    }
+  }
+  for (Index index = begin; index < end; ++index) {
+    auto value = Read<T>(&data, context);
+    if (!value) {
+      break;
+    }
+    callback(index, *value);
+  }
+}
+
+template <typename T>
+void IndexedSection<T>::ForEachParallel(ThreadPool& pool,
+                                        const Callback& callback) const {
+  if (size_ == 0) {
+    return;
+  }
+
+  // Round the chunk size up to a multiple of the stride, so each chunk starts
+  // at a recorded offset.
+  constexpr Index kElementsPerChunk = 64;
+  const Index chunk_size =
+      is_fixed_size()
+          ? kElementsPerChunk
+          : (kElementsPerChunk + stride_ - 1) / stride_ * stride_;
+  pool.ParallelFor(size_, chunk_size, [&](unsigned, size_t begin, size_t end) {
+    ReadRange(static_cast<Index>(begin), static_cast<Index>(end), callback);
+  });
+}
+
+}  // namespace wasp::binary
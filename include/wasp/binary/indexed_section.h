@@ -0,0 +1,100 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef WASP_BINARY_INDEXED_SECTION_H_
+#define WASP_BINARY_INDEXED_SECTION_H_
+
+#include <functional>
+#include <vector>
+
+#include "wasp/base/at.h"
+#include "wasp/base/features.h"
+#include "wasp/base/optional.h"
+#include "wasp/base/span.h"
+#include "wasp/base/types.h"
+#include "wasp/binary/lazy_section.h"
+
+namespace wasp {
+
+class ThreadPool;
+
+namespace binary {
+
+struct Context;
+
+// Provides random access to the elements of a LazySection<T>.
+//
+// Construction makes a single pass over the section, and records where every
+// `stride`-th element starts. Reading element `k` then starts at the nearest
+// recorded offset and skips at most `stride - 1` elements. If every element
+// has the same encoded size (e.g. the function section, or a memory section
+// without max limits) no offsets are stored at all.
+//
+// Like CodeSectionIndex, entries after the first malformed one are not
+// indexed, and the elements are not checked against the section's count.
+template <typename T>
+class IndexedSection {
+ public:
+  using value_type = At<T>;
+  using Callback = std::function<void(Index, const At<T>&)>;
+
+  explicit IndexedSection(SpanU8, Context&, Index stride = 1);
+  explicit IndexedSection(const LazySection<T>&, Context&, Index stride = 1);
+
+  Index size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  Index stride() const { return stride_; }
+
+  // True if all elements have the same size, so no offsets are stored.
+  bool is_fixed_size() const { return element_size_ != 0; }
+
+  // Reads element `index`. Returns nullopt if `index` is out of range.
+  //
+  // Errors are not reported, since the element was already read successfully
+  // when the section was indexed. This does not modify the Context that was
+  // used to build the index, so it can be called from multiple threads.
+  OptAt<T> operator[](Index index) const;
+
+  // Calls `callback` with every element, on the threads of `pool`. Elements
+  // are handed out in contiguous chunks, so the callback may be called
+  // concurrently and out of order. Returns once all elements are visited.
+  void ForEachParallel(ThreadPool& pool, const Callback& callback) const;
+
+  OptAt<Index> count;
+
+ private:
+  void Build(const Context&);
+  SpanU8 DataAt(Index index) const;
+  void ReadRange(Index begin, Index end, const Callback&) const;
+
+  SpanU8 data_;
+  Features features_;
+  optional<Index> declared_data_count_;
+  Index stride_;
+  Index size_ = 0;
+  // The size of each element, if they all have the same size; otherwise 0.
+  u32 element_size_ = 0;
+  // The offset from the start of `data_` of every `stride_`-th element.
+  std::vector<u32> offsets_;
+};
+
+}  // namespace binary
+}  // namespace wasp
+
+#include "wasp/binary/indexed_section-inl.h"
+
+#endif  // WASP_BINARY_INDEXED_SECTION_H_
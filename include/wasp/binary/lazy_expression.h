@@ -17,6 +17,8 @@
 #ifndef WASP_BINARY_LAZY_EXPRESSION_H
 #define WASP_BINARY_LAZY_EXPRESSION_H
 
+#include "wasp/base/at.h"
+#include "wasp/base/optional.h"
 #include "wasp/base/span.h"
 #include "wasp/binary/lazy_sequence.h"
 #include "wasp/binary/types.h"
@@ -31,6 +33,29 @@ using LazyExpression = LazySequence<Instruction>;
 LazyExpression ReadExpression(SpanU8, Context&);
 LazyExpression ReadExpression(Expression, Context&);
 
+// An instruction whose immediates have not been decoded. `data` is the full
+// encoding of the instruction, and `immediate` is the part after the opcode.
+struct RawInstruction {
+  At<Opcode> opcode;
+  SpanU8 data;
+  SpanU8 immediate;
+};
+
+/// ---
+// Like LazyExpression, but only decodes opcodes. Immediates are skipped
+// without allocating, and can be decoded later with DecodeInstruction.
+using LazyRawExpression = LazySequence<RawInstruction>;
+
+LazyRawExpression ReadRawExpression(SpanU8, Context&);
+LazyRawExpression ReadRawExpression(Expression, Context&);
+
+auto Read(SpanU8*, Context&, Tag<RawInstruction>) -> OptAt<RawInstruction>;
+
+// Decodes the immediates of an instruction read from a LazyRawExpression.
+// Block structure was already checked when the instruction was read, so this
+// does not modify `context`.
+auto DecodeInstruction(const RawInstruction&, Context&) -> OptAt<Instruction>;
+
 }  // namespace wasp
 
 #endif  // WASP_BINARY_LAZY_EXPRESSION_H
@@ -25,6 +25,8 @@
 
 namespace wasp::binary {
 
+struct ModuleIndex;
+
 /// ---
 class LazyModule {
  public:
@@ -35,6 +37,11 @@ class LazyModule {
   optional<SpanU8> magic;
   optional<SpanU8> version;
   LazySequence<Section> sections;
+
+  // An optional index of the module, e.g. loaded with LoadModuleIndex. If
+  // set, the functions in lazy_module_utils.h use it instead of scanning the
+  // module. It is not owned, and must outlive the module.
+  const ModuleIndex* index = nullptr;
 };
 
 LazyModule ReadModule(SpanU8 data, const Features&, Errors&);
@@ -17,6 +17,7 @@
 #include <utility>
 
 #include "wasp/base/errors_nop.h"
+#include "wasp/binary/module_index.h"
 #include "wasp/binary/name_section/sections.h"
 #include "wasp/binary/read/context.h"
 #include "wasp/binary/sections.h"
@@ -29,7 +30,7 @@ void ForEachFunctionName(LazyModule& module, F&& f) {
   LazyModule copy{module.data, module.context.features, errors};
 
   Index imported_function_count = 0;
-  for (auto section : module.sections) {
+  for (auto section : copy.sections) {
     if (section->is_known()) {
       auto known = section->known();
       switch (known->id) {
@@ -77,6 +78,10 @@ Iterator CopyFunctionNames(LazyModule& module, Iterator out) {
 }
 
 inline Index GetImportCount(LazyModule& module, ExternalKind kind) {
+  if (module.index) {
+    return module.index->GetImportCount(kind);
+  }
+
   ErrorsNop errors;
   LazyModule copy{module.data, module.context.features, errors};
 
@@ -96,4 +101,32 @@ inline Index GetImportCount(LazyModule& module, ExternalKind kind) {
   return count;
 }
 
+inline auto ReadCodeSectionIndex(LazyModule& module)
+    -> optional<CodeSectionIndex> {
+  if (module.index) {
+    if (!module.index->code_section) {
+      return nullopt;
+    }
+    return CodeSectionIndex{GetRange(module.data, *module.index->code_section),
+                            module.context,
+                            GetImportCount(module, ExternalKind::Function),
+                            module.index->code_offsets};
+  }
+
+  ErrorsNop errors;
+  LazyModule copy{module.data, module.context.features, errors};
+
+  for (auto section : copy.sections) {
+    if (section->is_known()) {
+      auto known = section->known();
+      if (known->id == SectionId::Code) {
+        return ReadCodeSectionIndex(
+            known, module.context,
+            GetImportCount(module, ExternalKind::Function));
+      }
+    }
+  }
+  return nullopt;
+}
+
 }  // namespace wasp::binary
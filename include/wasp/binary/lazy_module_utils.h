@@ -20,6 +20,8 @@
 #include <utility>
 
 #include "wasp/base/features.h"
+#include "wasp/base/optional.h"
+#include "wasp/binary/code_section_index.h"
 #include "wasp/binary/lazy_module.h"
 #include "wasp/binary/types.h"
 
@@ -33,6 +35,9 @@ struct Context;
 
 using IndexNamePair = std::pair<Index, string_view>;
 
+// Calls `f` with every function name from the imports, exports and "name"
+// section, in module order. A function may be named more than once. This
+// always scans the module; ModuleIndex stores the same names sorted by index.
 template <typename F>
 void ForEachFunctionName(LazyModule&, F&&);
 
@@ -41,6 +46,10 @@ Iterator CopyFunctionNames(LazyModule&, Iterator out);
 
 Index GetImportCount(LazyModule&, ExternalKind);
 
+// Index the module's code section, so the body of any defined function can be
+// read by its function index. Returns nullopt if there is no code section.
+auto ReadCodeSectionIndex(LazyModule&) -> optional<CodeSectionIndex>;
+
 }  // namespace binary
 }  // namespace wasp
 
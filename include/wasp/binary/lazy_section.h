@@ -31,6 +31,11 @@ template <typename T>
 class LazySection {
  public:
   explicit LazySection(SpanU8, string_view name, Context&);
+  // Used when the count has already been read from the section.
+  explicit LazySection(OptAt<Index> count,
+                       SpanU8,
+                       string_view name,
+                       Context&);
 
   OptAt<Index> count;
   LazySequence<T> sequence;
@@ -40,6 +45,13 @@ template <typename T>
 LazySection<T>::LazySection(SpanU8 data, string_view name, Context& context)
     : count{ReadCount(&data, context)}, sequence{data, count, name, context} {}
 
+template <typename T>
+LazySection<T>::LazySection(OptAt<Index> count,
+                            SpanU8 data,
+                            string_view name,
+                            Context& context)
+    : count{count}, sequence{data, count, name, context} {}
+
 }  // namespace wasp::binary
 
 #endif // WASP_BINARY_LAZY_SECTION_H_
@@ -79,6 +79,9 @@ class LazySequence : public LazySequenceBase {
   const_iterator cbegin() const { return begin(); }
   const_iterator cend() const { return end(); }
 
+  // The unread bytes of the sequence, not including the count.
+  SpanU8 data() const { return data_; }
+
  private:
   template <typename Sequence>
   friend class LazySequenceIterator;
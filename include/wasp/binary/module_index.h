@@ -0,0 +1,124 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef WASP_BINARY_MODULE_INDEX_H_
+#define WASP_BINARY_MODULE_INDEX_H_
+
+#include <string>
+#include <vector>
+
+#include "wasp/base/buffer.h"
+#include "wasp/base/features.h"
+#include "wasp/base/optional.h"
+#include "wasp/base/span.h"
+#include "wasp/base/string_view.h"
+#include "wasp/base/types.h"
+#include "wasp/binary/types.h"
+
+namespace wasp {
+
+class Errors;
+
+namespace binary {
+
+// A summary of a module's layout, which can be saved next to the module as a
+// sidecar file (see GetModuleIndexFilename) so later runs don't have to
+// rescan the module.
+//
+// The index only stores offsets into the module; names are read directly from
+// the module's data. It is tied to the module by its size and a hash of its
+// section headers, which can be checked without reading the section contents.
+// It also stores a hash of the whole module, which VerifyModuleIndex checks.
+struct ModuleIndex {
+  // A range of bytes in the module, relative to its start.
+  struct Range {
+    u64 offset;
+    u32 size;
+  };
+
+  struct NameEntry {
+    Index index;
+    Range name;
+  };
+
+  Index GetImportCount(ExternalKind) const;
+
+  u64 module_size = 0;
+  u64 layout_hash = 0;
+  u64 content_hash = 0;
+  // The number of imports of each kind, indexed by ExternalKind.
+  std::vector<Index> import_counts;
+  // Function names from the imports, exports and "name" section (see
+  // ForEachFunctionName), sorted by index. The names of one function keep that
+  // order, so the first is the one that NameIndex returns.
+  std::vector<NameEntry> function_names;
+  // The code section data (including the count), and the offsets of its
+  // bodies, as given by CodeSectionIndex::offsets().
+  optional<Range> code_section;
+  std::vector<u32> code_offsets;
+};
+
+// A fast, non-cryptographic hash of the module's bytes (the low 64 bits of
+// HashBytes). Used to check that a sidecar index belongs to the module.
+auto HashModuleContents(SpanU8) -> u64;
+
+// A hash of the module's header and of each section's header (its id, size
+// and, for custom sections, name). Only the bytes of the headers are read.
+auto HashModuleLayout(SpanU8) -> u64;
+
+auto GetRange(SpanU8 module_data, ModuleIndex::Range) -> SpanU8;
+auto GetString(SpanU8 module_data, ModuleIndex::Range) -> string_view;
+
+// Scans the module and builds its index. Errors found while reading the
+// module are reported to `errors`.
+auto BuildModuleIndex(SpanU8 module_data, const Features&, Errors&)
+    -> ModuleIndex;
+
+// Serializes the index to its sidecar file format, a flat sequence of
+// little-endian fixed-size records.
+auto WriteModuleIndex(const ModuleIndex&) -> Buffer;
+
+// Reads a serialized index, copying its records into a ModuleIndex. Returns
+// nullopt if the data is malformed, was written by a different version of the
+// format, or does not match the size and layout hash of `module_data`.
+//
+// The contents of the sections are not checked, so an index for a module that
+// was changed without changing its layout is still accepted. Use
+// VerifyModuleIndex to check the whole module.
+auto ReadModuleIndex(SpanU8 index_data, SpanU8 module_data)
+    -> optional<ModuleIndex>;
+
+// Returns true if the index's size, layout hash and content hash all match
+// `module_data`. This reads the whole module.
+bool VerifyModuleIndex(const ModuleIndex&, SpanU8 module_data);
+
+// The sidecar filename for a module, e.g. "mod.wasm.waspidx".
+auto GetModuleIndexFilename(string_view module_filename) -> std::string;
+
+// Reads the sidecar index for `module_filename`, if it exists and matches
+// `module_data`.
+auto LoadModuleIndex(string_view module_filename, SpanU8 module_data)
+    -> optional<ModuleIndex>;
+
+// Writes the sidecar index for `module_filename`. Returns false if the file
+// could not be written.
+bool SaveModuleIndex(string_view module_filename, const ModuleIndex&);
+
+}  // namespace binary
+}  // namespace wasp
+
+#endif  // WASP_BINARY_MODULE_INDEX_H_
@@ -0,0 +1,104 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef WASP_BINARY_NAME_SECTION_NAME_INDEX_H_
+#define WASP_BINARY_NAME_SECTION_NAME_INDEX_H_
+
+#include <utility>
+#include <vector>
+
+#include "wasp/base/at.h"
+#include "wasp/base/features.h"
+#include "wasp/base/hashmap.h"
+#include "wasp/base/optional.h"
+#include "wasp/base/span.h"
+#include "wasp/base/string_view.h"
+#include "wasp/base/types.h"
+
+namespace wasp::binary {
+
+class LazyModule;
+struct Context;
+struct ModuleIndex;
+
+// Looks up function and local names, without copying the "name" section.
+//
+// Function names come from imports, exports and the "name" section, in that
+// order of precedence. Entries of the "name" section's function and local
+// names subsections are sorted by index, so only every 16th entry's index and
+// offset is stored; a lookup binary searches those, then reads at most 16
+// entries. Local names of a function are only read when they are looked up.
+//
+// If the module has a ModuleIndex attached, function names are looked up in
+// its sorted table instead, and the imports, exports and function names
+// subsection are not read at all. The ModuleIndex must outlive the NameIndex.
+//
+// If a subsection isn't sorted, lookups fall back to a linear scan. Lookups
+// do not report errors and don't modify the index, so they can be called from
+// multiple threads.
+class NameIndex {
+ public:
+  NameIndex() = default;
+  explicit NameIndex(LazyModule&);
+
+  optional<string_view> GetFunctionName(Index function) const;
+  optional<string_view> GetLocalName(Index function, Index local) const;
+
+  // Returns the lowest index of a function that has `name` as one of its
+  // names. This scans every function name, unless BuildFunctionNameMap has
+  // been called.
+  optional<Index> FindFunction(string_view name) const;
+
+  // Builds a hash map from function name to index, for callers that look up
+  // many names.
+  void BuildFunctionNameMap();
+
+ private:
+  using ReadEntryIndexFn = OptAt<Index> (*)(SpanU8*, Context&);
+
+  // The entries of a function names or local names subsection.
+  struct Entries {
+    SpanU8 data;
+    // The index and offset from the start of `data` of every 16th entry.
+    std::vector<std::pair<Index, u32>> samples;
+    bool sorted = true;
+  };
+
+  void Build(Entries&, SpanU8 data, ReadEntryIndexFn, Context&);
+  // Returns the data starting at the entry for `index`.
+  optional<SpanU8> Find(const Entries&, Index index, ReadEntryIndexFn) const;
+  // Calls `f` with the index and name of every function name.
+  template <typename F>
+  void ForEachFunctionName(F&& f) const;
+
+  Features features_;
+  // The module's sidecar index, if any, and the module data its ranges refer
+  // to.
+  const ModuleIndex* module_index_ = nullptr;
+  SpanU8 module_data_;
+  // Function names from imports and exports, in module order.
+  std::vector<std::pair<Index, string_view>> external_names_;
+  flat_hash_map<Index, string_view> external_name_map_;
+  Entries function_names_;
+  Entries local_names_;
+  flat_hash_map<string_view, Index> function_name_map_;
+  bool has_function_name_map_ = false;
+};
+
+}  // namespace wasp::binary
+
+#endif  // WASP_BINARY_NAME_SECTION_NAME_INDEX_H_
@@ -0,0 +1,202 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef WASP_BINARY_PACKED_INSTRUCTION_STREAM_H_
+#define WASP_BINARY_PACKED_INSTRUCTION_STREAM_H_
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+#include "wasp/base/at.h"
+#include "wasp/base/span.h"
+#include "wasp/base/types.h"
+#include "wasp/base/wasm_types.h"
+#include "wasp/binary/types.h"
+
+namespace wasp::binary {
+
+struct Context;
+class PackedInstructionStream;
+
+// A lightweight view of one instruction in a PackedInstructionStream. It is
+// only valid while the stream it came from is alive and unmodified.
+//
+// The immediate accessors have the same names as Instruction's, but decode only
+// the one immediate and return it by value. The instruction must have an
+// immediate of that kind.
+class PackedInstruction {
+ public:
+  auto opcode() const -> At<Opcode>;
+
+  // The bytes of this instruction in the stream's source. These are recorded
+  // by ReadPackedInstructionStream even when At<T> does not store locations.
+  auto data() const -> SpanU8;
+  auto loc() const -> Location;
+
+  // The index of the immediate's alternative in Instruction::immediate.
+  u32 immediate_kind() const;
+
+  bool has_no_immediate() const;
+  bool has_index_immediate() const;
+  bool has_br_table_immediate() const;
+
+  auto s32_immediate() const -> At<s32>;
+  auto s64_immediate() const -> At<s64>;
+  auto f32_immediate() const -> At<f32>;
+  auto f64_immediate() const -> At<f64>;
+  auto v128_immediate() const -> At<v128>;
+  auto index_immediate() const -> At<Index>;
+  auto block_type_immediate() const -> At<BlockType>;
+  auto br_on_cast_immediate() const -> At<BrOnCastImmediate>;
+  auto br_on_exn_immediate() const -> At<BrOnExnImmediate>;
+  auto br_table_immediate() const -> At<BrTableImmediate>;
+  auto call_indirect_immediate() const -> At<CallIndirectImmediate>;
+  auto copy_immediate() const -> At<CopyImmediate>;
+  auto heap_type_immediate() const -> At<HeapType>;
+  auto heap_type_2_immediate() const -> At<HeapType2Immediate>;
+  auto init_immediate() const -> At<InitImmediate>;
+  auto let_immediate() const -> At<LetImmediate>;
+  auto mem_arg_immediate() const -> At<MemArgImmediate>;
+  auto rtt_sub_immediate() const -> At<RttSubImmediate>;
+  auto select_immediate() const -> At<SelectImmediate>;
+  auto shuffle_immediate() const -> At<ShuffleImmediate>;
+  auto simd_lane_immediate() const -> At<SimdLaneImmediate>;
+  auto struct_field_immediate() const -> At<StructFieldImmediate>;
+
+  // A view of the br_table targets, without their locations. No copy is made.
+  auto br_table_targets() const -> span<const Index>;
+  auto br_table_default_target() const -> At<Index>;
+
+  // Decodes the full instruction, including the locations of all immediates.
+  auto ToInstruction() const -> At<Instruction>;
+
+ private:
+  friend class PackedInstructionStream;
+
+  explicit PackedInstruction(const PackedInstructionStream*, const u32* record);
+
+  template <typename T>
+  auto GetImmediate() const -> At<T>;
+
+  const PackedInstructionStream* stream_;
+  const u32* record_;
+};
+
+// Stores a sequence of instructions in a single contiguous buffer of 32-bit
+// words, instead of as a list of separately-allocated Instruction variants.
+// Each instruction is encoded as its opcode and immediate kind, followed by
+// its immediate in a flat form. Instructions can be iterated, or accessed by
+// index.
+//
+// Locations are stored as offsets into `source`; locations that are not
+// within `source` are dropped.
+class PackedInstructionStream {
+ public:
+  class iterator;
+
+  explicit PackedInstructionStream(SpanU8 source = {});
+
+  SpanU8 source() const { return source_; }
+
+  Index size() const { return static_cast<Index>(offsets_.size()); }
+  bool empty() const { return offsets_.empty(); }
+  // The size of the encoded instructions, in bytes.
+  size_t byte_size() const { return words_.size() * sizeof(u32); }
+
+  void clear();
+  void Append(const At<Instruction>&);
+
+  PackedInstruction operator[](Index) const;
+
+  iterator begin() const;
+  iterator end() const;
+
+ private:
+  friend class PackedInstruction;
+  friend auto ReadPackedInstructionStream(SpanU8, Context&)
+      -> PackedInstructionStream;
+
+  struct ReadPolicy;
+
+  // Appends an instruction with at most one immediate. `data` is the
+  // instruction's location.
+  template <typename... Ts>
+  void AppendRecord(Location data,
+                    const At<Opcode>& opcode,
+                    const Ts&... immediate);
+
+  SpanU8 source_;
+  std::vector<u32> words_;
+  // The offset of each instruction in `words_`.
+  std::vector<u32> offsets_;
+};
+
+class PackedInstructionStream::iterator {
+ public:
+  using difference_type = std::ptrdiff_t;
+  using value_type = PackedInstruction;
+  using pointer = void;
+  using reference = PackedInstruction;
+  using iterator_category = std::input_iterator_tag;
+
+  iterator() = default;
+
+  Index index() const { return index_; }
+
+  PackedInstruction operator*() const { return (*stream_)[index_]; }
+
+  iterator& operator++() {
+    ++index_;
+    return *this;
+  }
+
+  iterator operator++(int) {
+    auto temp = *this;
+    ++index_;
+    return temp;
+  }
+
+  friend bool operator==(const iterator& lhs, const iterator& rhs) {
+    return lhs.stream_ == rhs.stream_ && lhs.index_ == rhs.index_;
+  }
+
+  friend bool operator!=(const iterator& lhs, const iterator& rhs) {
+    return !(lhs == rhs);
+  }
+
+ private:
+  friend class PackedInstructionStream;
+
+  explicit iterator(const PackedInstructionStream* stream, Index index)
+      : stream_{stream}, index_{index} {}
+
+  const PackedInstructionStream* stream_ = nullptr;
+  Index index_ = 0;
+};
+
+// Reads all instructions of `data` directly into a PackedInstructionStream,
+// without creating an Instruction for each. Reading stops at the first
+// malformed instruction, as with LazyExpression.
+auto ReadPackedInstructionStream(SpanU8 data, Context&)
+    -> PackedInstructionStream;
+auto ReadPackedInstructionStream(Expression, Context&)
+    -> PackedInstructionStream;
+
+}  // namespace wasp::binary
+
+#endif  // WASP_BINARY_PACKED_INSTRUCTION_STREAM_H_
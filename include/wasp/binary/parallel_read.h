@@ -0,0 +1,72 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef WASP_BINARY_PARALLEL_READ_H_
+#define WASP_BINARY_PARALLEL_READ_H_
+
+#include <functional>
+#include <vector>
+
+#include "wasp/base/at.h"
+#include "wasp/base/optional.h"
+#include "wasp/base/types.h"
+#include "wasp/binary/types.h"
+
+namespace wasp {
+
+class ThreadPool;
+
+namespace binary {
+
+class CodeSectionIndex;
+struct Context;
+
+// The result of decoding one function body.
+struct FunctionBody {
+  Index index;  // Function index, including imported functions.
+  OptAt<Code> code;
+  InstructionList instructions;
+  bool ok = false;  // True if no errors were found while decoding.
+};
+
+using FunctionBodyCallback = std::function<void(FunctionBody&)>;
+
+// Decodes every function body in `index` on the threads of `pool`.
+//
+// Each body is decoded with its own function-level Context, so the bodies
+// can be read independently. It is given the features and declared data
+// count of `context`. The callback is always called on the calling
+// thread, in function order, as soon as each body (and all bodies before it)
+// have been decoded. Errors are collected per function and reported to
+// `context.errors` in the same order, just before the callback for that
+// function is called.
+//
+// After returning, `context.code_count` is incremented by the number of
+// bodies, as if the code section had been read sequentially.
+void ForEachFunctionBodyParallel(const CodeSectionIndex& index,
+                                 Context& context,
+                                 ThreadPool& pool,
+                                 const FunctionBodyCallback&);
+
+auto ReadFunctionBodiesParallel(const CodeSectionIndex& index,
+                                Context& context,
+                                ThreadPool& pool) -> std::vector<FunctionBody>;
+
+}  // namespace binary
+}  // namespace wasp
+
+#endif  // WASP_BINARY_PARALLEL_READ_H_
@@ -144,9 +144,15 @@ auto Read(SpanU8*, Context&, Tag<u8>) -> OptAt<u8>;
 auto Read(SpanU8*, Context&, Tag<v128>) -> OptAt<v128>;
 auto Read(SpanU8*, Context&, Tag<ValueType>) -> OptAt<ValueType>;
 
+// Reports an error if a known section with this id may not occur after the
+// previous known section, and records it as the last section id.
+bool CheckSectionOrder(At<SectionId>, Context&);
 bool EndCode(SpanU8, Context&);
 bool EndModule(SpanU8, Context&);
 
+// Reports an error if `opcode` is used without a data count section.
+bool RequireDataCountSection(Context&, const At<Opcode>& opcode);
+
 }  // namespace wasp::binary
 
 #endif  // WASP_BINARY_READ_H_
@@ -30,6 +30,7 @@
 #include "wasp/base/types.h"
 #include "wasp/binary/read.h"
 #include "wasp/binary/read/context.h"
+#include "wasp/binary/read/location_guard.h"
 #include "wasp/binary/read/macros.h"
 #include "wasp/binary/var_int.h"
 
@@ -43,8 +44,11 @@ S SignExtend(std::make_unsigned_t<S> x, int N) {
   return static_cast<S>(x << (kNumBits - N - 1)) >> (kNumBits - N - 1);
 }
 
+// Decode a LEB128 value one byte at a time. This handles all malformed input
+// and reports errors; ReadVarInt only falls back to it when the fast paths
+// can't be used.
 template <typename T>
-OptAt<T> ReadVarInt(SpanU8* data, Context& context, string_view desc) {
+OptAt<T> ReadVarIntSlow(SpanU8* data, Context& context, string_view desc) {
   using U = std::make_unsigned_t<T>;
   constexpr bool is_signed = std::is_signed_v<T>;
   constexpr int kByteMask = VarInt<T>::kByteMask;
@@ -92,6 +96,96 @@ OptAt<T> ReadVarInt(SpanU8* data, Context& context, string_view desc) {
   }
 }
 
+
+// Decode a LEB128 value that is fully contained in the 8 bytes at `data`,
+// without reporting any errors. Returns the number of bytes used, or 0 if the
+// value is longer than 8 bytes or is malformed.
+template <typename T>
+int DecodeVarIntFast(const u8* data, T* out) {
+  using U = std::make_unsigned_t<T>;
+  constexpr bool is_signed = std::is_signed_v<T>;
+  constexpr int kLastByteMaskBits =
+      VarInt<T>::kUsedBitsInLastByte - (is_signed ? 1 : 0);
+  constexpr u8 kLastByteMask = ~((1 << kLastByteMaskBits) - 1);
+  constexpr u8 kLastByteOnes = kLastByteMask & VarInt<T>::kByteMask;
+  constexpr u64 kExtendBits = 0x8080808080808080ull;
+  constexpr u64 kByteMasks = 0x7f7f7f7f7f7f7f7full;
+  constexpr u64 kLowBits = 0x0101010101010101ull;
+
+  // Compilers turn this into a single (little-endian) load.
+  u64 word = 0;
+  for (int i = 0; i < 8; ++i) {
+    word |= u64{data[i]} << (i * 8);
+  }
+
+  // The high bit of each byte that ends the value.
+  const u64 ends = ~word & kExtendBits;
+  if (ends == 0) {
+    return 0;
+  }
+
+  // Keep all bits up to, and including, the first terminating byte.
+  const u64 keep = ends ^ (ends - 1);
+  const int length = static_cast<int>(((keep & kLowBits) * kLowBits) >> 56);
+  if (length > VarInt<T>::kMaxBytes) {
+    return 0;
+  } else if (length == VarInt<T>::kMaxBytes) {
+    const u8 last = data[length - 1];
+    if (!((last & kLastByteMask) == 0 ||
+          (is_signed && (last & kLastByteMask) == kLastByteOnes))) {
+      return 0;
+    }
+  }
+
+  // Pack the 7-bit groups together.
+  const u64 x = word & keep & kByteMasks;
+  const u64 packed = (x & 0x7full) |
+                     ((x >> 1) & (0x7full << 7)) |
+                     ((x >> 2) & (0x7full << 14)) |
+                     ((x >> 3) & (0x7full << 21)) |
+                     ((x >> 4) & (0x7full << 28)) |
+                     ((x >> 5) & (0x7full << 35)) |
+                     ((x >> 6) & (0x7full << 42)) |
+                     ((x >> 7) & (0x7full << 49));
+
+  const U result = static_cast<U>(packed);
+  if (is_signed && length < VarInt<T>::kMaxBytes) {
+    *out = SignExtend<T>(result, length * 7 - 1);
+  } else {
+    *out = T(result);
+  }
+  return length;
+}
+
+template <typename T>
+OptAt<T> ReadVarInt(SpanU8* data, Context& context, string_view desc) {
+  constexpr bool is_signed = std::is_signed_v<T>;
+
+  if (!data->empty()) {
+    const u8* start = data->data();
+
+    // Fast path for one-byte values, which are most indexes and immediates.
+    if ((start[0] & VarInt<T>::kExtendBit) == 0) {
+      const T value = is_signed ? SignExtend<T>(start[0], 6) : T(start[0]);
+      remove_prefix(data, 1);
+      return At{Location{start, 1}, value};
+    }
+
+    // Fast path for multi-byte values, when there are enough bytes to read a
+    // full word.
+    if (data->size() >= 8) {
+      T value;
+      if (int length = DecodeVarIntFast<T>(start, &value)) {
+        remove_prefix(data, length);
+        return At{Location{start, static_cast<span_extent_t>(length)}, value};
+      }
+    }
+  }
+
+  // Near the end of the buffer, or on malformed input.
+  return ReadVarIntSlow<T>(data, context, desc);
+}
+
 }  // namespace wasp::binary
 
 #endif  // WASP_BINARY_READ_READ_VAR_INT_H_
@@ -45,6 +45,30 @@ optional<std::vector<At<T>>> ReadVector(SpanU8* data,
   return result;
 }
 
+// Like ReadVector, but passes each element to `f` instead of storing it.
+// Returns the number of elements.
+template <typename T, typename F>
+optional<u32> ReadVectorElements(SpanU8* data,
+                                 Context& context,
+                                 string_view desc,
+                                 F&& f) {
+  ErrorsContextGuard guard{context.errors, *data, desc};
+  WASP_TRY_READ(len, ReadCount(data, context));
+  for (u32 i = 0; i < len; ++i) {
+    WASP_TRY_READ(elt, Read<T>(data, context));
+    f(elt);
+  }
+  return len.value();
+}
+
+// Like ReadVector, but only checks the elements and advances past them,
+// without storing them.
+template <typename T>
+bool SkipVector(SpanU8* data, Context& context, string_view desc) {
+  return ReadVectorElements<T>(data, context, desc, [](const At<T>&) {})
+      .has_value();
+}
+
 }  // namespace wasp::binary
 
 #endif  // WASP_BINARY_READ_READ_VECTOR_H_
@@ -0,0 +1,73 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef WASP_BINARY_SECTION_DIRECTORY_H_
+#define WASP_BINARY_SECTION_DIRECTORY_H_
+
+#include <vector>
+
+#include "wasp/base/at.h"
+#include "wasp/base/hashmap.h"
+#include "wasp/base/optional.h"
+#include "wasp/base/string_view.h"
+#include "wasp/base/types.h"
+#include "wasp/binary/types.h"
+
+namespace wasp::binary {
+
+class LazyModule;
+
+// A directory of a module's sections, for looking up known sections by id
+// and custom sections by name.
+//
+// Construction makes a single pass over the module that only reads each
+// section's id, length and (for custom sections) name. Errors are reported
+// to the module's context, as they would be when iterating module.sections.
+class SectionDirectory {
+ public:
+  explicit SectionDirectory(LazyModule&);
+
+  // All sections, in module order. The index of a section in this vector is
+  // its section index.
+  const std::vector<At<Section>>& sections() const { return sections_; }
+  Index size() const { return static_cast<Index>(sections_.size()); }
+  bool empty() const { return sections_.empty(); }
+
+  // Returns the section index of the known section `id`, or the first custom
+  // section named `name`.
+  optional<Index> FindIndex(SectionId id) const;
+  optional<Index> FindCustomIndex(string_view name) const;
+
+  OptAt<KnownSection> Find(SectionId) const;
+  OptAt<CustomSection> FindCustom(string_view name) const;
+
+  // Returns all custom sections whose names start with `prefix` (e.g.
+  // "reloc." or ".debug_"), in module order.
+  std::vector<At<CustomSection>> FindAllCustom(string_view prefix) const;
+
+ private:
+  std::vector<At<Section>> sections_;
+  std::vector<Index> custom_sections_;
+  flat_hash_map<SectionId, Index> known_;
+  flat_hash_map<string_view, Index> custom_;
+};
+
+auto ReadSectionDirectory(LazyModule&) -> SectionDirectory;
+
+}  // namespace wasp::binary
+
+#endif  // WASP_BINARY_SECTION_DIRECTORY_H_
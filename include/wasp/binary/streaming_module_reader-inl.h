@@ -0,0 +1,275 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <algorithm>
+
+#include "wasp/base/at.h"
+#include "wasp/base/concat.h"
+#include "wasp/base/errors.h"
+#include "wasp/binary/read.h"
+#include "wasp/binary/read/context.h"
+
+namespace wasp::binary {
+
+template <typename Visitor>
+StreamingModuleReader<Visitor>::StreamingModuleReader(
+    Visitor& visitor,
+    const Features& features,
+    Errors& errors)
+    : visitor_{visitor}, features_{features}, errors_{errors} {}
+
+template <typename Visitor>
+visit::Result StreamingModuleReader<Visitor>::Push(SpanU8 chunk) {
+  if (state_ == State::Done) {
+    return result_;
+  }
+  BeginChunk(chunk);
+  auto result = Process(false);
+  EndChunk();
+  return result;
+}
+
+template <typename Visitor>
+visit::Result StreamingModuleReader<Visitor>::Finish() {
+  if (state_ == State::Done) {
+    return result_;
+  }
+  return Process(true);
+}
+
+template <typename Visitor>
+visit::Result StreamingModuleReader<Visitor>::Stop(visit::Result result) {
+  state_ = State::Done;
+  result_ = result;
+  return result;
+}
+
+template <typename Visitor>
+visit::Result StreamingModuleReader<Visitor>::Process(bool final) {
+  using visit::Result;
+
+  for (;;) {
+    SpanU8 data = pending();
+    // The pending bytes may be in the chunk or in the buffer, and the header
+    // and code count are copied into the reader, so each of them is used as
+    // the LocationBase while locations that refer to it are alive.
+    LocationBase location_base{data};
+    switch (state_) {
+      case State::Header: {
+        if (data.size() < kHeaderSize && !final) {
+          return Result::Ok;
+        }
+        size_t size = std::min(data.size(), kHeaderSize);
+        std::copy_n(data.begin(), size, header_.begin());
+        Consume(size);
+        LocationBase header_base{header_.data()};
+        module_.emplace(SpanU8{header_.data(), size}, features_, errors_);
+        if (!module_->magic || !module_->version) {
+          return Stop(Result::Fail);
+        }
+        auto result = visitor_.BeginModule(*module_);
+        if (result != Result::Ok) {
+          return Stop(result);
+        }
+        state_ = State::SectionHeader;
+        break;
+      }
+
+      case State::SectionHeader: {
+        if (data.empty()) {
+          if (!final) {
+            return Result::Ok;
+          }
+          EndModule(data, context());
+          LocationBase header_base{header_.data()};
+          return Stop(visitor_.EndModule(*module_));
+        }
+
+        u32 id, length;
+        size_t id_size, length_size;
+        auto peek = PeekU32(data, &id, &id_size);
+        if (peek == PeekResult::Ok) {
+          peek = PeekU32(data.subspan(id_size), &length, &length_size);
+        }
+        if (peek == PeekResult::NeedMore && !final) {
+          return Result::Ok;
+        }
+        if (peek != PeekResult::Ok) {
+          // Read the section anyway, to report the error.
+          Read<Section>(&data, context());
+          return Stop(Result::Fail);
+        }
+
+        size_t header_size = id_size + length_size;
+        if (id != static_cast<u32>(SectionId::Code)) {
+          section_size_ = header_size + length;
+          state_ = State::Section;
+          break;
+        }
+
+        // The code section is visited one function body at a time.
+        SpanU8 header = data.first(header_size);
+        auto section_id = Read<SectionId>(&data, context());
+        CheckSectionOrder(*section_id, context());
+        Consume(header_size);
+
+        At<Section> section{
+            header, Section{At{header, KnownSection{*section_id, SpanU8{}}}}};
+        auto result = visitor_.OnSection(section);
+        if (result == Result::Fail) {
+          return Stop(Result::Fail);
+        }
+        remaining_ = length;
+        state_ = result == Result::Skip ? State::Skip : State::CodeCount;
+        break;
+      }
+
+      case State::Section: {
+        if (data.size() < section_size_ && !final) {
+          return Result::Ok;
+        }
+        auto section = Read<Section>(&data, context());
+        if (!section) {
+          return Stop(Result::Fail);
+        }
+        Consume(section_size_);
+        if (visit::VisitSection(*section, context(), visitor_) ==
+            Result::Fail) {
+          return Stop(Result::Fail);
+        }
+        state_ = State::SectionHeader;
+        break;
+      }
+
+      case State::CodeCount: {
+        SpanU8 available = data.first(std::min(data.size(), remaining_));
+        u32 value;
+        size_t size;
+        auto peek = PeekU32(available, &value, &size);
+        if (peek == PeekResult::NeedMore && available.size() < remaining_ &&
+            !final) {
+          return Result::Ok;
+        }
+        if (peek != PeekResult::Ok) {
+          size = std::min(available.size(), code_count_data_.size());
+        }
+
+        // Copy the count, since the code section refers to it.
+        std::copy_n(available.begin(), size, code_count_data_.begin());
+        LocationBase count_base{code_count_data_.data()};
+        SpanU8 count_data{code_count_data_.data(), size};
+        auto count = ReadIndex(&count_data, context(), "count");
+        if (!count) {
+          return Stop(Result::Fail);
+        }
+        Consume(size);
+        remaining_ -= size;
+
+        // There should be at least one byte per count.
+        if (count->value() > remaining_) {
+          context().errors.OnError(
+              count->loc(), concat("Count extends past end: ", count->value(),
+                                   " > ", remaining_));
+          return Stop(Result::Fail);
+        }
+
+        code_section_.emplace(count, SpanU8{}, "code section", context());
+        code_read_ = 0;
+        auto result = visitor_.BeginCodeSection(*code_section_);
+        if (result == Result::Fail) {
+          return Stop(Result::Fail);
+        } else if (result == Result::Skip) {
+          // If skipping this section, increment by the number of code items
+          // specified in this section.
+          context().code_count += count->value();
+          state_ = State::Skip;
+        } else {
+          state_ = State::CodeBody;
+        }
+        break;
+      }
+
+      case State::CodeBody: {
+        Index count = code_section_->count->value();
+        if (remaining_ > 0) {
+          SpanU8 available = data.first(std::min(data.size(), remaining_));
+          u32 length;
+          size_t length_size;
+          auto peek = PeekU32(available, &length, &length_size);
+          if (peek == PeekResult::NeedMore && available.size() < remaining_ &&
+              !final) {
+            return Result::Ok;
+          }
+          size_t size = peek == PeekResult::Ok
+                            ? std::min(length_size + length, remaining_)
+                            : available.size();
+          if (available.size() < size && !final) {
+            return Result::Ok;
+          }
+
+          SpanU8 code_data = available.first(std::min(available.size(), size));
+          auto code = Read<Code>(&code_data, context());
+          if (code) {
+            ++code_read_;
+            if (visit::VisitCode(*code, context(), visitor_) == Result::Fail) {
+              return Stop(Result::Fail);
+            }
+            Consume(size);
+            remaining_ -= size;
+            break;
+          }
+          // The rest of the section can't be read, so skip it.
+          state_ = State::Skip;
+        } else {
+          state_ = State::SectionHeader;
+        }
+
+        if (code_read_ != count) {
+          context().errors.OnError(
+              data.first(0), concat("Expected code section to have count ",
+                                    count, ", got ", code_read_));
+        }
+        LocationBase count_base{code_count_data_.data()};
+        if (visitor_.EndCodeSection(*code_section_) == Result::Fail) {
+          return Stop(Result::Fail);
+        }
+        break;
+      }
+
+      case State::Skip: {
+        size_t size = std::min(data.size(), remaining_);
+        Consume(size);
+        remaining_ -= size;
+        if (remaining_ > 0) {
+          if (!final) {
+            return Result::Ok;
+          }
+          context().errors.OnError(
+              data, concat("Unable to read ", remaining_ + size, " bytes"));
+          return Stop(Result::Fail);
+        }
+        state_ = State::SectionHeader;
+        break;
+      }
+
+      case State::Done:
+        return result_;
+    }
+  }
+}
+
+}  // namespace wasp::binary
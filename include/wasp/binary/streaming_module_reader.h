@@ -0,0 +1,138 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef WASP_BINARY_STREAMING_MODULE_READER_H_
+#define WASP_BINARY_STREAMING_MODULE_READER_H_
+
+#include <array>
+#include <vector>
+
+#include "wasp/base/features.h"
+#include "wasp/base/optional.h"
+#include "wasp/base/span.h"
+#include "wasp/base/types.h"
+#include "wasp/binary/lazy_module.h"
+#include "wasp/binary/sections.h"
+#include "wasp/binary/visitor.h"
+
+namespace wasp {
+
+class Errors;
+
+namespace binary {
+
+// Buffer management shared by all StreamingModuleReader instantiations.
+class StreamingModuleReaderBase {
+ protected:
+  enum class PeekResult { Ok, NeedMore, Malformed };
+
+  // Starts processing `chunk`. If there are no pending bytes, the chunk is
+  // used directly, otherwise it is appended to the pending bytes.
+  void BeginChunk(SpanU8 chunk);
+  // Copies any bytes that have not been consumed into the buffer, so they
+  // remain available for the next chunk.
+  void EndChunk();
+
+  SpanU8 pending() const { return pending_; }
+  void Consume(size_t);
+
+  // Decodes the LEB128-encoded u32 at the start of `data` without reporting
+  // errors.
+  static PeekResult PeekU32(SpanU8 data, u32* out_value, size_t* out_size);
+
+ private:
+  std::vector<u8> buffer_;
+  SpanU8 pending_;
+  bool pending_in_buffer_ = false;
+};
+
+// Reads a module as it arrives, one chunk at a time, and calls the same
+// callbacks as visit::Visit as soon as enough data is available.
+//
+// Known and custom sections are buffered until they are complete, then
+// visited as a whole. The code section is not buffered; each function body is
+// visited (BeginCode, OnInstruction, EndCode) as soon as it has arrived, so
+// only the incomplete tail of the data is kept between calls to Push.
+//
+// Since the code section is not available as a whole, the Section passed to
+// OnSection and the LazyCodeSection passed to Begin/EndCodeSection have no
+// contents, apart from the section id and count. Similarly, the LazyModule
+// passed to BeginModule and EndModule only contains the magic and version.
+//
+// All Locations refer to memory owned by the reader or by the chunk passed to
+// Push, so they are only valid until Push returns.
+template <typename Visitor>
+class StreamingModuleReader : public StreamingModuleReaderBase {
+ public:
+  explicit StreamingModuleReader(Visitor&, const Features&, Errors&);
+  StreamingModuleReader(const StreamingModuleReader&) = delete;
+  StreamingModuleReader& operator=(const StreamingModuleReader&) = delete;
+
+  // Returns Fail if the visitor failed or the module is malformed. After that,
+  // no more callbacks are made, and Push and Finish return the same result.
+  visit::Result Push(SpanU8 chunk);
+
+  // Must be called after the last chunk has been pushed. Reports an error if
+  // the module is incomplete, then calls EndModule.
+  visit::Result Finish();
+
+  bool done() const { return state_ == State::Done; }
+
+ private:
+  enum class State {
+    Header,
+    SectionHeader,
+    Section,
+    CodeCount,
+    CodeBody,
+    Skip,
+    Done,
+  };
+
+  static constexpr size_t kHeaderSize = 8;
+
+  visit::Result Process(bool final);
+  visit::Result Stop(visit::Result);
+  auto context() -> Context& { return module_->context; }
+
+  Visitor& visitor_;
+  Features features_;
+  Errors& errors_;
+  State state_ = State::Header;
+  visit::Result result_ = visit::Result::Ok;
+
+  // The magic and version, which the module refers to.
+  std::array<u8, kHeaderSize> header_;
+  optional<LazyModule> module_;
+
+  // The size of the section being buffered, including its id and length.
+  size_t section_size_ = 0;
+  // The number of bytes remaining in the code section, or to skip.
+  size_t remaining_ = 0;
+
+  // The code section count, which the code section refers to.
+  std::array<u8, 5> code_count_data_;
+  optional<LazyCodeSection> code_section_;
+  Index code_read_ = 0;
+};
+
+}  // namespace binary
+}  // namespace wasp
+
+#include "wasp/binary/streaming_module_reader-inl.h"
+
+#endif  // WASP_BINARY_STREAMING_MODULE_READER_H_
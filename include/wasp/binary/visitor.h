@@ -17,8 +17,13 @@
 #ifndef WASP_BINARY_VISITOR_H_
 #define WASP_BINARY_VISITOR_H_
 
+#include <type_traits>
+#include <utility>
+
+#include "wasp/base/recording_errors.h"
 #include "wasp/binary/lazy_expression.h"
 #include "wasp/binary/lazy_module.h"
+#include "wasp/binary/read/context.h"
 #include "wasp/binary/sections.h"
 
 namespace wasp::binary::visit {
@@ -120,9 +125,89 @@ struct SkipVisitor : Visitor {
   Result BeginDataSection(LazyDataSection) { return Result::Skip; }
 };
 
+// Visitors that derive from DecodeAllVisitor have every section decoded, even
+// those they do not observe. This is how a module is checked for being
+// well-formed.
+struct DecodeAllVisitor : Visitor {};
+
+// A visitor may also implement
+//
+//   Result OnInstructions(span<const At<Instruction>>);
+//
+// to receive the instructions of each function body in batches of at most
+// kInstructionBatchSize, instead of one OnInstruction call per instruction.
+// If it is implemented, OnInstruction is not called.
+//
+// Errors are reported in the same order as with OnInstruction: an error
+// found while reading an instruction is reported only after the
+// instructions before it have been visited, and not at all if the visitor
+// fails first. If the visitor fails, the function-level state of the Context
+// (e.g. open_blocks) may include instructions after the one that failed.
+constexpr size_t kInstructionBatchSize = 1024;
+
+template <typename V, typename = void>
+struct HasOnInstructions : std::false_type {};
+
+template <typename V>
+struct HasOnInstructions<
+    V,
+    std::void_t<decltype(std::declval<V&>().OnInstructions(
+        std::declval<span<const At<Instruction>>>()))>> : std::true_type {};
+
+// Determines at compile time which sections a visitor observes. A callback is
+// not implemented if it is inherited unchanged from Visitor or SkipVisitor.
+//
+// Visit does not decode the items of a section that the visitor does not
+// observe, and does not decode the instructions of function bodies unless
+// OnInstruction or OnInstructions is implemented. The Context counters that
+// EndModule checks are still updated from the section counts.
+template <typename V>
+struct VisitorInterest {
+#define WASP_IMPLEMENTS(Name)                                          \
+  (std::is_base_of_v<DecodeAllVisitor, V> ||                          \
+   !(std::is_same_v<decltype(&V::Name), decltype(&Visitor::Name)> ||  \
+     std::is_same_v<decltype(&V::Name), decltype(&SkipVisitor::Name)>))
+#define WASP_SECTION_INTEREST(Name)                                      \
+  static constexpr bool Name = WASP_IMPLEMENTS(Begin##Name##Section) ||  \
+                               WASP_IMPLEMENTS(On##Name) ||              \
+                               WASP_IMPLEMENTS(End##Name##Section);
+
+  WASP_SECTION_INTEREST(Type)
+  WASP_SECTION_INTEREST(Import)
+  WASP_SECTION_INTEREST(Function)
+  WASP_SECTION_INTEREST(Table)
+  WASP_SECTION_INTEREST(Memory)
+  WASP_SECTION_INTEREST(Global)
+  WASP_SECTION_INTEREST(Event)
+  WASP_SECTION_INTEREST(Export)
+  WASP_SECTION_INTEREST(Element)
+  WASP_SECTION_INTEREST(Data)
+
+  static constexpr bool Instructions = HasOnInstructions<V>::value;
+  static constexpr bool Instruction =
+      Instructions || WASP_IMPLEMENTS(OnInstruction);
+  static constexpr bool Code =
+      WASP_IMPLEMENTS(BeginCodeSection) || WASP_IMPLEMENTS(BeginCode) ||
+      Instruction || WASP_IMPLEMENTS(EndCode) ||
+      WASP_IMPLEMENTS(EndCodeSection);
+
+#undef WASP_SECTION_INTEREST
+#undef WASP_IMPLEMENTS
+};
+
 template <typename Visitor>
 Result Visit(LazyModule&, Visitor&);
 
+// Visits a single section, or a single function body, using `context`. These
+// are the building blocks of Visit, and are used by readers that do not have
+// the entire module available, e.g. StreamingModuleReader.
+template <typename Visitor>
+Result VisitSection(At<Section>, Context&, Visitor&);
+template <typename Visitor>
+Result VisitCode(const At<Code>&, Context&, Visitor&);
+template <typename Visitor>
+Result VisitInstructionBatches(SpanU8, Context&, Visitor&);
+
 #define WASP_CHECK(x)      \
   if (x == Result::Fail) { \
     return Result::Fail;   \
@@ -150,16 +235,20 @@ Result Visit(LazyModule&, Visitor&);
 
 #define WASP_SECTION_ELSE_SKIP(Name, skip_section)         \
   case SectionId::Name: {                                  \
-    auto sec = Read##Name##Section(known, module.context); \
-    WASP_IF_OK_ELSE_SKIP(                                  \
-        visitor.Begin##Name##Section(sec),                 \
-        {                                                  \
-          for (const auto& item : sec.sequence) {          \
-            WASP_CHECK(visitor.On##Name(item));            \
-          }                                                \
-          WASP_CHECK(visitor.End##Name##Section(sec));     \
-        },                                                 \
-        skip_section)                                      \
+    auto sec = Read##Name##Section(known, context);        \
+    if constexpr (VisitorInterest<Visitor>::Name) {        \
+      WASP_IF_OK_ELSE_SKIP(                                \
+          visitor.Begin##Name##Section(sec),               \
+          {                                                \
+            for (const auto& item : sec.sequence) {        \
+              WASP_CHECK(visitor.On##Name(item));          \
+            }                                              \
+            WASP_CHECK(visitor.End##Name##Section(sec));   \
+          },                                               \
+          skip_section)                                    \
+    } else {                                               \
+      skip_section                                         \
+    }                                                      \
     break;                                                 \
   }
 
@@ -167,7 +256,7 @@ Result Visit(LazyModule&, Visitor&);
 
 #define WASP_OPT_SECTION(Name)                             \
   case SectionId::Name: {                                  \
-    auto opt = Read##Name##Section(known, module.context); \
+    auto opt = Read##Name##Section(known, context);        \
     WASP_IF_OK(visitor.Begin##Name##Section(opt), {        \
       if (opt) {                                           \
         WASP_CHECK(visitor.On##Name(*opt));                \
@@ -186,66 +275,161 @@ inline Result Visit(LazyModule& module, Visitor& visitor) {
   }
 
   for (auto section : module.sections) {
-    auto res = visitor.OnSection(section);
-    if (res == Result::Skip) {
-      continue;
-    } else if (res == Result::Fail) {
-      return Result::Fail;
-    }
+    WASP_CHECK(VisitSection(section, module.context, visitor));
+  }
+  EndModule(module.data, module.context);
+  return visitor.EndModule(module);
+}
 
-    if (section->is_known()) {
-      const auto& known = section->known();
-      switch (known->id) {
-        WASP_SECTION(Type)
-        WASP_SECTION(Import)
-        WASP_SECTION_ELSE_SKIP(Function, {
-          module.context.defined_function_count += sec.count->value();
-        })
-        WASP_SECTION(Table)
-        WASP_SECTION(Memory)
-        WASP_SECTION(Global)
-        WASP_SECTION(Event)
-        WASP_SECTION(Export)
-        WASP_OPT_SECTION(Start)
-        WASP_SECTION(Element)
-        WASP_OPT_SECTION(DataCount)
-
-        case SectionId::Code: {
-          auto sec = ReadCodeSection(known, module.context);
+template <typename Visitor>
+inline Result VisitSection(At<Section> section,
+                           Context& context,
+                           Visitor& visitor) {
+  auto res = visitor.OnSection(section);
+  if (res == Result::Skip) {
+    return Result::Ok;
+  } else if (res == Result::Fail) {
+    return Result::Fail;
+  }
+
+  if (section->is_known()) {
+    const auto& known = section->known();
+    switch (known->id) {
+      WASP_SECTION(Type)
+      WASP_SECTION(Import)
+      WASP_SECTION_ELSE_SKIP(Function, {
+        if (sec.count) {
+          context.defined_function_count += sec.count->value();
+        }
+      })
+      WASP_SECTION(Table)
+      WASP_SECTION(Memory)
+      WASP_SECTION(Global)
+      WASP_SECTION(Event)
+      WASP_SECTION(Export)
+      WASP_OPT_SECTION(Start)
+      WASP_SECTION(Element)
+      WASP_OPT_SECTION(DataCount)
+
+      case SectionId::Code: {
+        auto sec = ReadCodeSection(known, context);
+        // If skipping this section, increment by the number of code items
+        // specified in this section.
+        auto skip_section = [&]() {
+          if (sec.count) {
+            context.code_count += sec.count->value();
+          }
+        };
+        if constexpr (VisitorInterest<Visitor>::Code) {
           WASP_IF_OK_ELSE_SKIP(
               visitor.BeginCodeSection(sec),
               {
                 for (const auto& code : sec.sequence) {
-                  WASP_IF_OK(
-                      visitor.BeginCode(*code), {
-                        for (auto&& instr :
-                             ReadExpression(*code->body, module.context)) {
-                          WASP_CHECK(visitor.OnInstruction(instr));
-                        }
-                        EndCode(code->body->data.last(0), module.context);
-                        WASP_CHECK(visitor.EndCode(*code));
-                      })
+                  WASP_CHECK(VisitCode(code, context, visitor));
                 }
                 WASP_CHECK(visitor.EndCodeSection(sec));
               },
-              // If skipping this section, increment by the number of code
-              // items specified in this section.
-              { module.context.code_count += sec.count->value(); })
-          break;
+              { skip_section(); })
+        } else {
+          skip_section();
         }
+        break;
+      }
 
-        WASP_SECTION_ELSE_SKIP(
-            Data,
-            // If skipping this section, increment by the number of data items
-            // specified in this section.
-            { module.context.data_count += sec.count->value(); })
+      WASP_SECTION_ELSE_SKIP(
+          Data,
+          // If skipping this section, increment by the number of data items
+          // specified in this section.
+          {
+            if (sec.count) {
+              context.data_count += sec.count->value();
+            }
+          })
+
+      default: break;
+    }
+  }
+  return Result::Ok;
+}
 
-        default: break;
+template <typename Visitor>
+inline Result VisitCode(const At<Code>& code,
+                        Context& context,
+                        Visitor& visitor) {
+  WASP_IF_OK(visitor.BeginCode(code), {
+    if constexpr (VisitorInterest<Visitor>::Instructions) {
+      WASP_CHECK(VisitInstructionBatches(code->body->data, context, visitor));
+      EndCode(code->body->data.last(0), context);
+    } else if constexpr (VisitorInterest<Visitor>::Instruction) {
+      for (auto&& instr : ReadExpression(*code->body, context)) {
+        WASP_CHECK(visitor.OnInstruction(instr));
+      }
+      EndCode(code->body->data.last(0), context);
+    }
+    WASP_CHECK(visitor.EndCode(code));
+  })
+  return Result::Ok;
+}
+
+template <typename Visitor>
+inline Result VisitInstructionBatches(SpanU8 data,
+                                      Context& context,
+                                      Visitor& visitor) {
+  // The buffer is reused for every body visited on this thread. It is moved
+  // out while in use, so a nested Visit gets a buffer of its own.
+  thread_local InstructionList cache;
+  InstructionList buffer = std::move(cache);
+  buffer.clear();
+
+  // Instructions are read ahead of the visitor, so read errors are recorded
+  // and only reported once the batch before them has been visited.
+  RecordingErrors read_errors{context.errors.track_context()};
+  Context read_context{context.features, read_errors};
+  read_context.declared_data_count = context.declared_data_count;
+  read_context.seen_final_end = context.seen_final_end;
+  std::swap(read_context.open_blocks, context.open_blocks);
+
+  auto flush = [&]() {
+    auto result = visitor.OnInstructions(span<const At<Instruction>>{buffer});
+    buffer.clear();
+    return result;
+  };
+
+  auto result = Result::Ok;
+  for (auto&& instr : ReadExpression(data, read_context)) {
+    if (read_errors.HasError()) {
+      if (!buffer.empty()) {
+        result = flush();
+        if (result == Result::Fail) {
+          break;
+        }
+      }
+      read_errors.Replay(context.errors);
+    }
+    read_errors.Clear();
+
+    buffer.push_back(instr);
+    if (buffer.size() == kInstructionBatchSize) {
+      result = flush();
+      if (result == Result::Fail) {
+        break;
       }
     }
   }
-  EndModule(module.data, module.context);
-  return visitor.EndModule(module);
+  if (result != Result::Fail && !buffer.empty()) {
+    result = flush();
+  }
+  // Report the errors from the read that ended the expression, if any.
+  if (result != Result::Fail && read_errors.HasError()) {
+    read_errors.Replay(context.errors);
+  }
+
+  std::swap(read_context.open_blocks, context.open_blocks);
+  context.seen_final_end = read_context.seen_final_end;
+
+  buffer.clear();
+  cache = std::move(buffer);
+  return result == Result::Fail ? Result::Fail : Result::Ok;
 }
 
 #undef WASP_CHECK
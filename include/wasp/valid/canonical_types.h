@@ -0,0 +1,43 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef WASP_VALID_CANONICAL_TYPES_H_
+#define WASP_VALID_CANONICAL_TYPES_H_
+
+#include <vector>
+
+#include "wasp/base/types.h"
+#include "wasp/binary/types.h"
+
+namespace wasp::valid {
+
+// Returns a canonical ID for each type, such that two types have the same ID
+// if and only if they are structurally equivalent (see IsSame).
+//
+// Types that don't refer to a recursive type are hash-consed in post-order, so
+// each is visited once. The rest are partitioned by shape, and the partitions
+// are split until every type in a partition refers to the same partitions.
+// This finds the largest set of equivalences, which is what IsSame computes by
+// assuming that recursive types are the same.
+//
+// A type index that is out of range is only equivalent to the same index.
+auto CanonicalizeTypes(const std::vector<binary::DefinedType>&)
+    -> std::vector<Index>;
+
+}  // namespace wasp::valid
+
+#endif  // WASP_VALID_CANONICAL_TYPES_H_
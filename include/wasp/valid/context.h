@@ -17,17 +17,15 @@
 #ifndef WASP_VALID_CONTEXT_H_
 #define WASP_VALID_CONTEXT_H_
 
-#include <map>
-#include <set>
 #include <vector>
 
 #include "wasp/base/errors.h"
 #include "wasp/base/features.h"
+#include "wasp/base/hashmap.h"
 #include "wasp/base/span.h"
 #include "wasp/base/string_view.h"
 #include "wasp/base/types.h"
 #include "wasp/binary/types.h"
-#include "wasp/valid/disjoint_set.h"
 #include "wasp/valid/local_map.h"
 #include "wasp/valid/types.h"
 
@@ -44,36 +42,42 @@ enum class LabelType {
   Let,
 };
 
+// A label's param and result types are not stored in the label itself, but
+// back-to-back in Context::label_types, so pushing a label doesn't allocate
+// once that buffer has grown. Use Context::GetParamTypes, GetResultTypes and
+// GetBrTypes to access them.
 struct Label {
   Label(LabelType,
-        StackTypeSpan param_types,
-        StackTypeSpan result_types,
+        Index types_begin,
+        Index param_count,
+        Index result_count,
         Index type_stack_limit);
 
-  const StackTypeList& br_types() const {
-    return label_type == LabelType::Loop ? param_types : result_types;
-  }
-
   LabelType label_type;
-  StackTypeList param_types;
-  StackTypeList result_types;
+  Index types_begin;
+  Index param_count;
+  Index result_count;
   Index type_stack_limit;
   bool unreachable;
 };
 
+// Memoizes a relation between pairs of types, keyed by canonical type ID. A
+// pair is assumed to be related while it is being checked, which handles
+// recursive types. If the check fails, the results computed after that
+// assumption are discarded as well, since they may depend on it.
 class TypeRelationSet {
  public:
-  void Reset(Index);
+  void Reset();
 
-  auto Get(Index, Index) -> optional<bool>;
+  auto Get(Index, Index) const -> optional<bool>;
   void Assume(Index, Index);
   void Resolve(Index, Index, bool);
 
  private:
-  void MaybeSwapIndexes(Index&, Index&);
+  static u64 MakeKey(Index, Index);
 
-  DisjointSet disjoint_set_;
-  std::map<std::pair<Index, Index>, bool> assume_;
+  flat_hash_map<u64, bool> results_;
+  std::vector<u64> keys_;  // In the order they were assumed.
 };
 
 struct Context {
@@ -88,6 +92,28 @@ struct Context {
   bool IsStructType(Index) const;
   bool IsArrayType(Index) const;
 
+  // Recomputes canonical_type_ids if types have been added since they were
+  // last computed. Returns nullopt if the index is out of range.
+  auto GetCanonicalTypeId(Index) -> optional<Index>;
+  void UpdateCanonicalTypeIds();
+
+  // Marks a function as declared, so it can be referenced by ref.func in a
+  // function body. Out-of-range indexes are ignored; they are reported when
+  // the index itself is validated.
+  void DeclareFunction(Index);
+  bool IsFunctionDeclared(Index) const;
+
+  void PushLabel(LabelType,
+                 StackTypeSpan param_types,
+                 StackTypeSpan result_types,
+                 Index type_stack_limit);
+  void PushLabel(LabelType, const binary::FunctionType&, Index type_stack_limit);
+  void PopLabel();
+
+  StackTypeSpan GetParamTypes(const Label&) const;
+  StackTypeSpan GetResultTypes(const Label&) const;
+  StackTypeSpan GetBrTypes(const Label&) const;
+
   Features features;
   Errors* errors;
 
@@ -106,10 +132,17 @@ struct Context {
   LocalMap locals;
   StackTypeList type_stack;
   std::vector<Label> label_stack;
-  std::set<string_view> export_names;
-  std::set<Index> declared_functions;
-
-  TypeRelationSet same_types;
+  StackTypeList label_types;
+  // Reused when converting a binary::ValueTypeList to stack types, so it can
+  // be done without allocating.
+  StackTypeList scratch_types;
+  flat_hash_set<string_view> export_names;
+  // Indexed by function index; see DeclareFunction.
+  std::vector<bool> declared_functions;
+
+  // Two types are the same if and only if their canonical IDs are equal. See
+  // CanonicalizeTypes.
+  std::vector<Index> canonical_type_ids;
   TypeRelationSet match_types;
 };
 
@@ -0,0 +1,98 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef WASP_VALID_MODULE_BATCH_H_
+#define WASP_VALID_MODULE_BATCH_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "wasp/base/error.h"
+#include "wasp/base/features.h"
+#include "wasp/base/span.h"
+#include "wasp/base/string_view.h"
+#include "wasp/base/types.h"
+
+namespace wasp {
+
+class ThreadPool;
+
+namespace valid {
+
+// The result of reading and validating one module of a ModuleBatch. `data`
+// and `errors` are only valid during the callback.
+struct ModuleBatchResult {
+  Index index;           // The position of the module in the batch.
+  string_view filename;  // Empty if the module was added as data.
+  SpanU8 data;
+  bool read_file = true;  // False if the file couldn't be read.
+  bool valid = false;
+  span<const Error> errors;
+};
+
+using ModuleBatchCallback = std::function<void(const ModuleBatchResult&)>;
+
+// Reads and validates many modules on the threads of a ThreadPool.
+//
+// Each worker thread has its own Errors and ValidateVisitor, which are reset
+// and reused for every module it validates, so their buffers are only
+// allocated once. The workers are kept between calls to Run.
+//
+// A batch with a single module is instead validated on the calling thread,
+// with its function bodies spread over the pool.
+class ModuleBatch {
+ public:
+  explicit ModuleBatch(const Features&, ThreadPool&);
+  ~ModuleBatch();
+
+  // `data` must outlive the call to Run.
+  void Add(SpanU8 data);
+  // The file is read by the worker that validates it.
+  void AddFile(string_view filename);
+  void Clear();
+
+  Index size() const { return static_cast<Index>(items_.size()); }
+  bool empty() const { return items_.empty(); }
+
+  // Reads and validates every module that was added. `callback` is called on
+  // a worker thread (or the calling thread, for a single module) as soon as
+  // each module is done, so calls may be concurrent and out of order. Returns
+  // true if every module is valid.
+  bool Run(const ModuleBatchCallback& callback);
+
+ private:
+  struct Item {
+    std::string filename;
+    SpanU8 data;
+    bool is_file;
+  };
+  struct Worker;
+
+  bool Process(Worker&, Index index, const ModuleBatchCallback&);
+
+  Features features_;
+  ThreadPool& pool_;
+  std::vector<Item> items_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+};
+
+}  // namespace valid
+}  // namespace wasp
+
+#endif  // WASP_VALID_MODULE_BATCH_H_
@@ -20,6 +20,13 @@
 #include "wasp/base/types.h"
 #include "wasp/valid/types.h"
 
+namespace wasp::binary {
+
+class PackedInstruction;
+class PackedInstructionStream;
+
+}  // namespace wasp::binary
+
 namespace wasp::valid {
 
 enum class RequireDefaultable {
@@ -30,6 +37,7 @@ enum class RequireDefaultable {
 struct Context;
 
 bool BeginTypeSection(Context&, Index type_count);
+bool BeginExportSection(Context&, Index export_count);
 bool BeginCode(Context&, Location loc);
 
 bool CheckDefaultable(Context&,
@@ -70,9 +78,12 @@ bool ValidateIndex(Context&,
                    Index max,
                    string_view desc);
 bool Validate(Context&, const At<binary::Instruction>&);
+bool Validate(Context&, const binary::PackedInstruction&);
+// Validates each instruction in turn, stopping at the first invalid one.
+bool Validate(Context&, const binary::PackedInstructionStream&);
 bool Validate(Context&, const At<Limits>&, Index max);
 bool Validate(Context&, const At<binary::Locals>&, RequireDefaultable);
-bool Validate(Context&, const At<binary::LocalsList>&, RequireDefaultable);
+bool Validate(Context&, const binary::LocalsList&, RequireDefaultable);
 bool Validate(Context&, const At<binary::Memory>&);
 bool Validate(Context&, const At<MemoryType>&);
 bool Validate(Context&, const At<binary::ReferenceType>&);
@@ -24,14 +24,21 @@
 namespace wasp {
 
 class Errors;
+class ThreadPool;
 
 namespace valid {
 
-struct ValidateVisitor : binary::visit::Visitor {
+struct ValidateVisitor : binary::visit::DecodeAllVisitor {
   using Result = binary::visit::Result;
 
   explicit ValidateVisitor(Features features, Errors& errors);
+  // If `pool` has more than one thread, the function bodies of the code
+  // section are validated in parallel on its threads, each with its own copy
+  // of the module-level context. Errors are still reported in function order.
+  // The visitor must not be used from one of the pool's own threads.
+  explicit ValidateVisitor(Features features, Errors& errors, ThreadPool* pool);
 
+  auto BeginModule(binary::LazyModule&) -> Result;
   auto BeginTypeSection(binary::LazyTypeSection) -> Result;
   auto OnType(const At<binary::DefinedType>&) -> Result;
   auto OnImport(const At<binary::Import>&) -> Result;
@@ -39,19 +46,27 @@ struct ValidateVisitor : binary::visit::Visitor {
   auto OnTable(const At<binary::Table>&) -> Result;
   auto OnMemory(const At<binary::Memory>&) -> Result;
   auto OnGlobal(const At<binary::Global>&) -> Result;
+  auto BeginExportSection(binary::LazyExportSection) -> Result;
   auto OnExport(const At<binary::Export>&) -> Result;
   auto OnStart(const At<binary::Start>&) -> Result;
   auto OnElement(const At<binary::ElementSegment>&) -> Result;
   auto OnDataCount(const At<binary::DataCount>&) -> Result;
+  auto BeginCodeSection(binary::LazyCodeSection) -> Result;
   auto BeginCode(const At<binary::Code>&) -> Result;
   auto OnInstruction(const At<binary::Instruction>&) -> Result;
+  auto OnInstructions(span<const At<binary::Instruction>>) -> Result;
   auto OnData(const At<binary::DataSegment>&) -> Result;
 
+  auto ValidateCodeSectionParallel(binary::LazyCodeSection) -> Result;
   auto FailUnless(bool) -> Result;
 
   valid::Context context;
   Features features;
   Errors& errors;
+  ThreadPool* pool = nullptr;
+  // Set by BeginModule. Bodies are only validated in parallel when the whole
+  // module is visited, since the read context is needed to decode them.
+  binary::Context* binary_context = nullptr;
 };
 
 }  // namespace valid
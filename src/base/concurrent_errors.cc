@@ -0,0 +1,129 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/base/concurrent_errors.h"
+
+#include <algorithm>
+#include <functional>
+#include <string>
+
+namespace wasp {
+
+namespace {
+
+std::atomic<u64> next_id{1};
+
+// The ThreadState of the ConcurrentErrors most recently used on this thread.
+struct ThreadCache {
+  u64 id = 0;
+  void* state = nullptr;
+};
+
+thread_local ThreadCache thread_cache;
+
+}  // namespace
+
+ConcurrentErrors::ConcurrentErrors(bool track_context)
+    : Errors{track_context}, id_{next_id++} {}
+
+ConcurrentErrors::~ConcurrentErrors() = default;
+
+auto ConcurrentErrors::GetThreadState() -> ThreadState& {
+  if (thread_cache.id == id_) {
+    return *static_cast<ThreadState*>(thread_cache.state);
+  }
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto& state = states_[std::this_thread::get_id()];
+  if (!state) {
+    state = std::make_unique<ThreadState>();
+  }
+  thread_cache = ThreadCache{id_, state.get()};
+  return *state;
+}
+
+auto ConcurrentErrors::GetEntries() const -> std::vector<Entry> {
+  size_t count = 0;
+  for (const auto& pair : states_) {
+    count += pair.second->entries.size();
+  }
+
+  std::vector<Entry> result;
+  result.reserve(count);
+  for (const auto& pair : states_) {
+    const auto& entries = pair.second->entries;
+    result.insert(result.end(), entries.begin(), entries.end());
+  }
+
+  // The threads' buffers are visited in an unspecified order, so sort by
+  // message too. The locations may point into different buffers, so they are
+  // compared with std::less, which is a total order even then; the built-in <
+  // is not. The sort is stable, so errors that are still equal keep the order
+  // they were reported in by a single thread.
+  std::stable_sort(result.begin(), result.end(),
+                   [](const Entry& lhs, const Entry& rhs) {
+                     std::less<const u8*> less;
+                     const auto& l = lhs.error.loc;
+                     const auto& r = rhs.error.loc;
+                     if (l.data() != r.data()) {
+                       return less(l.data(), r.data());
+                     }
+                     if (l.size() != r.size()) {
+                       return l.size() < r.size();
+                     }
+                     return string_view{lhs.error.message} <
+                            string_view{rhs.error.message};
+                   });
+  return result;
+}
+
+void ConcurrentErrors::Replay(Errors& errors) const {
+  for (const auto& entry : GetEntries()) {
+    for (const auto& context : entry.context) {
+      errors.PushContext(context.loc, context.message);
+    }
+    errors.OnError(entry.error.loc, entry.error.message);
+    for (size_t i = 0; i < entry.context.size(); ++i) {
+      errors.PopContext();
+    }
+  }
+}
+
+void ConcurrentErrors::Clear() {
+  for (auto& pair : states_) {
+    pair.second->context_stack.clear();
+    pair.second->entries.clear();
+  }
+  has_error_ = false;
+}
+
+void ConcurrentErrors::HandlePushContext(Location loc, string_view desc) {
+  GetThreadState().context_stack.push_back(Error{loc, std::string{desc}});
+}
+
+void ConcurrentErrors::HandlePopContext() {
+  GetThreadState().context_stack.pop_back();
+}
+
+void ConcurrentErrors::HandleOnError(Location loc, string_view message) {
+  auto& state = GetThreadState();
+  state.entries.push_back(
+      Entry{state.context_stack, Error{loc, std::string{message}}});
+  has_error_.store(true, std::memory_order_relaxed);
+}
+
+}  // namespace wasp
@@ -18,6 +18,17 @@
 
 #include <fstream>
 #include <string>
+#include <utility>
+
+#if !defined(_WIN32)
+#define WASP_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define WASP_HAS_MMAP 0
+#endif
 
 namespace wasp {
 
@@ -39,4 +50,87 @@ optional<Buffer> ReadFile(string_view filename) {
   return buffer;
 }
 
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+  *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    Unmap();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+    mapped_ = std::exchange(other.mapped_, false);
+    buffer_ = std::move(other.buffer_);
+    if (!mapped_) {
+      data_ = buffer_.data();
+    }
+  }
+  return *this;
+}
+
+MappedFile::~MappedFile() {
+  Unmap();
+}
+
+SpanU8 MappedFile::data() const {
+  return SpanU8{data_, static_cast<span_extent_t>(size_)};
+}
+
+void MappedFile::Unmap() {
+#if WASP_HAS_MMAP
+  if (mapped_) {
+    munmap(const_cast<u8*>(data_), size_);
+  }
+#endif
+  data_ = nullptr;
+  size_ = 0;
+  mapped_ = false;
+  buffer_.clear();
+}
+
+optional<MappedFile> ReadFile(string_view filename, MapFileTag) {
+  MappedFile file;
+#if WASP_HAS_MMAP
+  int fd = open(std::string{filename}.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullopt;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    close(fd);
+    return nullopt;
+  }
+
+  size_t size = static_cast<size_t>(st.st_size);
+  if (size != 0) {
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED) {
+      // The binary reader makes a single forward pass over most of the file,
+      // so ask the kernel to read ahead aggressively.
+      madvise(addr, size, MADV_SEQUENTIAL);
+      madvise(addr, size, MADV_WILLNEED);
+      file.data_ = static_cast<const u8*>(addr);
+      file.size_ = size;
+      file.mapped_ = true;
+    }
+  }
+  close(fd);
+
+  if (file.mapped_ || size == 0) {
+    return file;
+  }
+#endif
+
+  // Fall back to reading the file into memory.
+  auto buffer = ReadFile(filename);
+  if (!buffer) {
+    return nullopt;
+  }
+  file.buffer_ = std::move(*buffer);
+  file.data_ = file.buffer_.data();
+  file.size_ = file.buffer_.size();
+  return file;
+}
+
 }  // namespace wasp
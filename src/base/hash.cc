@@ -0,0 +1,114 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/base/hash.h"
+
+namespace wasp {
+
+namespace {
+
+// MurmurHash3 x64 128 constants.
+constexpr u64 kC1 = 0x87c37b91114253d5ull;
+constexpr u64 kC2 = 0x4cf5ad432745937full;
+
+u64 Rotl(u64 x, int r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+u64 Load64(const u8* p) {
+  u64 result = 0;
+  for (int i = 0; i < 8; ++i) {
+    result |= u64{p[i]} << (i * 8);
+  }
+  return result;
+}
+
+u64 MixK1(u64 k1) {
+  k1 *= kC1;
+  k1 = Rotl(k1, 31);
+  return k1 * kC2;
+}
+
+u64 MixK2(u64 k2) {
+  k2 *= kC2;
+  k2 = Rotl(k2, 33);
+  return k2 * kC1;
+}
+
+u64 FMix(u64 k) {
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdull;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ull;
+  k ^= k >> 33;
+  return k;
+}
+
+}  // namespace
+
+auto HashBytes(SpanU8 data, u64 seed) -> Hash128 {
+  const u8* p = data.data();
+  const size_t size = data.size();
+  const u8* blocks_end = p + (size & ~size_t{15});
+  u64 h1 = seed;
+  u64 h2 = seed;
+
+  for (; p < blocks_end; p += 16) {
+    h1 ^= MixK1(Load64(p));
+    h1 = Rotl(h1, 27);
+    h1 += h2;
+    h1 = h1 * 5 + 0x52dce729;
+
+    h2 ^= MixK2(Load64(p + 8));
+    h2 = Rotl(h2, 31);
+    h2 += h1;
+    h2 = h2 * 5 + 0x38495ab5;
+  }
+
+  const size_t tail_size = size & 15;
+  u64 k1 = 0;
+  u64 k2 = 0;
+  for (size_t i = 0; i < tail_size; ++i) {
+    if (i < 8) {
+      k1 |= u64{p[i]} << (i * 8);
+    } else {
+      k2 |= u64{p[i]} << ((i - 8) * 8);
+    }
+  }
+  if (tail_size > 8) {
+    h2 ^= MixK2(k2);
+  }
+  if (tail_size > 0) {
+    h1 ^= MixK1(k1);
+  }
+
+  h1 ^= size;
+  h2 ^= size;
+  h1 += h2;
+  h2 += h1;
+  h1 = FMix(h1);
+  h2 = FMix(h2);
+  h1 += h2;
+  h2 += h1;
+  return Hash128{h1, h2};
+}
+
+WASP_BASE_HASH_STRUCTS(WASP_OPERATOR_EQ_NE_VARGS)
+
+}  // namespace wasp
+
+WASP_BASE_HASH_STRUCTS(WASP_STD_HASH_VARGS)
@@ -0,0 +1,56 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/base/recording_errors.h"
+
+namespace wasp {
+
+void RecordingErrors::Replay(Errors& errors) const {
+  for (const auto& event : events_) {
+    switch (event.kind) {
+      case Event::PushContext:
+        errors.PushContext(event.loc, event.text);
+        break;
+      case Event::PopContext:
+        errors.PopContext();
+        break;
+      case Event::Error:
+        errors.OnError(event.loc, event.text);
+        break;
+    }
+  }
+}
+
+void RecordingErrors::Clear() {
+  events_.clear();
+  has_error_ = false;
+}
+
+void RecordingErrors::HandlePushContext(Location loc, string_view desc) {
+  events_.push_back(Event{Event::PushContext, loc, std::string{desc}});
+}
+
+void RecordingErrors::HandlePopContext() {
+  events_.push_back(Event{Event::PopContext, {}, {}});
+}
+
+void RecordingErrors::HandleOnError(Location loc, string_view message) {
+  events_.push_back(Event{Event::Error, loc, std::string{message}});
+  has_error_ = true;
+}
+
+}  // namespace wasp
@@ -0,0 +1,129 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/base/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <utility>
+
+#include "wasp/base/at.h"
+
+namespace wasp {
+
+ThreadPool::ThreadPool(unsigned num_threads) {
+  if (num_threads == 0) {
+    num_threads = DefaultThreadCount();
+  }
+  threads_.reserve(num_threads);
+  for (unsigned i = 0; i < num_threads; ++i) {
+    threads_.emplace_back([this] { WorkerLoop(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+unsigned ThreadPool::size() const {
+  return static_cast<unsigned>(threads_.size());
+}
+
+void ThreadPool::Enqueue(Task task) {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    tasks_.push_back([base = LocationBase::Get(), task = std::move(task)] {
+      LocationBase location_base{base};
+      task();
+    });
+  }
+  cv_.notify_one();
+}
+
+void ThreadPool::ParallelFor(size_t count,
+                             size_t chunk_size,
+                             const RangeCallback& callback,
+                             const Task& caller_task) {
+  assert(chunk_size > 0);
+  const size_t chunk_count = (count + chunk_size - 1) / chunk_size;
+  const auto worker_count =
+      static_cast<unsigned>(std::min<size_t>(size(), chunk_count));
+
+  std::atomic<size_t> next_chunk{0};
+  std::mutex mutex;
+  std::condition_variable cv;
+  unsigned active_workers = worker_count;
+
+  // Workers may finish and decrement `active_workers` before all of them have
+  // been enqueued, so don't read it here.
+  for (unsigned worker = 0; worker < worker_count; ++worker) {
+    Enqueue([&, worker]() {
+      for (;;) {
+        size_t chunk = next_chunk++;
+        if (chunk >= chunk_count) {
+          break;
+        }
+        size_t begin = chunk * chunk_size;
+        callback(worker, begin, std::min(begin + chunk_size, count));
+      }
+      // Notify while holding the lock; once it is released the calling thread
+      // may return and destroy the condition variable.
+      std::lock_guard<std::mutex> lock{mutex};
+      --active_workers;
+      cv.notify_all();
+    });
+  }
+
+  if (caller_task) {
+    caller_task();
+  }
+
+  std::unique_lock<std::mutex> lock{mutex};
+  cv.wait(lock, [&]() { return active_workers == 0; });
+}
+
+// static
+unsigned ThreadPool::DefaultThreadCount() {
+  unsigned count = std::thread::hardware_concurrency();
+  return count == 0 ? 1 : count;
+}
+
+void ThreadPool::WorkerLoop() {
+  for (;;) {
+    Task task;
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      cv_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+      if (tasks_.empty()) {
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
+
+}  // namespace wasp
@@ -16,10 +16,29 @@
 
 #include "wasp/base/utf8.h"
 
+#include <cstring>
+
 #include "wasp/base/types.h"
 
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define WASP_HAS_UTF8_SSE2 1
+#include <emmintrin.h>
+#else
+#define WASP_HAS_UTF8_SSE2 0
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define WASP_HAS_UTF8_AVX2 1
+#define WASP_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#else
+#define WASP_HAS_UTF8_AVX2 0
+#endif
+
 namespace wasp {
 
+namespace {
+
 // Decoder modified from https://bjoern.hoehrmann.de/utf-8/decoder/dfa/, with
 // the following license:
 //
@@ -43,32 +62,312 @@ namespace wasp {
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
+const u8 kUtf8d[] = {
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // 00..1f
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // 20..3f
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // 40..5f
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // 60..7f
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9, // 80..9f
+  7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7, // a0..bf
+  8,8,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2, // c0..df
+  0xa,0x3,0x3,0x3,0x3,0x3,0x3,0x3,0x3,0x3,0x3,0x3,0x3,0x4,0x3,0x3, // e0..ef
+  0xb,0x6,0x6,0x6,0x5,0x8,0x8,0x8,0x8,0x8,0x8,0x8,0x8,0x8,0x8,0x8, // f0..ff
+  0x0,0x1,0x2,0x3,0x5,0x8,0x7,0x1,0x1,0x1,0x4,0x6,0x1,0x1,0x1,0x1, // s0..s0
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,1,1,1,1,1,0,1,0,1,1,1,1,1,1, // s1..s2
+  1,2,1,1,1,1,1,2,1,2,1,1,1,1,1,1,1,1,1,1,1,1,1,2,1,1,1,1,1,1,1,1, // s3..s4
+  1,2,1,1,1,1,1,1,1,2,1,1,1,1,1,1,1,1,1,1,1,1,1,3,1,3,1,1,1,1,1,1, // s5..s6
+  1,3,1,1,1,1,1,3,1,3,1,1,1,1,1,1,1,3,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // s7..s8
+};
+
+constexpr u32 kAccept = 0;
+constexpr u32 kReject = 1;
+
+inline u32 Step(u32 state, u8 c) {
+  return kUtf8d[256 + state * 16 + kUtf8d[c]];
+}
+
+bool IsValidUtf8Scalar(const u8* data, size_t size) {
+  u32 state = kAccept;
+  for (size_t i = 0; i < size; ++i) {
+    state = Step(state, data[i]);
+  }
+  return state == kAccept;
+}
+
+#if WASP_HAS_UTF8_SSE2
+
+// Most names are ASCII, so skip 16-byte blocks of ASCII when the DFA is not in
+// the middle of a multi-byte sequence; all other bytes go through the DFA.
+bool IsValidUtf8Sse2(const u8* data, size_t size) {
+  u32 state = kAccept;
+  size_t i = 0;
+  while (i + 16 <= size) {
+    if (state == kAccept) {
+      __m128i block =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+      if (_mm_movemask_epi8(block) == 0) {
+        i += 16;
+        continue;
+      }
+    }
+    for (size_t end = i + 16; i < end; ++i) {
+      state = Step(state, data[i]);
+    }
+    if (state == kReject) {
+      return false;
+    }
+  }
+  for (; i < size; ++i) {
+    state = Step(state, data[i]);
+  }
+  return state == kAccept;
+}
+
+#endif  // WASP_HAS_UTF8_SSE2
+
+#if WASP_HAS_UTF8_AVX2
+
+// The "lookup" algorithm from "Validating UTF-8 In Less Than One Instruction
+// Per Byte" (Keiser & Lemire, 2021). Each byte is classified by three 16-entry
+// table lookups, on the high and low nibbles of the previous byte and the
+// high nibble of the current byte. ANDing the results leaves a bit set for
+// each error in a two-byte sequence; the remaining errors (missing or extra
+// continuation bytes in 3- and 4-byte sequences) are found by looking two
+// and three bytes back.
+namespace avx2 {
+
+constexpr u8 kTooShort = 1 << 0;    // 11______ 0_______, 11______ 11______
+constexpr u8 kTooLong = 1 << 1;     // 0_______ 10______
+constexpr u8 kOverlong3 = 1 << 2;   // 11100000 100_____
+constexpr u8 kTooLarge = 1 << 3;    // 11110100 1001____, 11110100 101_____
+constexpr u8 kSurrogate = 1 << 4;   // 11101101 101_____
+constexpr u8 kOverlong2 = 1 << 5;   // 1100000_ 10______
+constexpr u8 kTooLarge1000 = 1 << 6;  // 11110101+ 1000____
+constexpr u8 kOverlong4 = 1 << 6;   // 11110000 1000____
+constexpr u8 kTwoConts = 1 << 7;    // 10______ 10______
+constexpr u8 kCarry = kTooShort | kTooLong | kTwoConts;
+
+alignas(16) constexpr u8 kByte1High[16] = {
+    // 0_______ ________
+    kTooLong, kTooLong, kTooLong, kTooLong,
+    kTooLong, kTooLong, kTooLong, kTooLong,
+    // 10______ ________
+    kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+    // 1100____ ________
+    kTooShort | kOverlong2,
+    // 1101____ ________
+    kTooShort,
+    // 1110____ ________
+    kTooShort | kOverlong3 | kSurrogate,
+    // 1111____ ________
+    kTooShort | kTooLarge | kTooLarge1000 | kOverlong4,
+};
+
+alignas(16) constexpr u8 kByte1Low[16] = {
+    // ____0000 ________
+    kCarry | kOverlong3 | kOverlong2 | kOverlong4,
+    // ____0001 ________
+    kCarry | kOverlong2,
+    // ____001_ ________
+    kCarry,
+    kCarry,
+    // ____0100 ________
+    kCarry | kTooLarge,
+    // ____0101 ________
+    kCarry | kTooLarge | kTooLarge1000,
+    // ____011_ ________
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    // ____1___ ________
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    // ____1101 ________
+    kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+};
+
+alignas(16) constexpr u8 kByte2High[16] = {
+    // ________ 0_______
+    kTooShort, kTooShort, kTooShort, kTooShort,
+    kTooShort, kTooShort, kTooShort, kTooShort,
+    // ________ 1000____
+    kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 |
+        kOverlong4,
+    // ________ 1001____
+    kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+    // ________ 101_____
+    kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+    kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+    // ________ 11______
+    kTooShort, kTooShort, kTooShort, kTooShort,
+};
+
+// The largest value of each of the last three bytes of a block that doesn't
+// start a sequence which continues into the next block.
+alignas(32) constexpr u8 kMaxIncomplete[32] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xf0 - 1, 0xe0 - 1, 0xc0 - 1,
+};
+
+struct State {
+  __m256i error;
+  __m256i prev_input;
+  __m256i prev_incomplete;
+};
+
+WASP_TARGET_AVX2 inline __m256i Table(const u8 (&table)[16]) {
+  return _mm256_broadcastsi128_si256(
+      _mm_load_si128(reinterpret_cast<const __m128i*>(table)));
+}
+
+WASP_TARGET_AVX2 inline __m256i HighNibbles(__m256i v) {
+  return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0f));
+}
+
+// The bytes of `input` shifted N bytes later, with the last N bytes of
+// `prev` shifted in.
+template <int N>
+WASP_TARGET_AVX2 inline __m256i Prev(__m256i input, __m256i prev) {
+  return _mm256_alignr_epi8(
+      input, _mm256_permute2x128_si256(prev, input, 0x21), 16 - N);
+}
+
+WASP_TARGET_AVX2 inline void CheckBlock(__m256i input, State* state) {
+  if (_mm256_movemask_epi8(input) == 0) {
+    // An ASCII block is valid, as long as the previous block didn't end in
+    // the middle of a sequence.
+    state->error = _mm256_or_si256(state->error, state->prev_incomplete);
+    state->prev_incomplete = _mm256_setzero_si256();
+  } else {
+    __m256i prev1 = Prev<1>(input, state->prev_input);
+    __m256i special_cases = _mm256_and_si256(
+        _mm256_and_si256(
+            _mm256_shuffle_epi8(Table(kByte1High), HighNibbles(prev1)),
+            _mm256_shuffle_epi8(Table(kByte1Low),
+                                _mm256_and_si256(prev1,
+                                                 _mm256_set1_epi8(0x0f)))),
+        _mm256_shuffle_epi8(Table(kByte2High), HighNibbles(input)));
+
+    // Bytes 2 or 3 after a 3- or 4-byte lead must be continuation bytes; the
+    // high bit is set where that is the case.
+    __m256i is_third_byte = _mm256_subs_epu8(
+        Prev<2>(input, state->prev_input), _mm256_set1_epi8(0xe0 - 0x80));
+    __m256i is_fourth_byte = _mm256_subs_epu8(
+        Prev<3>(input, state->prev_input),
+        _mm256_set1_epi8(static_cast<char>(0xf0 - 0x80)));
+    __m256i must_be_continuation =
+        _mm256_and_si256(_mm256_or_si256(is_third_byte, is_fourth_byte),
+                         _mm256_set1_epi8(static_cast<char>(0x80)));
+
+    state->error = _mm256_or_si256(
+        state->error, _mm256_xor_si256(must_be_continuation, special_cases));
+    state->prev_incomplete = _mm256_subs_epu8(
+        input,
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(kMaxIncomplete)));
+  }
+  state->prev_input = input;
+}
+
+WASP_TARGET_AVX2 bool IsValidUtf8(const u8* data, size_t size) {
+  State state{_mm256_setzero_si256(), _mm256_setzero_si256(),
+              _mm256_setzero_si256()};
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    CheckBlock(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)),
+               &state);
+  }
+  if (i < size) {
+    // Pad the last block with ASCII.
+    alignas(32) u8 block[32] = {};
+    std::memcpy(block, data + i, size - i);
+    CheckBlock(_mm256_load_si256(reinterpret_cast<const __m256i*>(block)),
+               &state);
+  }
+  __m256i error = _mm256_or_si256(state.error, state.prev_incomplete);
+  return _mm256_testz_si256(error, error);
+}
+
+}  // namespace avx2
+
+bool HasAvx2() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+#endif  // WASP_HAS_UTF8_AVX2
+
+using ValidateFunc = bool (*)(const u8*, size_t);
+
+ValidateFunc GetValidateFunc(Utf8Validator validator) {
+  if (IsUtf8ValidatorSupported(validator)) {
+    switch (validator) {
+#if WASP_HAS_UTF8_SSE2
+      case Utf8Validator::Sse2:
+        return IsValidUtf8Sse2;
+#endif
+#if WASP_HAS_UTF8_AVX2
+      case Utf8Validator::Avx2:
+        return avx2::IsValidUtf8;
+#endif
+      default:
+        break;
+    }
+  }
+  return IsValidUtf8Scalar;
+}
+
+ValidateFunc GetBestValidateFunc() {
+  for (auto validator : {Utf8Validator::Avx2, Utf8Validator::Sse2}) {
+    if (IsUtf8ValidatorSupported(validator)) {
+      return GetValidateFunc(validator);
+    }
+  }
+  return IsValidUtf8Scalar;
+}
+
+const u8* ToU8(string_view s) {
+  return reinterpret_cast<const u8*>(s.data());
+}
+
+}  // namespace
+
+bool IsUtf8ValidatorSupported(Utf8Validator validator) {
+  switch (validator) {
+    case Utf8Validator::Scalar:
+      return true;
+
+    case Utf8Validator::Sse2:
+      return WASP_HAS_UTF8_SSE2;
+
+    case Utf8Validator::Avx2: {
+#if WASP_HAS_UTF8_AVX2
+      static const bool has_avx2 = HasAvx2();
+      return has_avx2;
+#else
+      return false;
+#endif
+    }
+  }
+  return false;
+}
+
 bool IsValidUtf8(string_view s) {
-  static const u8 utf8d[] = {
-    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // 00..1f
-    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // 20..3f
-    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // 40..5f
-    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // 60..7f
-    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9, // 80..9f
-    7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7, // a0..bf
-    8,8,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2, // c0..df
-    0xa,0x3,0x3,0x3,0x3,0x3,0x3,0x3,0x3,0x3,0x3,0x3,0x3,0x4,0x3,0x3, // e0..ef
-    0xb,0x6,0x6,0x6,0x5,0x8,0x8,0x8,0x8,0x8,0x8,0x8,0x8,0x8,0x8,0x8, // f0..ff
-    0x0,0x1,0x2,0x3,0x5,0x8,0x7,0x1,0x1,0x1,0x4,0x6,0x1,0x1,0x1,0x1, // s0..s0
-    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,1,1,1,1,1,0,1,0,1,1,1,1,1,1, // s1..s2
-    1,2,1,1,1,1,1,2,1,2,1,1,1,1,1,1,1,1,1,1,1,1,1,2,1,1,1,1,1,1,1,1, // s3..s4
-    1,2,1,1,1,1,1,1,1,2,1,1,1,1,1,1,1,1,1,1,1,1,1,3,1,3,1,1,1,1,1,1, // s5..s6
-    1,3,1,1,1,1,1,3,1,3,1,1,1,1,1,1,1,3,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // s7..s8
-  };
-
-  u32 state = 0;
-  static const u32 accept = 0;
-
-  for (u8 c : s) {
-    u32 type = utf8d[c];
-    state = utf8d[256 + state * 16 + type];
+  // Most names are short, and are faster to check with the DFA directly.
+  if (s.size() < 16) {
+    return IsValidUtf8Scalar(ToU8(s), s.size());
   }
-  return state == accept;
+  static const ValidateFunc func = GetBestValidateFunc();
+  return func(ToU8(s), s.size());
+}
+
+bool IsValidUtf8(string_view s, Utf8Validator validator) {
+  return GetValidateFunc(validator)(ToU8(s), s.size());
 }
 
 }  // namespace wasp
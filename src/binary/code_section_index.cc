@@ -0,0 +1,120 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "wasp/binary/code_section_index.h"
+
+#include <utility>
+
+#include "wasp/binary/read.h"
+#include "wasp/binary/read/context.h"
+
+namespace wasp::binary {
+
+CodeSectionIndex::CodeSectionIndex(SpanU8 data,
+                                   Context& context,
+                                   Index first_index)
+    : count{ReadCount(&data, context)},
+      data_{data},
+      context_{context},
+      first_index_{first_index} {
+  IndexBodies();
+}
+
+CodeSectionIndex::CodeSectionIndex(SpanU8 data,
+                                   Context& context,
+                                   Index first_index,
+                                   std::vector<u32> offsets)
+    : count{ReadCount(&data, context)},
+      data_{data},
+      context_{context},
+      first_index_{first_index},
+      offsets_{std::move(offsets)} {
+  // The offsets may come from a stale or corrupt file, so only use them if
+  // every body is a non-empty range inside the data.
+  if (!HasValidOffsets()) {
+    offsets_.clear();
+    IndexBodies();
+  }
+}
+
+void CodeSectionIndex::IndexBodies() {
+  if (count) {
+    offsets_.reserve(*count + 1);
+  }
+
+  SpanU8 rest = data_;
+  u32 offset = 0;
+  while (!rest.empty()) {
+    auto length = ReadLength(&rest, context_);
+    if (!length) {
+      break;
+    }
+    remove_prefix(&rest, *length);
+    offsets_.push_back(offset);
+    offset = static_cast<u32>(rest.begin() - data_.begin());
+  }
+  offsets_.push_back(offset);
+}
+
+bool CodeSectionIndex::HasValidOffsets() const {
+  if (offsets_.empty() || offsets_.front() != 0 ||
+      offsets_.back() > data_.size()) {
+    return false;
+  }
+  for (size_t i = 1; i < offsets_.size(); ++i) {
+    if (offsets_[i] <= offsets_[i - 1]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool CodeSectionIndex::contains(Index func_index) const {
+  return func_index >= first_index_ && func_index - first_index_ < size();
+}
+
+SpanU8 CodeSectionIndex::GetCodeData(Index func_index) const {
+  if (!contains(func_index)) {
+    return {};
+  }
+  Index index = func_index - first_index_;
+  return data_.subspan(offsets_[index], offsets_[index + 1] - offsets_[index]);
+}
+
+OptAt<Code> CodeSectionIndex::GetCode(Index func_index) const {
+  SpanU8 data = GetCodeData(func_index);
+  if (data.empty()) {
+    return nullopt;
+  }
+  // Reading a Code increments the context's code_count, which is only
+  // meaningful when reading the bodies in order.
+  Index code_count = context_.code_count;
+  auto code = Read<Code>(&data, context_);
+  context_.code_count = code_count;
+  return code;
+}
+
+auto ReadCodeSectionIndex(SpanU8 data, Context& context, Index first_index)
+    -> CodeSectionIndex {
+  return CodeSectionIndex{data, context, first_index};
+}
+
+auto ReadCodeSectionIndex(KnownSection sec, Context& context, Index first_index)
+    -> CodeSectionIndex {
+  return ReadCodeSectionIndex(sec.data, context, first_index);
+}
+
+}  // namespace wasp::binary
@@ -0,0 +1,194 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/binary/eager_module.h"
+
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "wasp/binary/lazy_module.h"
+#include "wasp/binary/visitor.h"
+
+namespace wasp::binary {
+
+namespace {
+
+template <typename T, typename Section>
+void Reserve(std::vector<T>& vec, const Section& sec) {
+  if (sec.count) {
+    vec.reserve(vec.size() + sec.count->value());
+  }
+}
+
+struct EagerModuleVisitor : visit::Visitor {
+  using Result = visit::Result;
+
+  Result BeginTypeSection(LazyTypeSection sec) {
+    Reserve(module.types, sec);
+    return Result::Ok;
+  }
+
+  Result OnType(const At<DefinedType>& value) {
+    module.types.push_back(value);
+    return Result::Ok;
+  }
+
+  Result BeginImportSection(LazyImportSection sec) {
+    Reserve(module.imports, sec);
+    return Result::Ok;
+  }
+
+  Result OnImport(const At<Import>& value) {
+    module.imports.push_back(value);
+    return Result::Ok;
+  }
+
+  Result BeginFunctionSection(LazyFunctionSection sec) {
+    Reserve(module.functions, sec);
+    // Each defined function should have a body in the code section.
+    Reserve(module.codes, sec);
+    return Result::Ok;
+  }
+
+  Result OnFunction(const At<Function>& value) {
+    module.functions.push_back(value);
+    return Result::Ok;
+  }
+
+  Result BeginTableSection(LazyTableSection sec) {
+    Reserve(module.tables, sec);
+    return Result::Ok;
+  }
+
+  Result OnTable(const At<Table>& value) {
+    module.tables.push_back(value);
+    return Result::Ok;
+  }
+
+  Result BeginMemorySection(LazyMemorySection sec) {
+    Reserve(module.memories, sec);
+    return Result::Ok;
+  }
+
+  Result OnMemory(const At<Memory>& value) {
+    module.memories.push_back(value);
+    return Result::Ok;
+  }
+
+  Result BeginGlobalSection(LazyGlobalSection sec) {
+    Reserve(module.globals, sec);
+    return Result::Ok;
+  }
+
+  Result OnGlobal(const At<Global>& value) {
+    module.globals.push_back(value);
+    return Result::Ok;
+  }
+
+  Result BeginEventSection(LazyEventSection sec) {
+    Reserve(module.events, sec);
+    return Result::Ok;
+  }
+
+  Result OnEvent(const At<Event>& value) {
+    module.events.push_back(value);
+    return Result::Ok;
+  }
+
+  Result BeginExportSection(LazyExportSection sec) {
+    Reserve(module.exports, sec);
+    return Result::Ok;
+  }
+
+  Result OnExport(const At<Export>& value) {
+    module.exports.push_back(value);
+    return Result::Ok;
+  }
+
+  Result OnStart(const At<Start>& value) {
+    module.start = value;
+    return Result::Ok;
+  }
+
+  Result BeginElementSection(LazyElementSection sec) {
+    Reserve(module.element_segments, sec);
+    return Result::Ok;
+  }
+
+  Result OnElement(const At<ElementSegment>& value) {
+    module.element_segments.push_back(value);
+    return Result::Ok;
+  }
+
+  Result OnDataCount(const At<DataCount>& value) {
+    module.data_count = value;
+    return Result::Ok;
+  }
+
+  Result BeginCodeSection(LazyCodeSection sec) {
+    Reserve(module.codes, sec);
+    return Result::Ok;
+  }
+
+  Result BeginCode(const At<Code>&) {
+    instructions.clear();
+    return Result::Ok;
+  }
+
+  Result OnInstruction(const At<Instruction>& value) {
+    instructions.push_back(value);
+    return Result::Ok;
+  }
+
+  Result EndCode(const At<Code>& code) {
+    module.codes.push_back(
+        At{code.loc(),
+           UnpackedCode{code->locals,
+                        UnpackedExpression{InstructionList{
+                            std::make_move_iterator(instructions.begin()),
+                            std::make_move_iterator(instructions.end())}}}});
+    return Result::Ok;
+  }
+
+  Result BeginDataSection(LazyDataSection sec) {
+    Reserve(module.data_segments, sec);
+    return Result::Ok;
+  }
+
+  Result OnData(const At<DataSegment>& value) {
+    module.data_segments.push_back(value);
+    return Result::Ok;
+  }
+
+  Module module;
+  // Scratch space for the instructions of the current function body. It is
+  // reused for each body, so its capacity only grows to the largest body.
+  InstructionList instructions;
+};
+
+}  // namespace
+
+auto ReadModuleEager(SpanU8 data, const Features& features, Errors& errors)
+    -> Module {
+  auto lazy_module = ReadModule(data, features, errors);
+  EagerModuleVisitor visitor;
+  visit::Visit(lazy_module, visitor);
+  return std::move(visitor.module);
+}
+
+}  // namespace wasp::binary
@@ -273,54 +273,135 @@ EncodedOpcode Opcode::Encode(::wasp::Opcode decoded) {
   }
 }
 
-// static
-optional<::wasp::Opcode> Opcode::Decode(u8 code, const Features& features) {
-  switch (code) {
+namespace {
+
+// The Features bit for each feature, by variable name (e.g. `bulk_memory`), so
+// it can be looked up using the `feature` field of opcode.def.
+namespace feature_bits {
+#define WASP_V(enum_, variable, flag, default_) \
+  constexpr Features::Bits variable = Features::enum_;
+#include "wasp/base/features.def"
+#undef WASP_V
+}  // namespace feature_bits
+
+constexpr Features::Bits kAllFeatureBits = 0
+#define WASP_V(enum_, variable, flag, default_) | Features::enum_
+#include "wasp/base/features.def"
+#undef WASP_V
+    ;
+
+constexpr u32 kOpcodeCount = 0
+#define WASP_V(...) +1
+#define WASP_FEATURE_V(...) +1
+#define WASP_PREFIX_V(...) +1
+#include "wasp/base/def/opcode.def"
+#undef WASP_V
+#undef WASP_FEATURE_V
+#undef WASP_PREFIX_V
+    ;
+
+// Entries are kept small so all of the tables fit easily in the cache.
+static_assert(kAllFeatureBits <= 0xffff, "Feature bits must fit in a u16");
+static_assert(kOpcodeCount < 0xffff, "Opcodes must fit in a u16");
+
+struct OpcodeInfo {
+  static constexpr u16 Invalid = 0xffff;
+
+  u16 opcode;
+  u16 required_features;
+};
+
+// Maps a one-byte code, or the code after a prefix byte, to its opcode. All
+// prefixed codes in opcode.def are less than 256, so each table is dense.
+struct OpcodeTable {
+  constexpr OpcodeTable() : entries{} {
+    for (auto& info : entries) {
+      info = {OpcodeInfo::Invalid, 0};
+    }
+  }
+
+  OpcodeInfo entries[256];
+
+  optional<::wasp::Opcode> Decode(u32 code, const Features& features) const {
+    if (code >= 256) {
+      return nullopt;
+    }
+    const auto& info = entries[code];
+    if (info.opcode == OpcodeInfo::Invalid ||
+        (features.bits() & info.required_features) != info.required_features) {
+      return nullopt;
+    }
+    return static_cast<::wasp::Opcode>(info.opcode);
+  }
+};
+
+constexpr OpcodeTable MakeOpcodeTable() {
+  OpcodeTable table;
 #define WASP_V(prefix, code, Name, str) \
-  case code:                            \
-    return ::wasp::Opcode::Name;
+  table.entries[code] = {u16(::wasp::Opcode::Name), 0};
 #define WASP_FEATURE_V(prefix, code, Name, str, feature) \
-  case code:                                             \
-    if (features.feature##_enabled()) {                  \
-      return ::wasp::Opcode::Name;                       \
-    }                                                    \
-    break;
+  table.entries[code] = {u16(::wasp::Opcode::Name),      \
+                         u16(feature_bits::feature)};
 #define WASP_PREFIX_V(...) /* Invalid. */
 #include "wasp/base/def/opcode.def"
 #undef WASP_V
 #undef WASP_FEATURE_V
 #undef WASP_PREFIX_V
-    default:
-      break;
-  }
-  return nullopt;
+  return table;
 }
 
-constexpr u64 MakePrefixCode(u8 prefix, u32 code) {
-  return (u64{prefix} << 32) | code;
-}
-
-// static
-optional<::wasp::Opcode> Opcode::Decode(u8 prefix,
-                                        u32 code,
-                                        const Features& features) {
-  switch (MakePrefixCode(prefix, code)) {
+constexpr OpcodeTable MakePrefixOpcodeTable(u8 table_prefix) {
+  OpcodeTable table;
 #define WASP_V(...) /* Invalid. */
 #define WASP_FEATURE_V(...) /* Invalid. */
 #define WASP_PREFIX_V(prefix, code, Name, str, feature) \
-  case MakePrefixCode(prefix, code):                    \
-    if (features.feature##_enabled()) {                 \
-      return ::wasp::Opcode::Name;                      \
-    }                                                   \
-    break;
+  if (prefix == table_prefix) {                         \
+    table.entries[code] = {u16(::wasp::Opcode::Name),   \
+                           u16(feature_bits::feature)}; \
+  }
 #include "wasp/base/def/opcode.def"
 #undef WASP_V
 #undef WASP_FEATURE_V
 #undef WASP_PREFIX_V
+  return table;
+}
+
+constexpr OpcodeTable kOpcodeTable = MakeOpcodeTable();
+constexpr OpcodeTable kGcOpcodeTable = MakePrefixOpcodeTable(Opcode::GcPrefix);
+constexpr OpcodeTable kMiscOpcodeTable =
+    MakePrefixOpcodeTable(Opcode::MiscPrefix);
+constexpr OpcodeTable kSimdOpcodeTable =
+    MakePrefixOpcodeTable(Opcode::SimdPrefix);
+constexpr OpcodeTable kThreadsOpcodeTable =
+    MakePrefixOpcodeTable(Opcode::ThreadsPrefix);
+
+}  // namespace
+
+// static
+optional<::wasp::Opcode> Opcode::Decode(u8 code, const Features& features) {
+  return kOpcodeTable.Decode(code, features);
+}
+
+// static
+optional<::wasp::Opcode> Opcode::Decode(u8 prefix,
+                                        u32 code,
+                                        const Features& features) {
+  switch (prefix) {
+    case GcPrefix:
+      return kGcOpcodeTable.Decode(code, features);
+
+    case MiscPrefix:
+      return kMiscOpcodeTable.Decode(code, features);
+
+    case SimdPrefix:
+      return kSimdOpcodeTable.Decode(code, features);
+
+    case ThreadsPrefix:
+      return kThreadsOpcodeTable.Decode(code, features);
+
     default:
-      break;
+      return nullopt;
   }
-  return nullopt;
 }
 
 // static
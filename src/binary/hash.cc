@@ -0,0 +1,128 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/binary/hash.h"
+
+#include <algorithm>
+
+#include "wasp/base/buffer.h"
+#include "wasp/base/errors_nop.h"
+#include "wasp/base/hash.h"
+#include "wasp/base/thread_pool.h"
+#include "wasp/binary/code_section_index.h"
+#include "wasp/binary/lazy_module.h"
+#include "wasp/binary/read.h"
+#include "wasp/binary/read/context.h"
+
+namespace wasp::binary {
+
+namespace {
+
+SpanU8 ToSpanU8(string_view str) {
+  return SpanU8{reinterpret_cast<const u8*>(str.data()),
+                static_cast<span_extent_t>(str.size())};
+}
+
+void AppendU64(Buffer& buffer, u64 value) {
+  for (int i = 0; i < 8; ++i) {
+    buffer.push_back(static_cast<u8>(value >> (i * 8)));
+  }
+}
+
+}  // namespace
+
+auto HashSections(LazyModule& module, ThreadPool& pool)
+    -> std::vector<SectionHash> {
+  std::vector<SectionHash> result;
+  std::vector<SpanU8> datas;
+  for (auto section : module.sections) {
+    if (section->is_known()) {
+      auto known = section->known();
+      result.push_back(SectionHash{known->id, {}, {}});
+      datas.push_back(known->data);
+    } else if (section->is_custom()) {
+      auto custom = section->custom();
+      result.push_back(SectionHash{SectionId::Custom, custom->name, {}});
+      datas.push_back(custom->data);
+    }
+  }
+
+  pool.ParallelFor(result.size(), 1, [&](unsigned, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      auto& section = result[i];
+      u64 seed = section.id == SectionId::Custom
+                     ? HashBytes(ToSpanU8(section.name)).low
+                     : static_cast<u64>(section.id);
+      section.hash = HashBytes(datas[i], seed);
+    }
+  });
+  return result;
+}
+
+auto HashFunctionBodies(const CodeSectionIndex& index, ThreadPool& pool)
+    -> std::vector<Hash128> {
+  constexpr Index kChunkSize = 64;
+  std::vector<Hash128> result(index.size());
+  const auto& offsets = index.offsets();
+  pool.ParallelFor(
+      index.size(), kChunkSize, [&](unsigned, size_t begin, size_t end) {
+        Features features;
+        ErrorsNop errors;
+        Context context{features, errors};
+        for (size_t i = begin; i < end; ++i) {
+          SpanU8 data =
+              index.data().subspan(offsets[i], offsets[i + 1] - offsets[i]);
+          // Skip the body's length; the index already checked that it
+          // matches.
+          ReadLength(&data, context);
+          result[i] = HashBytes(data);
+        }
+      });
+  return result;
+}
+
+auto HashModule(const std::vector<SectionHash>& sections,
+                const std::vector<string_view>& ignored_custom_sections)
+    -> Hash128 {
+  Buffer buffer;
+  buffer.reserve(sections.size() * 17);
+  for (const auto& section : sections) {
+    if (section.id == SectionId::Custom &&
+        std::find(ignored_custom_sections.begin(),
+                  ignored_custom_sections.end(),
+                  section.name) != ignored_custom_sections.end()) {
+      continue;
+    }
+    buffer.push_back(static_cast<u8>(section.id));
+    AppendU64(buffer, section.hash.low);
+    AppendU64(buffer, section.hash.high);
+  }
+  return HashBytes(buffer);
+}
+
+auto HashModule(LazyModule& module,
+                ThreadPool& pool,
+                const std::vector<string_view>& ignored_custom_sections)
+    -> Hash128 {
+  return HashModule(HashSections(module, pool), ignored_custom_sections);
+}
+
+WASP_BINARY_HASH_STRUCTS(WASP_OPERATOR_EQ_NE_VARGS)
+
+}  // namespace wasp::binary
+
+WASP_BINARY_HASH_STRUCTS(WASP_STD_HASH_VARGS)
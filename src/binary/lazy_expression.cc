@@ -15,10 +15,65 @@
 //
 
 #include "wasp/binary/lazy_expression.h"
+
+#include "wasp/base/errors.h"
+#include "wasp/base/errors_context_guard.h"
+#include "wasp/binary/read.h"
 #include "wasp/binary/read/context.h"
+#include "wasp/binary/read/read_instruction.h"
+#include "wasp/binary/read/read_vector.h"
 
 namespace wasp::binary {
 
+namespace {
+
+// Checks the immediates without storing them, so reading does not allocate;
+// see ReadInstruction.
+struct SkipImmediates {
+  using Result = RawInstruction;
+
+  struct Skipped {};
+
+  template <typename... Ts>
+  static OptAt<RawInstruction> Make(Location loc,
+                                    SpanU8 bytes,
+                                    SpanU8 immediate_bytes,
+                                    const At<Opcode>& opcode,
+                                    const Ts&...) {
+    return At{loc, RawInstruction{opcode, bytes, immediate_bytes}};
+  }
+
+  static optional<Skipped> ReadBrTable(SpanU8* data, Context& context) {
+    ErrorsContextGuard error_guard{context.errors, *data, "br_table"};
+    if (!SkipVector<Index>(data, context, "targets") ||
+        !ReadIndex(data, context, "default target")) {
+      return nullopt;
+    }
+    return Skipped{};
+  }
+
+  static optional<Skipped> ReadSelect(SpanU8* data, Context& context) {
+    if (!SkipVector<ValueType>(data, context, "types")) {
+      return nullopt;
+    }
+    return Skipped{};
+  }
+
+  static optional<Skipped> ReadLet(SpanU8* data, Context& context) {
+    ErrorsContextGuard error_guard{context.errors, *data, "block_type"};
+    if (!Read<BlockType>(data, context)) {
+      return nullopt;
+    }
+    error_guard.PopContext();
+    if (!SkipVector<Locals>(data, context, "locals vector")) {
+      return nullopt;
+    }
+    return Skipped{};
+  }
+};
+
+}  // namespace
+
 LazyExpression ReadExpression(SpanU8 data, Context& context) {
   context.seen_final_end = false;
   return LazyExpression{data, context};
@@ -28,4 +83,39 @@ LazyExpression ReadExpression(Expression expr, Context& context) {
   return ReadExpression(expr.data, context);
 }
 
+LazyRawExpression ReadRawExpression(SpanU8 data, Context& context) {
+  context.seen_final_end = false;
+  return LazyRawExpression{data, context};
+}
+
+LazyRawExpression ReadRawExpression(Expression expr, Context& context) {
+  return ReadRawExpression(expr.data, context);
+}
+
+OptAt<RawInstruction> Read(SpanU8* data,
+                           Context& context,
+                           Tag<RawInstruction>) {
+  SkipImmediates policy;
+  return ReadInstruction(data, context, policy);
+}
+
+OptAt<Instruction> DecodeInstruction(const RawInstruction& raw,
+                                     Context& context) {
+  switch (raw.opcode) {
+    case Opcode::End:
+    case Opcode::Else:
+    case Opcode::Catch:
+      // These have no immediates, and would otherwise be checked against the
+      // (empty) block structure of the scratch context below.
+      return At{raw.data, Instruction{raw.opcode}};
+
+    default: {
+      Context scratch{context.features, context.errors};
+      scratch.declared_data_count = context.declared_data_count;
+      SpanU8 copy = raw.data;
+      return Read<Instruction>(&copy, scratch);
+    }
+  }
+}
+
 }  // namespace wasp::binary
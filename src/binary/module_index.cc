@@ -0,0 +1,357 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/binary/module_index.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+#include "wasp/base/at.h"
+#include "wasp/base/errors_nop.h"
+#include "wasp/base/file.h"
+#include "wasp/base/hash.h"
+#include "wasp/binary/lazy_module.h"
+#include "wasp/binary/lazy_module_utils.h"
+#include "wasp/binary/read/context.h"
+#include "wasp/binary/sections.h"
+
+namespace wasp::binary {
+
+namespace {
+
+constexpr u8 kMagic[] = {'\0', 'w', 'i', 'd', 'x', '\r', '\n', '\x1a'};
+constexpr u32 kVersion = 3;
+
+// Record sizes in the serialized format, used to check counts before
+// allocating.
+constexpr size_t kRangeSize = 12;
+constexpr size_t kNameEntrySize = 4 + kRangeSize;
+
+u32 Load32(const u8* p) {
+  return u32{p[0]} | (u32{p[1]} << 8) | (u32{p[2]} << 16) | (u32{p[3]} << 24);
+}
+
+class IndexWriter {
+ public:
+  explicit IndexWriter(Buffer& buffer) : buffer_{buffer} {}
+
+  void U32(u32 value) {
+    for (int i = 0; i < 4; ++i) {
+      buffer_.push_back(static_cast<u8>(value >> (i * 8)));
+    }
+  }
+
+  void U64(u64 value) {
+    for (int i = 0; i < 8; ++i) {
+      buffer_.push_back(static_cast<u8>(value >> (i * 8)));
+    }
+  }
+
+  void Range(ModuleIndex::Range range) {
+    U64(range.offset);
+    U32(range.size);
+  }
+
+ private:
+  Buffer& buffer_;
+};
+
+class IndexReader {
+ public:
+  explicit IndexReader(SpanU8 data) : data_{data} {}
+
+  bool ok() const { return ok_; }
+
+  // Returns true if `count` records of `size` bytes can still be read.
+  bool CanRead(u32 count, size_t size) {
+    ok_ = ok_ && u64{count} * size <= u64(data_.size());
+    return ok_;
+  }
+
+  u32 U32() {
+    if (!CanRead(1, 4)) {
+      return 0;
+    }
+    u32 result = Load32(data_.data());
+    remove_prefix(&data_, 4);
+    return result;
+  }
+
+  u64 U64() {
+    u64 low = U32();
+    return low | (u64{U32()} << 32);
+  }
+
+  ModuleIndex::Range Range() {
+    u64 offset = U64();
+    u32 size = U32();
+    return ModuleIndex::Range{offset, size};
+  }
+
+  bool Magic() {
+    if (!CanRead(1, sizeof(kMagic)) ||
+        !std::equal(std::begin(kMagic), std::end(kMagic), data_.begin())) {
+      return ok_ = false;
+    }
+    remove_prefix(&data_, sizeof(kMagic));
+    return true;
+  }
+
+ private:
+  SpanU8 data_;
+  bool ok_ = true;
+};
+
+ModuleIndex::Range MakeRange(SpanU8 module_data, SpanU8 span) {
+  return ModuleIndex::Range{static_cast<u64>(span.data() - module_data.data()),
+                            static_cast<u32>(span.size())};
+}
+
+ModuleIndex::Range MakeRange(SpanU8 module_data, string_view str) {
+  return MakeRange(module_data,
+                   SpanU8{reinterpret_cast<const u8*>(str.data()),
+                          static_cast<span_extent_t>(str.size())});
+}
+
+}  // namespace
+
+Index ModuleIndex::GetImportCount(ExternalKind kind) const {
+  auto i = static_cast<size_t>(kind);
+  return i < import_counts.size() ? import_counts[i] : 0;
+}
+
+auto HashModuleContents(SpanU8 data) -> u64 {
+  return HashBytes(data).low;
+}
+
+auto HashModuleLayout(SpanU8 data) -> u64 {
+  // The locations of the sections don't escape, so they can be relative to
+  // this module.
+  LocationBase location_base{data};
+  Features features;
+  features.EnableAll();
+  ErrorsNop errors;
+  LazyModule module{data, features, errors};
+
+  // Collect the bytes between the end of each section and the start of the
+  // next one's contents, starting with the module header.
+  Buffer headers;
+  const u8* header_begin = data.data();
+  auto add_header = [&](SpanU8 contents) {
+    headers.insert(headers.end(), header_begin, contents.data());
+    header_begin = contents.data() + contents.size();
+  };
+  for (auto section : module.sections) {
+    if (section->is_known()) {
+      add_header(section->known()->data);
+    } else if (section->is_custom()) {
+      add_header(section->custom()->data);
+    }
+  }
+  return HashBytes(headers).low;
+}
+
+auto GetRange(SpanU8 module_data, ModuleIndex::Range range) -> SpanU8 {
+  if (range.offset > u64(module_data.size()) ||
+      range.size > module_data.size() - range.offset) {
+    return {};
+  }
+  return module_data.subspan(range.offset, range.size);
+}
+
+auto GetString(SpanU8 module_data, ModuleIndex::Range range) -> string_view {
+  return ToStringView(GetRange(module_data, range));
+}
+
+auto BuildModuleIndex(SpanU8 data, const Features& features, Errors& errors)
+    -> ModuleIndex {
+  ModuleIndex index;
+  index.module_size = data.size();
+  index.layout_hash = HashModuleLayout(data);
+  index.content_hash = HashModuleContents(data);
+
+  LazyModule module{data, features, errors};
+  if (!(module.magic && module.version)) {
+    return index;
+  }
+
+  for (auto section : module.sections) {
+    if (!section->is_known()) {
+      continue;
+    }
+    auto known = section->known();
+    switch (known->id) {
+      case SectionId::Import:
+        for (auto import : ReadImportSection(known, module.context).sequence) {
+          auto kind = static_cast<size_t>(import->kind());
+          if (kind >= index.import_counts.size()) {
+            index.import_counts.resize(kind + 1);
+          }
+          index.import_counts[kind]++;
+        }
+        break;
+
+      case SectionId::Code: {
+        index.code_section = MakeRange(data, known->data);
+        auto code_index = ReadCodeSectionIndex(
+            known, module.context,
+            index.GetImportCount(ExternalKind::Function));
+        index.code_offsets = code_index.offsets();
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+
+  ForEachFunctionName(module, [&](const IndexNamePair& pair) {
+    index.function_names.push_back(
+        ModuleIndex::NameEntry{pair.first, MakeRange(data, pair.second)});
+  });
+  std::stable_sort(
+      index.function_names.begin(), index.function_names.end(),
+      [](const ModuleIndex::NameEntry& lhs, const ModuleIndex::NameEntry& rhs) {
+        return lhs.index < rhs.index;
+      });
+
+  return index;
+}
+
+auto WriteModuleIndex(const ModuleIndex& index) -> Buffer {
+  Buffer buffer{std::begin(kMagic), std::end(kMagic)};
+  IndexWriter writer{buffer};
+  writer.U32(kVersion);
+  writer.U64(index.module_size);
+  writer.U64(index.layout_hash);
+  writer.U64(index.content_hash);
+  writer.U32(index.code_section.has_value());
+  writer.Range(index.code_section.value_or(ModuleIndex::Range{}));
+  writer.U32(static_cast<u32>(index.import_counts.size()));
+  writer.U32(static_cast<u32>(index.function_names.size()));
+  writer.U32(static_cast<u32>(index.code_offsets.size()));
+
+  for (auto count : index.import_counts) {
+    writer.U32(count);
+  }
+  for (const auto& name : index.function_names) {
+    writer.U32(name.index);
+    writer.Range(name.name);
+  }
+  for (auto offset : index.code_offsets) {
+    writer.U32(offset);
+  }
+  return buffer;
+}
+
+auto ReadModuleIndex(SpanU8 index_data, SpanU8 module_data)
+    -> optional<ModuleIndex> {
+  IndexReader reader{index_data};
+  if (!reader.Magic() || reader.U32() != kVersion) {
+    return nullopt;
+  }
+
+  ModuleIndex index;
+  index.module_size = reader.U64();
+  index.layout_hash = reader.U64();
+  index.content_hash = reader.U64();
+  // Check the size first, since hashing the layout reads the section headers.
+  if (!reader.ok() || index.module_size != u64(module_data.size()) ||
+      index.layout_hash != HashModuleLayout(module_data)) {
+    return nullopt;
+  }
+
+  bool has_code_section = reader.U32() != 0;
+  auto code_section = reader.Range();
+  if (has_code_section) {
+    index.code_section = code_section;
+  }
+
+  u32 import_kind_count = reader.U32();
+  u32 name_count = reader.U32();
+  u32 code_offset_count = reader.U32();
+
+  if (!reader.CanRead(import_kind_count, 4)) {
+    return nullopt;
+  }
+  index.import_counts.reserve(import_kind_count);
+  for (u32 i = 0; i < import_kind_count; ++i) {
+    index.import_counts.push_back(reader.U32());
+  }
+
+  if (!reader.CanRead(name_count, kNameEntrySize)) {
+    return nullopt;
+  }
+  index.function_names.reserve(name_count);
+  for (u32 i = 0; i < name_count; ++i) {
+    Index func_index = reader.U32();
+    auto name = reader.Range();
+    // Lookups binary search the names, so they must be sorted.
+    if (i > 0 && func_index < index.function_names.back().index) {
+      return nullopt;
+    }
+    index.function_names.push_back(ModuleIndex::NameEntry{func_index, name});
+  }
+
+  if (!reader.CanRead(code_offset_count, 4)) {
+    return nullopt;
+  }
+  index.code_offsets.reserve(code_offset_count);
+  for (u32 i = 0; i < code_offset_count; ++i) {
+    index.code_offsets.push_back(reader.U32());
+  }
+
+  if (!reader.ok()) {
+    return nullopt;
+  }
+  return index;
+}
+
+bool VerifyModuleIndex(const ModuleIndex& index, SpanU8 module_data) {
+  return index.module_size == u64(module_data.size()) &&
+         index.layout_hash == HashModuleLayout(module_data) &&
+         index.content_hash == HashModuleContents(module_data);
+}
+
+auto GetModuleIndexFilename(string_view module_filename) -> std::string {
+  return std::string{module_filename} + ".waspidx";
+}
+
+auto LoadModuleIndex(string_view module_filename, SpanU8 module_data)
+    -> optional<ModuleIndex> {
+  auto optfile = ReadFile(GetModuleIndexFilename(module_filename), MapFileTag{});
+  if (!optfile) {
+    return nullopt;
+  }
+  return ReadModuleIndex(optfile->data(), module_data);
+}
+
+bool SaveModuleIndex(string_view module_filename, const ModuleIndex& index) {
+  std::ofstream fstream(GetModuleIndexFilename(module_filename),
+                        std::ios_base::out | std::ios_base::binary);
+  if (!fstream) {
+    return false;
+  }
+  auto buffer = WriteModuleIndex(index);
+  auto span = ToStringView(buffer);
+  fstream.write(span.data(), span.size());
+  return static_cast<bool>(fstream);
+}
+
+}  // namespace wasp::binary
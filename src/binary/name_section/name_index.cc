@@ -0,0 +1,284 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/binary/name_section/name_index.h"
+
+#include <algorithm>
+
+#include "wasp/base/errors_nop.h"
+#include "wasp/binary/lazy_module.h"
+#include "wasp/binary/module_index.h"
+#include "wasp/binary/name_section/sections.h"
+#include "wasp/binary/read.h"
+#include "wasp/binary/read/context.h"
+#include "wasp/binary/read/macros.h"
+#include "wasp/binary/section_directory.h"
+#include "wasp/binary/sections.h"
+
+namespace wasp::binary {
+
+namespace {
+
+constexpr Index kSampleStride = 16;
+
+OptAt<Index> ReadNameAssocIndex(SpanU8* data, Context& context) {
+  WASP_TRY_READ(name_assoc, Read<NameAssoc>(data, context));
+  return name_assoc->index;
+}
+
+// Reads the function index of an IndirectNameAssoc, and skips its name map
+// without allocating it.
+OptAt<Index> ReadIndirectNameAssocIndex(SpanU8* data, Context& context) {
+  WASP_TRY_READ(index, ReadIndex(data, context, "index"));
+  WASP_TRY_READ(count, ReadCount(data, context));
+  for (Index i = 0; i < *count; ++i) {
+    if (!Read<NameAssoc>(data, context)) {
+      return nullopt;
+    }
+  }
+  return index;
+}
+
+}  // namespace
+
+NameIndex::NameIndex(LazyModule& module)
+    : features_{module.context.features},
+      module_index_{module.index},
+      module_data_{module.data} {
+  ErrorsNop errors;
+  LazyModule copy{module.data, features_, errors};
+  SectionDirectory directory{copy};
+
+  if (!module_index_) {
+    Index imported_function_count = 0;
+    if (auto known = directory.Find(SectionId::Import)) {
+      for (auto import : ReadImportSection(*known, copy.context).sequence) {
+        if (import->kind() == ExternalKind::Function) {
+          external_names_.emplace_back(imported_function_count++,
+                                       *import->name);
+        }
+      }
+    }
+
+    if (auto known = directory.Find(SectionId::Export)) {
+      for (auto export_ : ReadExportSection(*known, copy.context).sequence) {
+        if (export_->kind == ExternalKind::Function) {
+          external_names_.emplace_back(*export_->index, *export_->name);
+        }
+      }
+    }
+
+    for (const auto& pair : external_names_) {
+      external_name_map_.emplace(pair.first, pair.second);
+    }
+  }
+
+  if (auto custom = directory.FindCustom("name")) {
+    for (auto subsection : ReadNameSection(*custom, copy.context)) {
+      if (subsection->id == NameSubsectionId::FunctionNames &&
+          !module_index_ && function_names_.data.empty()) {
+        Build(function_names_,
+              ReadFunctionNamesSubsection(*subsection, copy.context)
+                  .sequence.data(),
+              ReadNameAssocIndex, copy.context);
+      } else if (subsection->id == NameSubsectionId::LocalNames &&
+                 local_names_.data.empty()) {
+        Build(local_names_,
+              ReadLocalNamesSubsection(*subsection, copy.context)
+                  .sequence.data(),
+              ReadIndirectNameAssocIndex, copy.context);
+      }
+    }
+  }
+}
+
+void NameIndex::Build(Entries& entries,
+                      SpanU8 data,
+                      ReadEntryIndexFn read_entry_index,
+                      Context& context) {
+  entries.data = data;
+  Index count = 0;
+  Index prev_index = 0;
+  SpanU8 rest = data;
+  while (!rest.empty()) {
+    auto offset = static_cast<u32>(rest.begin() - data.begin());
+    auto index = read_entry_index(&rest, context);
+    if (!index) {
+      break;
+    }
+    if (count > 0 && *index <= prev_index) {
+      entries.sorted = false;
+    }
+    if (count % kSampleStride == 0) {
+      entries.samples.emplace_back(*index, offset);
+    }
+    prev_index = *index;
+    ++count;
+  }
+
+  if (!entries.sorted) {
+    entries.samples.clear();
+    entries.samples.shrink_to_fit();
+  }
+}
+
+optional<SpanU8> NameIndex::Find(const Entries& entries,
+                                 Index index,
+                                 ReadEntryIndexFn read_entry_index) const {
+  SpanU8 data = entries.data;
+  if (entries.sorted) {
+    auto iter = std::upper_bound(
+        entries.samples.begin(), entries.samples.end(), index,
+        [](Index index, const std::pair<Index, u32>& sample) {
+          return index < sample.first;
+        });
+    if (iter == entries.samples.begin()) {
+      return nullopt;
+    }
+    data = data.subspan((iter - 1)->second);
+  }
+
+  ErrorsNop errors;
+  Context context{features_, errors};
+  while (!data.empty()) {
+    SpanU8 rest = data;
+    auto entry_index = read_entry_index(&rest, context);
+    if (!entry_index || (entries.sorted && *entry_index > index)) {
+      break;
+    }
+    if (*entry_index == index) {
+      return data;
+    }
+    data = rest;
+  }
+  return nullopt;
+}
+
+template <typename F>
+void NameIndex::ForEachFunctionName(F&& f) const {
+  if (module_index_) {
+    for (const auto& entry : module_index_->function_names) {
+      f(entry.index, GetString(module_data_, entry.name));
+    }
+    return;
+  }
+
+  for (const auto& pair : external_names_) {
+    f(pair.first, pair.second);
+  }
+
+  ErrorsNop errors;
+  Context context{features_, errors};
+  SpanU8 data = function_names_.data;
+  while (!data.empty()) {
+    auto name_assoc = Read<NameAssoc>(&data, context);
+    if (!name_assoc) {
+      break;
+    }
+    f(name_assoc->value().index, name_assoc->value().name);
+  }
+}
+
+optional<string_view> NameIndex::GetFunctionName(Index function) const {
+  if (module_index_) {
+    // The names are sorted by index, and the first name of a function wins.
+    const auto& names = module_index_->function_names;
+    auto iter = std::lower_bound(
+        names.begin(), names.end(), function,
+        [](const ModuleIndex::NameEntry& entry, Index index) {
+          return entry.index < index;
+        });
+    if (iter == names.end() || iter->index != function) {
+      return nullopt;
+    }
+    return GetString(module_data_, iter->name);
+  }
+
+  auto iter = external_name_map_.find(function);
+  if (iter != external_name_map_.end()) {
+    return iter->second;
+  }
+
+  if (auto data = Find(function_names_, function, ReadNameAssocIndex)) {
+    ErrorsNop errors;
+    Context context{features_, errors};
+    if (auto name_assoc = Read<NameAssoc>(&*data, context)) {
+      return name_assoc->value().name;
+    }
+  }
+  return nullopt;
+}
+
+optional<string_view> NameIndex::GetLocalName(Index function,
+                                              Index local) const {
+  auto data = Find(local_names_, function, ReadIndirectNameAssocIndex);
+  if (!data) {
+    return nullopt;
+  }
+
+  ErrorsNop errors;
+  Context context{features_, errors};
+  ReadIndex(&*data, context, "index");
+  auto count = ReadCount(&*data, context);
+  if (!count) {
+    return nullopt;
+  }
+  for (Index i = 0; i < *count; ++i) {
+    auto name_assoc = Read<NameAssoc>(&*data, context);
+    if (!name_assoc) {
+      break;
+    }
+    if (name_assoc->value().index == local) {
+      return name_assoc->value().name;
+    }
+  }
+  return nullopt;
+}
+
+optional<Index> NameIndex::FindFunction(string_view name) const {
+  if (has_function_name_map_) {
+    auto iter = function_name_map_.find(name);
+    if (iter == function_name_map_.end()) {
+      return nullopt;
+    }
+    return iter->second;
+  }
+
+  optional<Index> result;
+  ForEachFunctionName([&](Index index, string_view function_name) {
+    if (function_name == name && (!result || index < *result)) {
+      result = index;
+    }
+  });
+  return result;
+}
+
+void NameIndex::BuildFunctionNameMap() {
+  if (has_function_name_map_) {
+    return;
+  }
+
+  ForEachFunctionName([&](Index index, string_view name) {
+    auto [iter, inserted] = function_name_map_.emplace(name, index);
+    if (!inserted && index < iter->second) {
+      iter->second = index;
+    }
+  });
+  has_function_name_map_ = true;
+}
+
+}  // namespace wasp::binary
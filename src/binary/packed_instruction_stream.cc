@@ -0,0 +1,782 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/binary/packed_instruction_stream.h"
+
+#include <cassert>
+#include <type_traits>
+#include <utility>
+
+#include "wasp/base/bitcast.h"
+#include "wasp/base/v128.h"
+#include "wasp/base/variant.h"
+#include "wasp/binary/read.h"
+#include "wasp/binary/read/location_guard.h"
+#include "wasp/binary/read/read_instruction.h"
+#include "wasp/binary/read/read_vector.h"
+
+namespace wasp::binary {
+
+namespace {
+
+// Each instruction is encoded as:
+//
+//   opcode | (immediate kind << 24)
+//   instruction location  (2 words)
+//   opcode location       (2 words)
+//   immediate location    (2 words, only if there is an immediate)
+//   immediate             (variable)
+//
+// A location is stored as an offset into the source and a size. A missing
+// location uses kNoLocation as its offset.
+constexpr u32 kKindShift = 24;
+constexpr u32 kOpcodeMask = (1u << kKindShift) - 1;
+constexpr u32 kNoLocation = ~0u;
+constexpr size_t kLocationWords = 2;
+constexpr size_t kImmediateOffset = 1 + 2 * kLocationWords;
+constexpr size_t kImmediateValueOffset = kImmediateOffset + kLocationWords;
+
+using Immediate = decltype(Instruction::immediate);
+
+static_assert(variant_size<Immediate>::value <= (1u << (32 - kKindShift)),
+              "Too many immediate kinds");
+
+// The kind of immediate `T`, i.e. its index in Instruction::immediate.
+template <typename T, size_t I = 0>
+constexpr u32 ImmediateKind() {
+  if constexpr (std::is_same_v<T, variant_alternative_t<I, Immediate>>) {
+    return I;
+  } else {
+    return ImmediateKind<T, I + 1>();
+  }
+}
+
+// Writes `loc` as an offset into `source` and a size.
+void PackLocation(SpanU8 source, Location loc, u32* out) {
+  auto* begin = source.data();
+  auto* end = begin + source.size();
+  if (loc.data() != nullptr && loc.data() >= begin &&
+      loc.data() + loc.size() <= end) {
+    out[0] = static_cast<u32>(loc.data() - begin);
+    out[1] = static_cast<u32>(loc.size());
+  } else {
+    out[0] = kNoLocation;
+    out[1] = 0;
+  }
+}
+
+class Packer {
+ public:
+  explicit Packer(SpanU8 source, std::vector<u32>& words)
+      : source_{source}, words_{words} {}
+
+  void Put(u32 value) { words_.push_back(value); }
+  void Put(s32 value) { Put(Bitcast<u32>(value)); }
+  void Put(u8 value) { Put(u32{value}); }
+  void Put(u64 value) {
+    Put(static_cast<u32>(value));
+    Put(static_cast<u32>(value >> 32));
+  }
+  void Put(s64 value) { Put(Bitcast<u64>(value)); }
+  void Put(f32 value) { Put(Bitcast<u32>(value)); }
+  void Put(f64 value) { Put(Bitcast<u64>(value)); }
+
+  void Put(const v128& value) {
+    for (auto word : value.as<u32x4>()) {
+      Put(word);
+    }
+  }
+
+  void Put(const ShuffleImmediate& value) {
+    Put(v128{value});
+  }
+
+  template <typename T>
+  std::enable_if_t<std::is_enum_v<T>> Put(T value) {
+    Put(static_cast<u32>(value));
+  }
+
+  void Put(Location loc) {
+    u32 words[kLocationWords];
+    PackLocation(source_, loc, words);
+    Put(words[0]);
+    Put(words[1]);
+  }
+
+  template <typename T>
+  void Put(const At<T>& value) {
+    Put(value.loc());
+    Put(value.value());
+  }
+
+  template <typename T>
+  void Put(const std::vector<At<T>>& values) {
+    Put(static_cast<u32>(values.size()));
+    for (const auto& value : values) {
+      Put(value);
+    }
+  }
+
+  void Put(const HeapType& value) {
+    Put(static_cast<u32>(value.type.index()));
+    visit([&](const auto& x) { Put(x); }, value.type);
+  }
+
+  void Put(const RefType& value) {
+    Put(value.heap_type);
+    Put(value.null);
+  }
+
+  void Put(const ReferenceType& value) {
+    Put(static_cast<u32>(value.type.index()));
+    visit([&](const auto& x) { Put(x); }, value.type);
+  }
+
+  void Put(const Rtt& value) {
+    Put(value.depth);
+    Put(value.type);
+  }
+
+  void Put(const ValueType& value) {
+    Put(static_cast<u32>(value.type.index()));
+    visit([&](const auto& x) { Put(x); }, value.type);
+  }
+
+  void Put(const VoidType&) {}
+
+  void Put(const BlockType& value) {
+    Put(static_cast<u32>(value.type.index()));
+    visit([&](const auto& x) { Put(x); }, value.type);
+  }
+
+  void Put(const Locals& value) {
+    Put(value.count);
+    Put(value.type);
+  }
+
+  void Put(const HeapType2Immediate& value) {
+    Put(value.parent);
+    Put(value.child);
+  }
+
+  void Put(const BrOnCastImmediate& value) {
+    Put(value.target);
+    Put(value.types);
+  }
+
+  void Put(const BrOnExnImmediate& value) {
+    Put(value.target);
+    Put(value.event_index);
+  }
+
+  // The target values are stored contiguously so they can be viewed as a
+  // span<const Index>; their locations follow the default target.
+  void Put(const BrTableImmediate& value) {
+    Put(static_cast<u32>(value.targets.size()));
+    for (const auto& target : value.targets) {
+      Put(target.value());
+    }
+    Put(value.default_target);
+    for (const auto& target : value.targets) {
+      Put(target.loc());
+    }
+  }
+
+  void Put(const CallIndirectImmediate& value) {
+    Put(value.index);
+    Put(value.table_index);
+  }
+
+  void Put(const CopyImmediate& value) {
+    Put(value.dst_index);
+    Put(value.src_index);
+  }
+
+  void Put(const InitImmediate& value) {
+    Put(value.segment_index);
+    Put(value.dst_index);
+  }
+
+  void Put(const LetImmediate& value) {
+    Put(value.block_type);
+    Put(value.locals);
+  }
+
+  void Put(const MemArgImmediate& value) {
+    Put(value.align_log2);
+    Put(value.offset);
+  }
+
+  void Put(const RttSubImmediate& value) {
+    Put(value.depth);
+    Put(value.types);
+  }
+
+  void Put(const StructFieldImmediate& value) {
+    Put(value.struct_);
+    Put(value.field);
+  }
+
+ private:
+  SpanU8 source_;
+  std::vector<u32>& words_;
+};
+
+class Unpacker {
+ public:
+  explicit Unpacker(SpanU8 source, const u32* ptr)
+      : source_{source}, ptr_{ptr} {}
+
+  u32 Get(Tag<u32>) { return *ptr_++; }
+  s32 Get(Tag<s32>) { return Bitcast<s32>(Get(Tag<u32>{})); }
+  u8 Get(Tag<u8>) { return static_cast<u8>(Get(Tag<u32>{})); }
+  u64 Get(Tag<u64>) {
+    u64 lo = Get(Tag<u32>{});
+    u64 hi = Get(Tag<u32>{});
+    return (hi << 32) | lo;
+  }
+  s64 Get(Tag<s64>) { return Bitcast<s64>(Get(Tag<u64>{})); }
+  f32 Get(Tag<f32>) { return Bitcast<f32>(Get(Tag<u32>{})); }
+  f64 Get(Tag<f64>) { return Bitcast<f64>(Get(Tag<u64>{})); }
+
+  v128 Get(Tag<v128>) {
+    u32x4 words;
+    for (auto& word : words) {
+      word = Get(Tag<u32>{});
+    }
+    return v128{words};
+  }
+
+  ShuffleImmediate Get(Tag<ShuffleImmediate>) {
+    return Get(Tag<v128>{}).as<u8x16>();
+  }
+
+  template <typename T>
+  std::enable_if_t<std::is_enum_v<T>, T> Get(Tag<T>) {
+    return static_cast<T>(Get(Tag<u32>{}));
+  }
+
+  Location Get(Tag<Location>) {
+    auto offset = Get(Tag<u32>{});
+    auto size = Get(Tag<u32>{});
+    if (offset == kNoLocation) {
+      return Location{};
+    }
+    return Location{source_.data() + offset, size};
+  }
+
+  template <typename T>
+  At<T> Get(Tag<At<T>>) {
+    auto loc = Get(Tag<Location>{});
+    return At<T>{loc, Get(Tag<T>{})};
+  }
+
+  template <typename T>
+  std::vector<At<T>> Get(Tag<std::vector<At<T>>>) {
+    auto count = Get(Tag<u32>{});
+    std::vector<At<T>> result;
+    result.reserve(count);
+    for (u32 i = 0; i < count; ++i) {
+      result.push_back(Get(Tag<At<T>>{}));
+    }
+    return result;
+  }
+
+  // Reads a value of type T stored as one alternative of a variant, where the
+  // alternative index precedes the value.
+  template <typename T, typename Variant, size_t I = 0>
+  T GetVariant(u32 index) {
+    if constexpr (I < variant_size<Variant>::value) {
+      if (index == I) {
+        return T{Get(Tag<variant_alternative_t<I, Variant>>{})};
+      }
+      return GetVariant<T, Variant, I + 1>(index);
+    } else {
+      assert(false);
+      return T{Get(Tag<variant_alternative_t<0, Variant>>{})};
+    }
+  }
+
+  HeapType Get(Tag<HeapType>) {
+    return GetVariant<HeapType, decltype(HeapType::type)>(Get(Tag<u32>{}));
+  }
+
+  RefType Get(Tag<RefType>) {
+    auto heap_type = Get(Tag<At<HeapType>>{});
+    return RefType{heap_type, Get(Tag<Null>{})};
+  }
+
+  ReferenceType Get(Tag<ReferenceType>) {
+    return GetVariant<ReferenceType, decltype(ReferenceType::type)>(
+        Get(Tag<u32>{}));
+  }
+
+  Rtt Get(Tag<Rtt>) {
+    auto depth = Get(Tag<At<Index>>{});
+    return Rtt{depth, Get(Tag<At<HeapType>>{})};
+  }
+
+  ValueType Get(Tag<ValueType>) {
+    return GetVariant<ValueType, decltype(ValueType::type)>(Get(Tag<u32>{}));
+  }
+
+  VoidType Get(Tag<VoidType>) { return VoidType{}; }
+
+  BlockType Get(Tag<BlockType>) {
+    return GetVariant<BlockType, decltype(BlockType::type)>(Get(Tag<u32>{}));
+  }
+
+  Locals Get(Tag<Locals>) {
+    auto count = Get(Tag<At<Index>>{});
+    return Locals{count, Get(Tag<At<ValueType>>{})};
+  }
+
+  HeapType2Immediate Get(Tag<HeapType2Immediate>) {
+    auto parent = Get(Tag<At<HeapType>>{});
+    return HeapType2Immediate{parent, Get(Tag<At<HeapType>>{})};
+  }
+
+  BrOnCastImmediate Get(Tag<BrOnCastImmediate>) {
+    auto target = Get(Tag<At<Index>>{});
+    return BrOnCastImmediate{target, Get(Tag<HeapType2Immediate>{})};
+  }
+
+  BrOnExnImmediate Get(Tag<BrOnExnImmediate>) {
+    auto target = Get(Tag<At<Index>>{});
+    return BrOnExnImmediate{target, Get(Tag<At<Index>>{})};
+  }
+
+  BrTableImmediate Get(Tag<BrTableImmediate>) {
+    BrTableImmediate result;
+    result.targets.resize(Get(Tag<u32>{}));
+    for (auto& target : result.targets) {
+      target = Get(Tag<Index>{});
+    }
+    result.default_target = Get(Tag<At<Index>>{});
+    for (auto& target : result.targets) {
+      target.set_loc(Get(Tag<Location>{}));
+    }
+    return result;
+  }
+
+  CallIndirectImmediate Get(Tag<CallIndirectImmediate>) {
+    auto index = Get(Tag<At<Index>>{});
+    return CallIndirectImmediate{index, Get(Tag<At<Index>>{})};
+  }
+
+  CopyImmediate Get(Tag<CopyImmediate>) {
+    auto dst_index = Get(Tag<At<Index>>{});
+    return CopyImmediate{dst_index, Get(Tag<At<Index>>{})};
+  }
+
+  InitImmediate Get(Tag<InitImmediate>) {
+    auto segment_index = Get(Tag<At<Index>>{});
+    return InitImmediate{segment_index, Get(Tag<At<Index>>{})};
+  }
+
+  LetImmediate Get(Tag<LetImmediate>) {
+    auto block_type = Get(Tag<At<BlockType>>{});
+    return LetImmediate{block_type, Get(Tag<LocalsList>{})};
+  }
+
+  MemArgImmediate Get(Tag<MemArgImmediate>) {
+    auto align_log2 = Get(Tag<At<u32>>{});
+    return MemArgImmediate{align_log2, Get(Tag<At<u32>>{})};
+  }
+
+  RttSubImmediate Get(Tag<RttSubImmediate>) {
+    auto depth = Get(Tag<At<Index>>{});
+    return RttSubImmediate{depth, Get(Tag<HeapType2Immediate>{})};
+  }
+
+  StructFieldImmediate Get(Tag<StructFieldImmediate>) {
+    auto struct_ = Get(Tag<At<Index>>{});
+    return StructFieldImmediate{struct_, Get(Tag<At<Index>>{})};
+  }
+
+ private:
+  SpanU8 source_;
+  const u32* ptr_;
+};
+
+template <size_t I = 1>
+At<Instruction> UnpackInstruction(Location loc,
+                                  At<Opcode> opcode,
+                                  u32 kind,
+                                  Unpacker& unpacker) {
+  if constexpr (I < variant_size<Immediate>::value) {
+    if (kind == I) {
+      auto immediate = unpacker.Get(Tag<variant_alternative_t<I, Immediate>>{});
+      return At{loc, Instruction{opcode, immediate}};
+    }
+    return UnpackInstruction<I + 1>(loc, opcode, kind, unpacker);
+  } else {
+    return At{loc, Instruction{opcode}};
+  }
+}
+
+}  // namespace
+
+PackedInstruction::PackedInstruction(const PackedInstructionStream* stream,
+                                     const u32* record)
+    : stream_{stream}, record_{record} {}
+
+auto PackedInstruction::opcode() const -> At<Opcode> {
+  Unpacker unpacker{stream_->source_, record_ + 1 + kLocationWords};
+  auto loc = unpacker.Get(Tag<Location>{});
+  return At{loc, static_cast<Opcode>(record_[0] & kOpcodeMask)};
+}
+
+auto PackedInstruction::data() const -> SpanU8 {
+  return Unpacker{stream_->source_, record_ + 1}.Get(Tag<Location>{});
+}
+
+auto PackedInstruction::loc() const -> Location {
+  return data();
+}
+
+u32 PackedInstruction::immediate_kind() const {
+  return record_[0] >> kKindShift;
+}
+
+bool PackedInstruction::has_no_immediate() const {
+  return immediate_kind() == ImmediateKind<monostate>();
+}
+
+bool PackedInstruction::has_index_immediate() const {
+  return immediate_kind() == ImmediateKind<At<Index>>();
+}
+
+bool PackedInstruction::has_br_table_immediate() const {
+  return immediate_kind() == ImmediateKind<At<BrTableImmediate>>();
+}
+
+template <typename T>
+auto PackedInstruction::GetImmediate() const -> At<T> {
+  assert(immediate_kind() == ImmediateKind<At<T>>());
+  return Unpacker{stream_->source_, record_ + kImmediateOffset}.Get(
+      Tag<At<T>>{});
+}
+
+auto PackedInstruction::s32_immediate() const -> At<s32> {
+  return GetImmediate<s32>();
+}
+
+auto PackedInstruction::s64_immediate() const -> At<s64> {
+  return GetImmediate<s64>();
+}
+
+auto PackedInstruction::f32_immediate() const -> At<f32> {
+  return GetImmediate<f32>();
+}
+
+auto PackedInstruction::f64_immediate() const -> At<f64> {
+  return GetImmediate<f64>();
+}
+
+auto PackedInstruction::v128_immediate() const -> At<v128> {
+  return GetImmediate<v128>();
+}
+
+auto PackedInstruction::index_immediate() const -> At<Index> {
+  return GetImmediate<Index>();
+}
+
+auto PackedInstruction::block_type_immediate() const -> At<BlockType> {
+  return GetImmediate<BlockType>();
+}
+
+auto PackedInstruction::br_on_cast_immediate() const -> At<BrOnCastImmediate> {
+  return GetImmediate<BrOnCastImmediate>();
+}
+
+auto PackedInstruction::br_on_exn_immediate() const -> At<BrOnExnImmediate> {
+  return GetImmediate<BrOnExnImmediate>();
+}
+
+auto PackedInstruction::br_table_immediate() const -> At<BrTableImmediate> {
+  return GetImmediate<BrTableImmediate>();
+}
+
+auto PackedInstruction::call_indirect_immediate() const
+    -> At<CallIndirectImmediate> {
+  return GetImmediate<CallIndirectImmediate>();
+}
+
+auto PackedInstruction::copy_immediate() const -> At<CopyImmediate> {
+  return GetImmediate<CopyImmediate>();
+}
+
+auto PackedInstruction::heap_type_immediate() const -> At<HeapType> {
+  return GetImmediate<HeapType>();
+}
+
+auto PackedInstruction::heap_type_2_immediate() const
+    -> At<HeapType2Immediate> {
+  return GetImmediate<HeapType2Immediate>();
+}
+
+auto PackedInstruction::init_immediate() const -> At<InitImmediate> {
+  return GetImmediate<InitImmediate>();
+}
+
+auto PackedInstruction::let_immediate() const -> At<LetImmediate> {
+  return GetImmediate<LetImmediate>();
+}
+
+auto PackedInstruction::mem_arg_immediate() const -> At<MemArgImmediate> {
+  return GetImmediate<MemArgImmediate>();
+}
+
+auto PackedInstruction::rtt_sub_immediate() const -> At<RttSubImmediate> {
+  return GetImmediate<RttSubImmediate>();
+}
+
+auto PackedInstruction::select_immediate() const -> At<SelectImmediate> {
+  return GetImmediate<SelectImmediate>();
+}
+
+auto PackedInstruction::shuffle_immediate() const -> At<ShuffleImmediate> {
+  return GetImmediate<ShuffleImmediate>();
+}
+
+auto PackedInstruction::simd_lane_immediate() const -> At<SimdLaneImmediate> {
+  return GetImmediate<SimdLaneImmediate>();
+}
+
+auto PackedInstruction::struct_field_immediate() const
+    -> At<StructFieldImmediate> {
+  return GetImmediate<StructFieldImmediate>();
+}
+
+auto PackedInstruction::br_table_targets() const -> span<const Index> {
+  assert(has_br_table_immediate());
+  const u32* ptr = record_ + kImmediateValueOffset;
+  return span<const Index>{ptr + 1, *ptr};
+}
+
+auto PackedInstruction::br_table_default_target() const -> At<Index> {
+  auto targets = br_table_targets();
+  return Unpacker{stream_->source_, targets.data() + targets.size()}.Get(
+      Tag<At<Index>>{});
+}
+
+auto PackedInstruction::ToInstruction() const -> At<Instruction> {
+  Unpacker unpacker{stream_->source_, record_ + kImmediateOffset};
+  return UnpackInstruction(loc(), opcode(), immediate_kind(), unpacker);
+}
+
+PackedInstructionStream::PackedInstructionStream(SpanU8 source)
+    : source_{source} {}
+
+void PackedInstructionStream::clear() {
+  words_.clear();
+  offsets_.clear();
+}
+
+template <typename... Ts>
+void PackedInstructionStream::AppendRecord(Location data,
+                                           const At<Opcode>& opcode,
+                                           const Ts&... immediate) {
+  static_assert(sizeof...(Ts) <= 1, "At most one immediate");
+  u32 kind = (ImmediateKind<Ts>() + ... + 0);
+  assert(static_cast<u32>(opcode.value()) <= kOpcodeMask);
+
+  offsets_.push_back(static_cast<u32>(words_.size()));
+  Packer packer{source_, words_};
+  packer.Put(static_cast<u32>(opcode.value()) | (kind << kKindShift));
+  packer.Put(data);
+  packer.Put(opcode.loc());
+  (packer.Put(immediate), ...);
+}
+
+void PackedInstructionStream::Append(const At<Instruction>& instr) {
+  visit(
+      [&](const auto& immediate) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(immediate)>,
+                                     monostate>) {
+          AppendRecord(instr.loc(), instr->opcode);
+        } else {
+          AppendRecord(instr.loc(), instr->opcode, immediate);
+        }
+      },
+      instr->immediate);
+}
+
+PackedInstruction PackedInstructionStream::operator[](Index index) const {
+  assert(index < size());
+  return PackedInstruction{this, words_.data() + offsets_[index]};
+}
+
+auto PackedInstructionStream::begin() const -> iterator {
+  return iterator{this, 0};
+}
+
+auto PackedInstructionStream::end() const -> iterator {
+  return iterator{this, size()};
+}
+
+// A ReadInstruction policy that appends each instruction to a stream. The
+// instruction's bytes are recorded as its location, so they are available even
+// when At<T> does not store locations.
+//
+// The immediates that hold a vector (br_table, select and let) are packed as
+// they are read, instead of being collected in a std::vector first. Their
+// record's header is reserved before the immediate, and filled in by Make.
+struct PackedInstructionStream::ReadPolicy {
+  using Result = Index;
+
+  // An immediate that has already been packed into the current record.
+  struct Packed {
+    u32 kind;
+  };
+
+  template <typename... Ts>
+  OptAt<Index> Make(Location loc,
+                    SpanU8 bytes,
+                    SpanU8 /*immediate_bytes*/,
+                    const At<Opcode>& opcode,
+                    const Ts&... immediate) {
+    stream.AppendRecord(bytes, opcode, immediate...);
+    return At{loc, stream.size() - 1};
+  }
+
+  OptAt<Index> Make(Location loc,
+                    SpanU8 bytes,
+                    SpanU8 /*immediate_bytes*/,
+                    const At<Opcode>& opcode,
+                    const At<Packed>& immediate) {
+    assert(static_cast<u32>(opcode.value()) <= kOpcodeMask);
+    u32* record = stream.words_.data() + stream.offsets_.back();
+    record[0] =
+        static_cast<u32>(opcode.value()) | (immediate->kind << kKindShift);
+    PackLocation(stream.source_, bytes, record + 1);
+    PackLocation(stream.source_, opcode.loc(), record + 1 + kLocationWords);
+    PackLocation(stream.source_, immediate.loc(), record + kImmediateOffset);
+    return At{loc, stream.size() - 1};
+  }
+
+  OptAt<Packed> ReadBrTable(SpanU8* data, Context& context) {
+    ErrorsContextGuard error_guard{context.errors, *data, "br_table"};
+    LocationGuard guard{data};
+    BeginRecord();
+    // The target values are stored contiguously, and their locations after
+    // the default target; see Packer::Put(const BrTableImmediate&).
+    target_locs.clear();
+    auto count_index = stream.words_.size();
+    packer().Put(u32{0});
+    auto count = ReadVectorElements<Index>(
+        data, context, "targets", [&](const At<Index>& target) {
+          packer().Put(target.value());
+          target_locs.push_back(target.loc());
+        });
+    if (!count) {
+      return CancelRecord();
+    }
+    stream.words_[count_index] = *count;
+    auto default_target = ReadIndex(data, context, "default target");
+    if (!default_target) {
+      return CancelRecord();
+    }
+    packer().Put(*default_target);
+    for (auto loc : target_locs) {
+      packer().Put(loc);
+    }
+    return At{guard.range(data),
+              Packed{ImmediateKind<At<BrTableImmediate>>()}};
+  }
+
+  OptAt<Packed> ReadSelect(SpanU8* data, Context& context) {
+    LocationGuard guard{data};
+    BeginRecord();
+    if (!PutVector<ValueType>(data, context, "types")) {
+      return CancelRecord();
+    }
+    return At{guard.range(data), Packed{ImmediateKind<At<SelectImmediate>>()}};
+  }
+
+  OptAt<Packed> ReadLet(SpanU8* data, Context& context) {
+    LocationGuard guard{data};
+    BeginRecord();
+    ErrorsContextGuard error_guard{context.errors, *data, "block_type"};
+    auto block_type = Read<BlockType>(data, context);
+    if (!block_type) {
+      return CancelRecord();
+    }
+    error_guard.PopContext();
+    packer().Put(*block_type);
+    if (!PutVector<Locals>(data, context, "locals vector")) {
+      return CancelRecord();
+    }
+    return At{guard.range(data), Packed{ImmediateKind<At<LetImmediate>>()}};
+  }
+
+  Packer packer() { return Packer{stream.source_, stream.words_}; }
+
+  // Starts a new record, leaving room for its header and the immediate's
+  // location.
+  void BeginRecord() {
+    stream.offsets_.push_back(static_cast<u32>(stream.words_.size()));
+    stream.words_.resize(stream.words_.size() + kImmediateValueOffset);
+  }
+
+  // Removes the record started by BeginRecord, after a read error.
+  nullopt_t CancelRecord() {
+    stream.words_.resize(stream.offsets_.back());
+    stream.offsets_.pop_back();
+    return nullopt;
+  }
+
+  // Packs a vector in the same form as Packer::Put(const std::vector<At<T>>&).
+  template <typename T>
+  bool PutVector(SpanU8* data, Context& context, string_view desc) {
+    auto count_index = stream.words_.size();
+    packer().Put(u32{0});
+    auto count = ReadVectorElements<T>(
+        data, context, desc, [&](const At<T>& elt) { packer().Put(elt); });
+    if (!count) {
+      return false;
+    }
+    stream.words_[count_index] = *count;
+    return true;
+  }
+
+  PackedInstructionStream& stream;
+  // Scratch space for the br_table target locations, reused between
+  // instructions.
+  std::vector<Location> target_locs;
+};
+
+auto ReadPackedInstructionStream(SpanU8 data, Context& context)
+    -> PackedInstructionStream {
+  PackedInstructionStream result{data};
+  PackedInstructionStream::ReadPolicy policy{result, {}};
+  context.seen_final_end = false;
+  while (!data.empty()) {
+    if (!ReadInstruction(&data, context, policy)) {
+      break;
+    }
+  }
+  return result;
+}
+
+auto ReadPackedInstructionStream(Expression expr, Context& context)
+    -> PackedInstructionStream {
+  return ReadPackedInstructionStream(expr.data, context);
+}
+
+}  // namespace wasp::binary
@@ -0,0 +1,138 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/binary/parallel_read.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "wasp/base/errors.h"
+#include "wasp/base/recording_errors.h"
+#include "wasp/base/thread_pool.h"
+#include "wasp/binary/code_section_index.h"
+#include "wasp/binary/lazy_expression.h"
+#include "wasp/binary/read.h"
+#include "wasp/binary/read/context.h"
+
+namespace wasp::binary {
+
+namespace {
+
+// Bodies are handed out to the workers in chunks, to amortize the cost of
+// synchronizing with the calling thread.
+constexpr size_t kFunctionsPerChunk = 16;
+
+struct Result {
+  FunctionBody body;
+  RecordingErrors errors;
+};
+
+void DecodeFunctionBody(SpanU8 data,
+                        const Features& features,
+                        optional<Index> declared_data_count,
+                        bool track_context,
+                        Result* result) {
+  result->errors = RecordingErrors{track_context};
+  auto& errors = result->errors;
+  Context context{features, errors};
+  // memory.init and data.drop check that the module has a data count section.
+  context.declared_data_count = declared_data_count;
+
+  auto& body = result->body;
+  body.code = Read<Code>(&data, context);
+  if (body.code) {
+    for (auto&& instr : ReadExpression(*body.code->value().body, context)) {
+      body.instructions.push_back(instr);
+    }
+    EndCode(body.code->value().body->data.last(0), context);
+  }
+  body.ok = !errors.HasError();
+}
+
+}  // namespace
+
+void ForEachFunctionBodyParallel(const CodeSectionIndex& index,
+                                 Context& context,
+                                 ThreadPool& pool,
+                                 const FunctionBodyCallback& callback) {
+  const size_t count = index.size();
+  if (count == 0) {
+    return;
+  }
+
+  const size_t chunk_count =
+      (count + kFunctionsPerChunk - 1) / kFunctionsPerChunk;
+  const Features features = context.features;
+  const optional<Index> declared_data_count = context.declared_data_count;
+  const bool track_context = context.errors.track_context();
+
+  std::vector<Result> results(count);
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<bool> chunk_done(chunk_count);
+
+  auto decode_range = [&](unsigned, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      Index func_index = index.first_index() + static_cast<Index>(i);
+      results[i].body.index = func_index;
+      DecodeFunctionBody(index.GetCodeData(func_index), features,
+                         declared_data_count, track_context, &results[i]);
+    }
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      chunk_done[begin / kFunctionsPerChunk] = true;
+    }
+    cv.notify_all();
+  };
+
+  // Deliver the bodies on the calling thread while the rest are decoded.
+  auto deliver = [&]() {
+    for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+      {
+        std::unique_lock<std::mutex> lock{mutex};
+        cv.wait(lock, [&]() { return chunk_done[chunk]; });
+      }
+      size_t begin = chunk * kFunctionsPerChunk;
+      size_t end = std::min(begin + kFunctionsPerChunk, count);
+      for (size_t i = begin; i < end; ++i) {
+        results[i].errors.Replay(context.errors);
+        callback(results[i].body);
+        // Release the memory for this body as soon as it is delivered.
+        results[i] = Result{};
+      }
+    }
+  };
+
+  pool.ParallelFor(count, kFunctionsPerChunk, decode_range, deliver);
+  context.code_count += static_cast<Index>(count);
+}
+
+auto ReadFunctionBodiesParallel(const CodeSectionIndex& index,
+                                Context& context,
+                                ThreadPool& pool) -> std::vector<FunctionBody> {
+  std::vector<FunctionBody> bodies;
+  bodies.reserve(index.size());
+  ForEachFunctionBodyParallel(
+      index, context, pool,
+      [&](FunctionBody& body) { bodies.push_back(std::move(body)); });
+  return bodies;
+}
+
+}  // namespace wasp::binary
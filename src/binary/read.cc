@@ -29,6 +29,7 @@
 #include "wasp/binary/formatters.h"
 #include "wasp/binary/read/location_guard.h"
 #include "wasp/binary/read/macros.h"
+#include "wasp/binary/read/read_instruction.h"
 #include "wasp/binary/read/read_var_int.h"
 #include "wasp/binary/read/read_vector.h"
 
@@ -580,678 +581,8 @@ bool RequireDataCountSection(Context& context, const At<Opcode>& opcode) {
 }
 
 OptAt<Instruction> Read(SpanU8* data, Context& context, Tag<Instruction>) {
-  LocationGuard guard{data};
-  WASP_TRY_READ(opcode, Read<Opcode>(data, context));
-
-  if (context.seen_final_end) {
-    context.errors.OnError(opcode.loc(), concat("Unexpected ", *opcode,
-                                                " instruction after 'end'"));
-    return nullopt;
-  }
-
-  switch (opcode) {
-    // No immediates:
-    case Opcode::Unreachable:
-    case Opcode::Nop:
-    case Opcode::Rethrow:
-    case Opcode::Return:
-    case Opcode::Drop:
-    case Opcode::Select:
-    case Opcode::I32Eqz:
-    case Opcode::I32Eq:
-    case Opcode::I32Ne:
-    case Opcode::I32LtS:
-    case Opcode::I32LeS:
-    case Opcode::I32LtU:
-    case Opcode::I32LeU:
-    case Opcode::I32GtS:
-    case Opcode::I32GeS:
-    case Opcode::I32GtU:
-    case Opcode::I32GeU:
-    case Opcode::I64Eqz:
-    case Opcode::I64Eq:
-    case Opcode::I64Ne:
-    case Opcode::I64LtS:
-    case Opcode::I64LeS:
-    case Opcode::I64LtU:
-    case Opcode::I64LeU:
-    case Opcode::I64GtS:
-    case Opcode::I64GeS:
-    case Opcode::I64GtU:
-    case Opcode::I64GeU:
-    case Opcode::F32Eq:
-    case Opcode::F32Ne:
-    case Opcode::F32Lt:
-    case Opcode::F32Le:
-    case Opcode::F32Gt:
-    case Opcode::F32Ge:
-    case Opcode::F64Eq:
-    case Opcode::F64Ne:
-    case Opcode::F64Lt:
-    case Opcode::F64Le:
-    case Opcode::F64Gt:
-    case Opcode::F64Ge:
-    case Opcode::I32Clz:
-    case Opcode::I32Ctz:
-    case Opcode::I32Popcnt:
-    case Opcode::I32Add:
-    case Opcode::I32Sub:
-    case Opcode::I32Mul:
-    case Opcode::I32DivS:
-    case Opcode::I32DivU:
-    case Opcode::I32RemS:
-    case Opcode::I32RemU:
-    case Opcode::I32And:
-    case Opcode::I32Or:
-    case Opcode::I32Xor:
-    case Opcode::I32Shl:
-    case Opcode::I32ShrS:
-    case Opcode::I32ShrU:
-    case Opcode::I32Rotl:
-    case Opcode::I32Rotr:
-    case Opcode::I64Clz:
-    case Opcode::I64Ctz:
-    case Opcode::I64Popcnt:
-    case Opcode::I64Add:
-    case Opcode::I64Sub:
-    case Opcode::I64Mul:
-    case Opcode::I64DivS:
-    case Opcode::I64DivU:
-    case Opcode::I64RemS:
-    case Opcode::I64RemU:
-    case Opcode::I64And:
-    case Opcode::I64Or:
-    case Opcode::I64Xor:
-    case Opcode::I64Shl:
-    case Opcode::I64ShrS:
-    case Opcode::I64ShrU:
-    case Opcode::I64Rotl:
-    case Opcode::I64Rotr:
-    case Opcode::F32Abs:
-    case Opcode::F32Neg:
-    case Opcode::F32Ceil:
-    case Opcode::F32Floor:
-    case Opcode::F32Trunc:
-    case Opcode::F32Nearest:
-    case Opcode::F32Sqrt:
-    case Opcode::F32Add:
-    case Opcode::F32Sub:
-    case Opcode::F32Mul:
-    case Opcode::F32Div:
-    case Opcode::F32Min:
-    case Opcode::F32Max:
-    case Opcode::F32Copysign:
-    case Opcode::F64Abs:
-    case Opcode::F64Neg:
-    case Opcode::F64Ceil:
-    case Opcode::F64Floor:
-    case Opcode::F64Trunc:
-    case Opcode::F64Nearest:
-    case Opcode::F64Sqrt:
-    case Opcode::F64Add:
-    case Opcode::F64Sub:
-    case Opcode::F64Mul:
-    case Opcode::F64Div:
-    case Opcode::F64Min:
-    case Opcode::F64Max:
-    case Opcode::F64Copysign:
-    case Opcode::I32WrapI64:
-    case Opcode::I32TruncF32S:
-    case Opcode::I32TruncF32U:
-    case Opcode::I32TruncF64S:
-    case Opcode::I32TruncF64U:
-    case Opcode::I64ExtendI32S:
-    case Opcode::I64ExtendI32U:
-    case Opcode::I64TruncF32S:
-    case Opcode::I64TruncF32U:
-    case Opcode::I64TruncF64S:
-    case Opcode::I64TruncF64U:
-    case Opcode::F32ConvertI32S:
-    case Opcode::F32ConvertI32U:
-    case Opcode::F32ConvertI64S:
-    case Opcode::F32ConvertI64U:
-    case Opcode::F32DemoteF64:
-    case Opcode::F64ConvertI32S:
-    case Opcode::F64ConvertI32U:
-    case Opcode::F64ConvertI64S:
-    case Opcode::F64ConvertI64U:
-    case Opcode::F64PromoteF32:
-    case Opcode::I32ReinterpretF32:
-    case Opcode::I64ReinterpretF64:
-    case Opcode::F32ReinterpretI32:
-    case Opcode::F64ReinterpretI64:
-    case Opcode::I32Extend8S:
-    case Opcode::I32Extend16S:
-    case Opcode::I64Extend8S:
-    case Opcode::I64Extend16S:
-    case Opcode::I64Extend32S:
-    case Opcode::I32TruncSatF32S:
-    case Opcode::I32TruncSatF32U:
-    case Opcode::I32TruncSatF64S:
-    case Opcode::I32TruncSatF64U:
-    case Opcode::I64TruncSatF32S:
-    case Opcode::I64TruncSatF32U:
-    case Opcode::I64TruncSatF64S:
-    case Opcode::I64TruncSatF64U:
-    case Opcode::RefIsNull:
-    case Opcode::I8X16Add:
-    case Opcode::I16X8Add:
-    case Opcode::I32X4Add:
-    case Opcode::I64X2Add:
-    case Opcode::I8X16Sub:
-    case Opcode::I16X8Sub:
-    case Opcode::I32X4Sub:
-    case Opcode::I64X2Sub:
-    case Opcode::I16X8Mul:
-    case Opcode::I32X4Mul:
-    case Opcode::I64X2Mul:
-    case Opcode::I8X16AddSaturateS:
-    case Opcode::I8X16AddSaturateU:
-    case Opcode::I16X8AddSaturateS:
-    case Opcode::I16X8AddSaturateU:
-    case Opcode::I8X16SubSaturateS:
-    case Opcode::I8X16SubSaturateU:
-    case Opcode::I16X8SubSaturateS:
-    case Opcode::I16X8SubSaturateU:
-    case Opcode::I8X16MinS:
-    case Opcode::I8X16MinU:
-    case Opcode::I8X16MaxS:
-    case Opcode::I8X16MaxU:
-    case Opcode::I16X8MinS:
-    case Opcode::I16X8MinU:
-    case Opcode::I16X8MaxS:
-    case Opcode::I16X8MaxU:
-    case Opcode::I32X4MinS:
-    case Opcode::I32X4MinU:
-    case Opcode::I32X4MaxS:
-    case Opcode::I32X4MaxU:
-    case Opcode::I8X16Shl:
-    case Opcode::I16X8Shl:
-    case Opcode::I32X4Shl:
-    case Opcode::I64X2Shl:
-    case Opcode::I8X16ShrS:
-    case Opcode::I8X16ShrU:
-    case Opcode::I16X8ShrS:
-    case Opcode::I16X8ShrU:
-    case Opcode::I32X4ShrS:
-    case Opcode::I32X4ShrU:
-    case Opcode::I64X2ShrS:
-    case Opcode::I64X2ShrU:
-    case Opcode::V128And:
-    case Opcode::V128Or:
-    case Opcode::V128Xor:
-    case Opcode::F32X4Min:
-    case Opcode::F64X2Min:
-    case Opcode::F32X4Max:
-    case Opcode::F64X2Max:
-    case Opcode::F32X4Add:
-    case Opcode::F64X2Add:
-    case Opcode::F32X4Sub:
-    case Opcode::F64X2Sub:
-    case Opcode::F32X4Div:
-    case Opcode::F64X2Div:
-    case Opcode::F32X4Mul:
-    case Opcode::F64X2Mul:
-    case Opcode::I8X16Eq:
-    case Opcode::I16X8Eq:
-    case Opcode::I32X4Eq:
-    case Opcode::F32X4Eq:
-    case Opcode::F64X2Eq:
-    case Opcode::I8X16Ne:
-    case Opcode::I16X8Ne:
-    case Opcode::I32X4Ne:
-    case Opcode::F32X4Ne:
-    case Opcode::F64X2Ne:
-    case Opcode::I8X16LtS:
-    case Opcode::I8X16LtU:
-    case Opcode::I16X8LtS:
-    case Opcode::I16X8LtU:
-    case Opcode::I32X4LtS:
-    case Opcode::I32X4LtU:
-    case Opcode::F32X4Lt:
-    case Opcode::F64X2Lt:
-    case Opcode::I8X16LeS:
-    case Opcode::I8X16LeU:
-    case Opcode::I16X8LeS:
-    case Opcode::I16X8LeU:
-    case Opcode::I32X4LeS:
-    case Opcode::I32X4LeU:
-    case Opcode::F32X4Le:
-    case Opcode::F64X2Le:
-    case Opcode::I8X16GtS:
-    case Opcode::I8X16GtU:
-    case Opcode::I16X8GtS:
-    case Opcode::I16X8GtU:
-    case Opcode::I32X4GtS:
-    case Opcode::I32X4GtU:
-    case Opcode::F32X4Gt:
-    case Opcode::F64X2Gt:
-    case Opcode::I8X16GeS:
-    case Opcode::I8X16GeU:
-    case Opcode::I16X8GeS:
-    case Opcode::I16X8GeU:
-    case Opcode::I32X4GeS:
-    case Opcode::I32X4GeU:
-    case Opcode::F32X4Ge:
-    case Opcode::F64X2Ge:
-    case Opcode::I8X16Splat:
-    case Opcode::I16X8Splat:
-    case Opcode::I32X4Splat:
-    case Opcode::I64X2Splat:
-    case Opcode::F32X4Splat:
-    case Opcode::F64X2Splat:
-    case Opcode::I8X16Neg:
-    case Opcode::I16X8Neg:
-    case Opcode::I32X4Neg:
-    case Opcode::I64X2Neg:
-    case Opcode::V128Not:
-    case Opcode::I8X16AnyTrue:
-    case Opcode::I16X8AnyTrue:
-    case Opcode::I32X4AnyTrue:
-    case Opcode::I8X16AllTrue:
-    case Opcode::I16X8AllTrue:
-    case Opcode::I32X4AllTrue:
-    case Opcode::F32X4Neg:
-    case Opcode::F64X2Neg:
-    case Opcode::F32X4Abs:
-    case Opcode::F64X2Abs:
-    case Opcode::F32X4Sqrt:
-    case Opcode::F64X2Sqrt:
-    case Opcode::V128BitSelect:
-    case Opcode::F32X4ConvertI32X4S:
-    case Opcode::F32X4ConvertI32X4U:
-    case Opcode::I32X4TruncSatF32X4S:
-    case Opcode::I32X4TruncSatF32X4U:
-    case Opcode::V8X16Swizzle:
-    case Opcode::I8X16NarrowI16X8S:
-    case Opcode::I8X16NarrowI16X8U:
-    case Opcode::I16X8NarrowI32X4S:
-    case Opcode::I16X8NarrowI32X4U:
-    case Opcode::I16X8WidenLowI8X16S:
-    case Opcode::I16X8WidenHighI8X16S:
-    case Opcode::I16X8WidenLowI8X16U:
-    case Opcode::I16X8WidenHighI8X16U:
-    case Opcode::I32X4WidenLowI16X8S:
-    case Opcode::I32X4WidenHighI16X8S:
-    case Opcode::I32X4WidenLowI16X8U:
-    case Opcode::I32X4WidenHighI16X8U:
-    case Opcode::V128Andnot:
-    case Opcode::I8X16AvgrU:
-    case Opcode::I16X8AvgrU:
-    case Opcode::I8X16Abs:
-    case Opcode::I16X8Abs:
-    case Opcode::I32X4Abs:
-    case Opcode::RefAsNonNull:
-    case Opcode::CallRef:
-    case Opcode::ReturnCallRef:
-    case Opcode::RefEq:
-    case Opcode::I31New:
-    case Opcode::I31GetS:
-    case Opcode::I31GetU:
-      return At{guard.range(data), Instruction{opcode}};
-
-    // No immediates, but only allowed if there's a matching block/loop/if/try
-    // instruction.
-    case Opcode::End:
-      if (context.open_blocks.empty()) {
-        context.seen_final_end = true;
-      } else if (context.open_blocks.back() == Opcode::Try) {
-        context.errors.OnError(opcode.loc(),
-                               "Expected catch instruction in try block");
-        return nullopt;
-      } else {
-        context.open_blocks.pop_back();
-      }
-      return At{guard.range(data), Instruction{opcode}};
-
-    // No immediates, but only allowed if there's a matching if instruction.
-    case Opcode::Else:
-      if (context.open_blocks.empty() ||
-          context.open_blocks.back() != Opcode::If) {
-        context.errors.OnError(opcode.loc(), "Unexpected else instruction");
-        return nullopt;
-      } else {
-        context.open_blocks.back() = opcode;
-      }
-      return At{guard.range(data), Instruction{opcode}};
-
-    // No immediates, but only allowed if there's a matching try instruction.
-    case Opcode::Catch:
-      if (context.open_blocks.empty() ||
-          context.open_blocks.back().second != Opcode::Try) {
-        context.errors.OnError(opcode.loc(), "Unexpected catch instruction");
-        return nullopt;
-      } else {
-        context.open_blocks.back() = opcode;
-      }
-      return At{guard.range(data), Instruction{opcode}};
-
-    // HeapType type immediate.
-    case Opcode::RefNull:
-    case Opcode::RttCanon: {
-      WASP_TRY_READ(type, Read<HeapType>(data, context));
-      return At{guard.range(data), Instruction{opcode, type}};
-    }
-
-    // Block type immediate.
-    case Opcode::Block:
-    case Opcode::Loop:
-    case Opcode::If:
-    case Opcode::Try: {
-      WASP_TRY_READ(type, Read<BlockType>(data, context));
-      context.open_blocks.push_back(opcode);
-      return At{guard.range(data), Instruction{opcode, type}};
-    }
-
-    // Index immediate, w/ additional data count requirement.
-    case Opcode::DataDrop:
-      if (!RequireDataCountSection(context, opcode)) {
-        return nullopt;
-      }
-      // Fallthrough.
-
-    // Index immediate.
-    case Opcode::Throw:
-    case Opcode::Br:
-    case Opcode::BrIf:
-    case Opcode::Call:
-    case Opcode::ReturnCall:
-    case Opcode::LocalGet:
-    case Opcode::LocalSet:
-    case Opcode::LocalTee:
-    case Opcode::GlobalGet:
-    case Opcode::GlobalSet:
-    case Opcode::TableGet:
-    case Opcode::TableSet:
-    case Opcode::RefFunc:
-    case Opcode::ElemDrop:
-    case Opcode::TableGrow:
-    case Opcode::TableSize:
-    case Opcode::TableFill:
-    case Opcode::BrOnNull:
-    case Opcode::FuncBind:
-    case Opcode::StructNewWithRtt:
-    case Opcode::StructNewDefaultWithRtt:
-    case Opcode::ArrayNewWithRtt:
-    case Opcode::ArrayNewDefaultWithRtt:
-    case Opcode::ArrayGet:
-    case Opcode::ArrayGetS:
-    case Opcode::ArrayGetU:
-    case Opcode::ArraySet:
-    case Opcode::ArrayLen: {
-      WASP_TRY_READ(index, ReadIndex(data, context, "index"));
-      return At{guard.range(data), Instruction{opcode, index}};
-    }
-
-    // Index, Index immediates.
-    case Opcode::BrOnExn: {
-      WASP_TRY_READ(immediate, Read<BrOnExnImmediate>(data, context));
-      return At{guard.range(data), Instruction{opcode, immediate}};
-    }
-
-    // Index* immediates.
-    case Opcode::BrTable: {
-      WASP_TRY_READ(immediate, Read<BrTableImmediate>(data, context));
-      return At{guard.range(data), Instruction{opcode, std::move(immediate)}};
-    }
-
-    // Index, reserved immediates.
-    case Opcode::CallIndirect:
-    case Opcode::ReturnCallIndirect: {
-      WASP_TRY_READ(immediate, Read<CallIndirectImmediate>(data, context));
-      return At{guard.range(data), Instruction{opcode, immediate}};
-    }
-
-    // Memarg (alignment, offset) immediates.
-    case Opcode::I32Load:
-    case Opcode::I64Load:
-    case Opcode::F32Load:
-    case Opcode::F64Load:
-    case Opcode::I32Load8S:
-    case Opcode::I32Load8U:
-    case Opcode::I32Load16S:
-    case Opcode::I32Load16U:
-    case Opcode::I64Load8S:
-    case Opcode::I64Load8U:
-    case Opcode::I64Load16S:
-    case Opcode::I64Load16U:
-    case Opcode::I64Load32S:
-    case Opcode::I64Load32U:
-    case Opcode::V128Load:
-    case Opcode::I32Store:
-    case Opcode::I64Store:
-    case Opcode::F32Store:
-    case Opcode::F64Store:
-    case Opcode::I32Store8:
-    case Opcode::I32Store16:
-    case Opcode::I64Store8:
-    case Opcode::I64Store16:
-    case Opcode::I64Store32:
-    case Opcode::V128Store:
-    case Opcode::V8X16LoadSplat:
-    case Opcode::V16X8LoadSplat:
-    case Opcode::V32X4LoadSplat:
-    case Opcode::V64X2LoadSplat:
-    case Opcode::I16X8Load8X8S:
-    case Opcode::I16X8Load8X8U:
-    case Opcode::I32X4Load16X4S:
-    case Opcode::I32X4Load16X4U:
-    case Opcode::I64X2Load32X2S:
-    case Opcode::I64X2Load32X2U:
-    case Opcode::MemoryAtomicNotify:
-    case Opcode::MemoryAtomicWait32:
-    case Opcode::MemoryAtomicWait64:
-    case Opcode::I32AtomicLoad:
-    case Opcode::I64AtomicLoad:
-    case Opcode::I32AtomicLoad8U:
-    case Opcode::I32AtomicLoad16U:
-    case Opcode::I64AtomicLoad8U:
-    case Opcode::I64AtomicLoad16U:
-    case Opcode::I64AtomicLoad32U:
-    case Opcode::I32AtomicStore:
-    case Opcode::I64AtomicStore:
-    case Opcode::I32AtomicStore8:
-    case Opcode::I32AtomicStore16:
-    case Opcode::I64AtomicStore8:
-    case Opcode::I64AtomicStore16:
-    case Opcode::I64AtomicStore32:
-    case Opcode::I32AtomicRmwAdd:
-    case Opcode::I64AtomicRmwAdd:
-    case Opcode::I32AtomicRmw8AddU:
-    case Opcode::I32AtomicRmw16AddU:
-    case Opcode::I64AtomicRmw8AddU:
-    case Opcode::I64AtomicRmw16AddU:
-    case Opcode::I64AtomicRmw32AddU:
-    case Opcode::I32AtomicRmwSub:
-    case Opcode::I64AtomicRmwSub:
-    case Opcode::I32AtomicRmw8SubU:
-    case Opcode::I32AtomicRmw16SubU:
-    case Opcode::I64AtomicRmw8SubU:
-    case Opcode::I64AtomicRmw16SubU:
-    case Opcode::I64AtomicRmw32SubU:
-    case Opcode::I32AtomicRmwAnd:
-    case Opcode::I64AtomicRmwAnd:
-    case Opcode::I32AtomicRmw8AndU:
-    case Opcode::I32AtomicRmw16AndU:
-    case Opcode::I64AtomicRmw8AndU:
-    case Opcode::I64AtomicRmw16AndU:
-    case Opcode::I64AtomicRmw32AndU:
-    case Opcode::I32AtomicRmwOr:
-    case Opcode::I64AtomicRmwOr:
-    case Opcode::I32AtomicRmw8OrU:
-    case Opcode::I32AtomicRmw16OrU:
-    case Opcode::I64AtomicRmw8OrU:
-    case Opcode::I64AtomicRmw16OrU:
-    case Opcode::I64AtomicRmw32OrU:
-    case Opcode::I32AtomicRmwXor:
-    case Opcode::I64AtomicRmwXor:
-    case Opcode::I32AtomicRmw8XorU:
-    case Opcode::I32AtomicRmw16XorU:
-    case Opcode::I64AtomicRmw8XorU:
-    case Opcode::I64AtomicRmw16XorU:
-    case Opcode::I64AtomicRmw32XorU:
-    case Opcode::I32AtomicRmwXchg:
-    case Opcode::I64AtomicRmwXchg:
-    case Opcode::I32AtomicRmw8XchgU:
-    case Opcode::I32AtomicRmw16XchgU:
-    case Opcode::I64AtomicRmw8XchgU:
-    case Opcode::I64AtomicRmw16XchgU:
-    case Opcode::I64AtomicRmw32XchgU:
-    case Opcode::I32AtomicRmwCmpxchg:
-    case Opcode::I64AtomicRmwCmpxchg:
-    case Opcode::I32AtomicRmw8CmpxchgU:
-    case Opcode::I32AtomicRmw16CmpxchgU:
-    case Opcode::I64AtomicRmw8CmpxchgU:
-    case Opcode::I64AtomicRmw16CmpxchgU:
-    case Opcode::I64AtomicRmw32CmpxchgU: {
-      WASP_TRY_READ(memarg, Read<MemArgImmediate>(data, context));
-      return At{guard.range(data), Instruction{opcode, memarg}};
-    }
-
-    // Reserved immediates.
-    case Opcode::MemorySize:
-    case Opcode::MemoryGrow:
-    case Opcode::MemoryFill: {
-      WASP_TRY_READ(reserved, ReadReserved(data, context));
-      return At{guard.range(data), Instruction{opcode, reserved}};
-    }
-
-    // Const immediates.
-    case Opcode::I32Const: {
-      WASP_TRY_READ_CONTEXT(value, Read<s32>(data, context), "i32 constant");
-      return At{guard.range(data), Instruction{opcode, value}};
-    }
-
-    case Opcode::I64Const: {
-      WASP_TRY_READ_CONTEXT(value, Read<s64>(data, context), "i64 constant");
-      return At{guard.range(data), Instruction{opcode, value}};
-    }
-
-    case Opcode::F32Const: {
-      WASP_TRY_READ_CONTEXT(value, Read<f32>(data, context), "f32 constant");
-      return At{guard.range(data), Instruction{opcode, value}};
-    }
-
-    case Opcode::F64Const: {
-      WASP_TRY_READ_CONTEXT(value, Read<f64>(data, context), "f64 constant");
-      return At{guard.range(data), Instruction{opcode, value}};
-    }
-
-    case Opcode::V128Const: {
-      WASP_TRY_READ_CONTEXT(value, Read<v128>(data, context), "v128 constant");
-      return At{guard.range(data), Instruction{opcode, value}};
-    }
-
-    // Reserved, Index immediates.
-    case Opcode::MemoryInit: {
-      WASP_TRY_READ(immediate, Read<InitImmediate>(data, context,
-                                                   BulkImmediateKind::Memory));
-      if (!RequireDataCountSection(context, opcode)) {
-        return nullopt;
-      }
-      return At{guard.range(data), Instruction{opcode, immediate}};
-    }
-    case Opcode::TableInit: {
-      WASP_TRY_READ(immediate, Read<InitImmediate>(data, context,
-                                                   BulkImmediateKind::Table));
-      return At{guard.range(data), Instruction{opcode, immediate}};
-    }
-
-    // Reserved, reserved immediates.
-    case Opcode::MemoryCopy: {
-      WASP_TRY_READ(immediate, Read<CopyImmediate>(data, context,
-                                                   BulkImmediateKind::Memory));
-      return At{guard.range(data), Instruction{opcode, immediate}};
-    }
-    case Opcode::TableCopy: {
-      WASP_TRY_READ(immediate, Read<CopyImmediate>(data, context,
-                                                   BulkImmediateKind::Table));
-      return At{guard.range(data), Instruction{opcode, immediate}};
-    }
-
-    // Shuffle immediate.
-    case Opcode::V8X16Shuffle: {
-      WASP_TRY_READ(immediate, Read<ShuffleImmediate>(data, context));
-      return At{guard.range(data), Instruction{opcode, immediate}};
-    }
-
-    // Select immediate.
-    case Opcode::SelectT: {
-      LocationGuard immediate_guard{data};
-      WASP_TRY_READ(immediate, ReadVector<ValueType>(data, context, "types"));
-      return At{
-          guard.range(data),
-          Instruction{opcode, At{immediate_guard.range(data), immediate}}};
-    }
-
-    // u8 immediate.
-    case Opcode::I8X16ExtractLaneS:
-    case Opcode::I8X16ExtractLaneU:
-    case Opcode::I16X8ExtractLaneS:
-    case Opcode::I16X8ExtractLaneU:
-    case Opcode::I32X4ExtractLane:
-    case Opcode::I64X2ExtractLane:
-    case Opcode::F32X4ExtractLane:
-    case Opcode::F64X2ExtractLane:
-    case Opcode::I8X16ReplaceLane:
-    case Opcode::I16X8ReplaceLane:
-    case Opcode::I32X4ReplaceLane:
-    case Opcode::I64X2ReplaceLane:
-    case Opcode::F32X4ReplaceLane:
-    case Opcode::F64X2ReplaceLane: {
-      WASP_TRY_READ(lane, Read<u8>(data, context));
-      return At{guard.range(data), Instruction{opcode, lane}};
-    }
-
-    // Let immediate.
-    case Opcode::Let: {
-      WASP_TRY_READ(immediate, Read<LetImmediate>(data, context));
-      return At{guard.range(data), Instruction{opcode, immediate}};
-    }
-
-    // StructField immediate.
-    case Opcode::StructGet:
-    case Opcode::StructGetS:
-    case Opcode::StructGetU:
-    case Opcode::StructSet: {
-      WASP_TRY_READ(immediate, Read<StructFieldImmediate>(data, context));
-      return At{guard.range(data), Instruction{opcode, immediate}};
-    }
-
-    // RttSub immediate.
-    case Opcode::RttSub: {
-      // TODO: Determine whether this instruction should have heap type
-      // immediates.
-#if 0
-      WASP_TRY_READ(immediate, Read<RttSubImmediate>(data, context));
-      return At{guard.range(data), Instruction{opcode, immediate}};
-#else
-      WASP_TRY_READ(type, Read<HeapType>(data, context));
-      return At{guard.range(data), Instruction{opcode, type}};
-#endif
-    }
-
-    // Two HeapType immediate.
-    case Opcode::RefTest:
-    case Opcode::RefCast: {
-      WASP_TRY_READ(immediate, Read<HeapType2Immediate>(data, context));
-      return At{guard.range(data), Instruction{opcode, immediate}};
-    }
-
-    // BrOnCast immediate.
-    case Opcode::BrOnCast: {
-      // TODO: Determine whether this instruction should have heap type
-      // immediates.
-#if 0
-      WASP_TRY_READ(immediate, Read<BrOnCastImmediate>(data, context));
-      return At{guard.range(data), Instruction{opcode, immediate}};
-#else
-      WASP_TRY_READ(index, ReadIndex(data, context, "index"));
-      return At{guard.range(data), Instruction{opcode, index}};
-#endif
-    }
-  }
-  WASP_UNREACHABLE();
+  StoreInstruction policy;
+  return ReadInstruction(data, context, policy);
 }
 
 OptAt<InstructionList> Read(SpanU8* data,
@@ -1405,13 +736,7 @@ OptAt<Section> Read(SpanU8* data, Context& context, Tag<Section>) {
     return At{guard.range(data),
               Section{At{guard.range(data), CustomSection{name, *bytes}}}};
   } else {
-    if (context.last_section_id && *context.last_section_id >= id.value()) {
-      context.errors.OnError(
-          id.loc(), concat("Section out of order: ", id, " cannot occur after ",
-                           *context.last_section_id));
-    }
-    context.last_section_id = id;
-
+    CheckSectionOrder(id, context);
     return At{guard.range(data),
               Section{At{guard.range(data), KnownSection{id, *bytes}}}};
   }
@@ -1577,10 +902,23 @@ OptAt<ValueType> Read(SpanU8* data, Context& context, Tag<ValueType>) {
   }
 }
 
+bool CheckSectionOrder(At<SectionId> id, Context& context) {
+  bool valid = true;
+  if (context.last_section_id && *context.last_section_id >= id.value()) {
+    context.errors.OnError(
+        id.loc(), concat("Section out of order: ", id, " cannot occur after ",
+                         *context.last_section_id));
+    valid = false;
+  }
+  context.last_section_id = id;
+  return valid;
+}
+
 bool EndCode(SpanU8 data, Context& context) {
   if (!context.open_blocks.empty()) {
-    for (auto& [loc, op] : context.open_blocks) {
-      context.errors.OnError(loc, concat("Unclosed ", op, " instruction"));
+    for (const auto& op : context.open_blocks) {
+      context.errors.OnError(op.loc(),
+                             concat("Unclosed ", *op, " instruction"));
     }
     return false;
   }
@@ -0,0 +1,84 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/binary/section_directory.h"
+
+#include "wasp/binary/lazy_module.h"
+
+namespace wasp::binary {
+
+SectionDirectory::SectionDirectory(LazyModule& module) {
+  for (auto section : module.sections) {
+    auto index = static_cast<Index>(sections_.size());
+    sections_.push_back(section);
+    if (section->is_known()) {
+      // Known sections should only occur once; if not, keep the first.
+      known_.emplace(section->known()->id, index);
+    } else if (section->is_custom()) {
+      custom_sections_.push_back(index);
+      custom_.emplace(section->custom()->name, index);
+    }
+  }
+}
+
+optional<Index> SectionDirectory::FindIndex(SectionId id) const {
+  auto iter = known_.find(id);
+  if (iter == known_.end()) {
+    return nullopt;
+  }
+  return iter->second;
+}
+
+optional<Index> SectionDirectory::FindCustomIndex(string_view name) const {
+  auto iter = custom_.find(name);
+  if (iter == custom_.end()) {
+    return nullopt;
+  }
+  return iter->second;
+}
+
+OptAt<KnownSection> SectionDirectory::Find(SectionId id) const {
+  if (auto index = FindIndex(id)) {
+    return sections_[*index]->known();
+  }
+  return nullopt;
+}
+
+OptAt<CustomSection> SectionDirectory::FindCustom(string_view name) const {
+  if (auto index = FindCustomIndex(name)) {
+    return sections_[*index]->custom();
+  }
+  return nullopt;
+}
+
+std::vector<At<CustomSection>> SectionDirectory::FindAllCustom(
+    string_view prefix) const {
+  std::vector<At<CustomSection>> result;
+  for (auto index : custom_sections_) {
+    auto custom = sections_[index]->custom();
+    if (starts_with(*custom->name, prefix)) {
+      result.push_back(custom);
+    }
+  }
+  return result;
+}
+
+auto ReadSectionDirectory(LazyModule& module) -> SectionDirectory {
+  return SectionDirectory{module};
+}
+
+}  // namespace wasp::binary
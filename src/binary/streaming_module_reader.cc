@@ -0,0 +1,73 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/binary/streaming_module_reader.h"
+
+#include <cassert>
+
+namespace wasp::binary {
+
+void StreamingModuleReaderBase::BeginChunk(SpanU8 chunk) {
+  if (pending_.empty()) {
+    pending_ = chunk;
+    pending_in_buffer_ = false;
+    return;
+  }
+
+  // Drop the bytes that have already been consumed, then append the chunk.
+  assert(pending_in_buffer_);
+  buffer_.erase(buffer_.begin(),
+                buffer_.begin() + (pending_.data() - buffer_.data()));
+  buffer_.insert(buffer_.end(), chunk.begin(), chunk.end());
+  pending_ = SpanU8{buffer_};
+}
+
+void StreamingModuleReaderBase::EndChunk() {
+  if (!pending_.empty() && !pending_in_buffer_) {
+    buffer_.assign(pending_.begin(), pending_.end());
+    pending_ = SpanU8{buffer_};
+    pending_in_buffer_ = true;
+  }
+}
+
+void StreamingModuleReaderBase::Consume(size_t size) {
+  remove_prefix(&pending_, size);
+}
+
+// static
+auto StreamingModuleReaderBase::PeekU32(SpanU8 data,
+                                        u32* out_value,
+                                        size_t* out_size) -> PeekResult {
+  // A u32 is encoded in at most 5 bytes.
+  constexpr size_t kMaxBytes = 5;
+  u32 value = 0;
+  for (size_t i = 0; i < kMaxBytes; ++i) {
+    if (i == data.size()) {
+      return PeekResult::NeedMore;
+    }
+    u8 byte = data[i];
+    value |= u32(byte & 0x7f) << (i * 7);
+    if ((byte & 0x80) == 0) {
+      *out_value = value;
+      *out_size = i + 1;
+      return PeekResult::Ok;
+    }
+  }
+  return PeekResult::Malformed;
+}
+
+}  // namespace wasp::binary
@@ -26,7 +26,7 @@ namespace wasp::tools {
 BinaryErrors::BinaryErrors(SpanU8 data) : BinaryErrors{"<unknown>", data} {}
 
 BinaryErrors::BinaryErrors(string_view filename, SpanU8 data)
-    : filename{filename}, data{data} {}
+    : Errors{false}, filename{filename}, data{data} {}
 
 void BinaryErrors::PrintTo(std::ostream& os) {
   for (const auto& error : errors) {
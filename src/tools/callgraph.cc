@@ -28,6 +28,7 @@
 
 #include "src/tools/argparser.h"
 #include "src/tools/binary_errors.h"
+#include "wasp/base/at.h"
 #include "wasp/base/enumerate.h"
 #include "wasp/base/features.h"
 #include "wasp/base/file.h"
@@ -38,7 +39,10 @@
 #include "wasp/binary/lazy_expression.h"
 #include "wasp/binary/lazy_module.h"
 #include "wasp/binary/lazy_module_utils.h"
+#include "wasp/binary/module_index.h"
+#include "wasp/binary/name_section/name_index.h"
 #include "wasp/binary/name_section/sections.h"
+#include "wasp/binary/section_directory.h"
 #include "wasp/binary/sections.h"
 
 namespace wasp::tools::callgraph {
@@ -62,7 +66,7 @@ struct Options {
 };
 
 struct Tool {
-  explicit Tool(SpanU8 data, Options);
+  explicit Tool(string_view filename, SpanU8 data, Options);
 
   int Run();
   void DoPrepass();
@@ -75,8 +79,8 @@ struct Tool {
   BinaryErrors errors;
   Options options;
   LazyModule module;
-  std::map<Index, string_view> function_names;
-  std::map<string_view, Index> name_to_function;
+  optional<ModuleIndex> module_index;
+  NameIndex names;
   Index imported_function_count = 0;
   std::set<std::pair<Index, Index>> call_graph;
 };
@@ -116,23 +120,29 @@ int Main(span<string_view> args) {
     parser.PrintHelpAndExit(1);
   }
 
-  auto optbuf = ReadFile(filename);
-  if (!optbuf) {
+  auto optfile = ReadFile(filename, MapFileTag{});
+  if (!optfile) {
     print(std::cerr, "Error reading file {}.\n", filename);
     return 1;
   }
 
-  SpanU8 data{*optbuf};
-  Tool tool{data, options};
+  SpanU8 data = optfile->data();
+  LocationBase location_base{data};
+  Tool tool{filename, data, options};
   int result = tool.Run();
   tool.errors.PrintTo(std::cerr);
   return result;
 }
 
-Tool::Tool(SpanU8 data, Options options)
+Tool::Tool(string_view filename, SpanU8 data, Options options)
     : errors{data},
       options{options},
-      module{ReadModule(data, options.features, errors)} {}
+      module{ReadModule(data, options.features, errors)},
+      module_index{LoadModuleIndex(filename, data)} {
+  if (module_index) {
+    module.index = &*module_index;
+  }
+}
 
 int Tool::Run() {
   DoPrepass();
@@ -147,12 +157,7 @@ int Tool::Run() {
 }
 
 void Tool::DoPrepass() {
-  ForEachFunctionName(module, [this](const IndexNamePair& pair) {
-    name_to_function.insert(std::make_pair(pair.second, pair.first));
-  });
-
-  CopyFunctionNames(module,
-                    std::inserter(function_names, function_names.end()));
+  names = NameIndex{module};
   imported_function_count = GetImportCount(module, ExternalKind::Function);
 }
 
@@ -162,9 +167,8 @@ void Tool::GetFunctionIndex() {
     return;
   }
   // Search by name.
-  auto iter = name_to_function.find(*options.function);
-  if (iter != name_to_function.end()) {
-    options.function_index = iter->second;
+  if (auto index = names.FindFunction(*options.function)) {
+    options.function_index = index;
     return;
   }
 
@@ -175,23 +179,24 @@ void Tool::GetFunctionIndex() {
 void Tool::CalculateCallGraph() {
   std::multimap<Index, Index> full_graph;
 
-  for (auto section : module.sections) {
-    if (section->is_known()) {
-      auto known = section->known();
-      if (known->id == SectionId::Code) {
-        auto section = ReadCodeSection(known, module.context);
-        for (auto code : enumerate(section.sequence, imported_function_count)) {
-          for (const auto& instr :
-               ReadExpression(code.value->body, module.context)) {
-            if (instr->opcode == Opcode::Call) {
-              assert(instr->has_index_immediate());
-              auto callee_index = instr->index_immediate();
-              if (options.mode == Mode::Callers) {
-                full_graph.emplace(callee_index, code.index);
-              } else {
-                full_graph.emplace(code.index, callee_index);
-              }
-            }
+  SectionDirectory directory{module};
+  if (auto known = directory.Find(SectionId::Code)) {
+    auto section = ReadCodeSection(*known, module.context);
+    for (auto code : enumerate(section.sequence, imported_function_count)) {
+      // Only call instructions are decoded, the other immediates are skipped.
+      for (const auto& raw :
+           ReadRawExpression(code.value->body, module.context)) {
+        if (raw->opcode == Opcode::Call) {
+          auto instr = DecodeInstruction(raw, module.context);
+          if (!instr) {
+            continue;
+          }
+          assert(instr->value().has_index_immediate());
+          auto callee_index = instr->value().index_immediate();
+          if (options.mode == Mode::Callers) {
+            full_graph.emplace(callee_index, code.index);
+          } else {
+            full_graph.emplace(code.index, callee_index);
           }
         }
       }
@@ -280,12 +285,7 @@ void Tool::WriteDotFile() {
 }
 
 optional<string_view> Tool::GetFunctionName(Index index) const {
-  auto it = function_names.find(index);
-  if (it != function_names.end()) {
-    return it->second;
-  } else {
-    return nullopt;
-  }
+  return names.GetFunctionName(index);
 }
 
 }  // namespace wasp::tools::callgraph
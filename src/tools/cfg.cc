@@ -27,6 +27,7 @@
 
 #include "src/tools/argparser.h"
 #include "src/tools/binary_errors.h"
+#include "wasp/base/at.h"
 #include "wasp/base/enumerate.h"
 #include "wasp/base/features.h"
 #include "wasp/base/file.h"
@@ -38,7 +39,10 @@
 #include "wasp/binary/lazy_expression.h"
 #include "wasp/binary/lazy_module.h"
 #include "wasp/binary/lazy_module_utils.h"
+#include "wasp/binary/module_index.h"
+#include "wasp/binary/name_section/name_index.h"
 #include "wasp/binary/name_section/sections.h"
+#include "wasp/binary/packed_instruction_stream.h"
 #include "wasp/binary/sections.h"
 
 namespace wasp::tools::cfg {
@@ -77,7 +81,7 @@ struct Label {
 };
 
 struct Tool {
-  explicit Tool(SpanU8 data, Options);
+  explicit Tool(string_view filename, SpanU8 data, Options);
 
   int Run();
   void DoPrepass();
@@ -101,8 +105,8 @@ struct Tool {
   BinaryErrors errors;
   Options options;
   LazyModule module;
-  std::map<string_view, Index> name_to_function;
-  Index imported_function_count = 0;
+  optional<ModuleIndex> module_index;
+  NameIndex names;
   std::vector<Label> labels;
   std::vector<BasicBlock> cfg;
   BBID start_bbid = InvalidBBID;
@@ -141,23 +145,29 @@ int Main(span<string_view> args) {
     parser.PrintHelpAndExit(1);
   }
 
-  auto optbuf = ReadFile(filename);
-  if (!optbuf) {
+  auto optfile = ReadFile(filename, MapFileTag{});
+  if (!optfile) {
     print(std::cerr, "Error reading file {}.\n", filename);
     return 1;
   }
 
-  SpanU8 data{*optbuf};
-  Tool tool{data, options};
+  SpanU8 data = optfile->data();
+  LocationBase location_base{data};
+  Tool tool{filename, data, options};
   int result = tool.Run();
   tool.errors.PrintTo(std::cerr);
   return result;
 }
 
-Tool::Tool(SpanU8 data, Options options)
+Tool::Tool(string_view filename, SpanU8 data, Options options)
     : errors{data},
       options{options},
-      module{ReadModule(data, options.features, errors)} {}
+      module{ReadModule(data, options.features, errors)},
+      module_index{LoadModuleIndex(filename, data)} {
+  if (module_index) {
+    module.index = &*module_index;
+  }
+}
 
 int Tool::Run() {
   DoPrepass();
@@ -178,17 +188,13 @@ int Tool::Run() {
 }
 
 void Tool::DoPrepass() {
-  ForEachFunctionName(module, [this](const IndexNamePair& pair) {
-    name_to_function.insert(std::make_pair(pair.second, pair.first));
-  });
-  imported_function_count = GetImportCount(module, ExternalKind::Function);
+  names = NameIndex{module};
 }
 
 optional<Index> Tool::GetFunctionIndex() {
   // Search by name.
-  auto iter = name_to_function.find(options.function);
-  if (iter != name_to_function.end()) {
-    return iter->second;
+  if (auto index = names.FindFunction(options.function)) {
+    return index;
   }
 
   // Try to convert the string to an integer and search by index.
@@ -196,17 +202,9 @@ optional<Index> Tool::GetFunctionIndex() {
 }
 
 optional<Code> Tool::GetCode(Index find_index) {
-  for (auto section : module.sections) {
-    if (section->is_known()) {
-      auto known = section->known();
-      if (known->id == SectionId::Code) {
-        auto section = ReadCodeSection(known, module.context);
-        for (auto code : enumerate(section.sequence, imported_function_count)) {
-          if (code.index == find_index) {
-            return code.value;
-          }
-        }
-      }
+  if (auto index = ReadCodeSectionIndex(module)) {
+    if (auto code = index->GetCode(find_index)) {
+      return code->value();
     }
   }
   return nullopt;
@@ -219,19 +217,18 @@ void Tool::CalculateCFG(Code code) {
   StartBasicBlock(start_bbid, ptr);
 
   const u8* prev_ptr = ptr;
-  auto instrs = ReadExpression(code.body, module.context);
-  for (auto it = instrs.begin(), end = instrs.end(); it != end;
-       ++it, prev_ptr = ptr) {
-    const auto& instr = *it;
-    ptr = it.data().data();
-    switch (instr->opcode) {
+  auto instrs = ReadPackedInstructionStream(code.body, module.context);
+  for (auto instr : instrs) {
+    prev_ptr = ptr;
+    ptr = instr.data().data() + instr.data().size();
+    switch (instr.opcode()) {
       case Opcode::Unreachable:
         MarkUnreachable(ptr);
         break;
 
       case Opcode::Block: {
         auto next = NewBasicBlock();
-        PushLabel(instr->opcode, next, next);
+        PushLabel(instr.opcode(), next, next);
         break;
       }
 
@@ -239,7 +236,7 @@ void Tool::CalculateCFG(Code code) {
         auto loop = NewBasicBlock();
         auto next = NewBasicBlock();
         AddSuccessor(loop);
-        PushLabel(instr->opcode, loop, next);
+        PushLabel(instr.opcode(), loop, next);
         StartBasicBlock(loop, prev_ptr);
         break;
       }
@@ -248,7 +245,7 @@ void Tool::CalculateCFG(Code code) {
         auto true_ = NewBasicBlock();
         auto next = NewBasicBlock();
         AddSuccessor(true_, "T");
-        PushLabel(instr->opcode, next, next);
+        PushLabel(instr.opcode(), next, next);
         StartBasicBlock(true_, ptr);
         break;
       }
@@ -258,7 +255,7 @@ void Tool::CalculateCFG(Code code) {
         AddSuccessor(top.next);
         auto false_ = NewBasicBlock();
         AddSuccessor(top.parent, false_, "F");
-        PushLabel(instr->opcode, top.next, top.next);
+        PushLabel(instr.opcode(), top.next, top.next);
         StartBasicBlock(false_, ptr);
         break;
       }
@@ -274,12 +271,12 @@ void Tool::CalculateCFG(Code code) {
       }
 
       case Opcode::Br:
-        Br(instr->index_immediate());
+        Br(instr.index_immediate());
         MarkUnreachable(ptr);
         break;
 
       case Opcode::BrIf: {
-        Br(instr->index_immediate(), "T");
+        Br(instr.index_immediate(), "T");
         auto next = NewBasicBlock();
         AddSuccessor(next, "F");
         StartBasicBlock(next, ptr);
@@ -287,12 +284,11 @@ void Tool::CalculateCFG(Code code) {
       }
 
       case Opcode::BrTable: {
-        const auto& immediate = instr->br_table_immediate();
         u32 value = 0;
-        for (const auto& target : immediate->targets) {
+        for (auto target : instr.br_table_targets()) {
           Br(target, format("{}", value++));
         }
-        Br(immediate->default_target, "default");
+        Br(instr.br_table_default_target(), "default");
         MarkUnreachable(ptr);
         break;
       }
@@ -26,6 +26,7 @@
 
 #include "src/tools/argparser.h"
 #include "src/tools/binary_errors.h"
+#include "wasp/base/at.h"
 #include "wasp/base/enumerate.h"
 #include "wasp/base/errors_nop.h"
 #include "wasp/base/features.h"
@@ -35,10 +36,12 @@
 #include "wasp/base/str_to_u32.h"
 #include "wasp/base/string_view.h"
 #include "wasp/binary/formatters.h"
-#include "wasp/binary/lazy_expression.h"
 #include "wasp/binary/lazy_module.h"
 #include "wasp/binary/lazy_module_utils.h"
+#include "wasp/binary/module_index.h"
+#include "wasp/binary/name_section/name_index.h"
 #include "wasp/binary/name_section/sections.h"
+#include "wasp/binary/packed_instruction_stream.h"
 #include "wasp/binary/sections.h"
 
 namespace wasp {
@@ -69,7 +72,7 @@ struct Value {
   bool is_phi() const { return !instr; }
 
   BBID block;
-  optional<Instruction> instr;
+  optional<PackedInstruction> instr;
   ValueIDs operands;
 };
 
@@ -91,7 +94,7 @@ struct Label {
 };
 
 struct Tool {
-  explicit Tool(SpanU8 data, Options);
+  explicit Tool(string_view filename, SpanU8 data, Options);
 
   int Run();
   void DoPrepass();
@@ -99,7 +102,7 @@ struct Tool {
   optional<FunctionType> GetFunctionType(Index);
   optional<Code> GetCode(Index);
   void CalculateDFG(const FunctionType&, Code);
-  void DoInstruction(const Instruction&);
+  void DoInstruction(const PackedInstruction&);
   optional<ValueID> GetTrivialPhiOperand(ValueID);
   void RemoveTrivialPhis();
   void WriteDotFile();
@@ -118,7 +121,7 @@ struct Tool {
   void Br(Index);
   void Return();
 
-  ValueID NewValue(const Instruction&, size_t operand_count = 0);
+  ValueID NewValue(const PackedInstruction&, size_t operand_count = 0);
   ValueID NewPhi(BBID);
   ValueID Undef();
 
@@ -130,7 +133,7 @@ struct Tool {
   void PushUndefValues(size_t count);
   ValueID PopValue();
   void PopValues(size_t count);
-  void BasicInstruction(const Instruction&,
+  void BasicInstruction(const PackedInstruction&,
                         size_t operand_count,
                         size_t result_count);
 
@@ -143,10 +146,14 @@ struct Tool {
   BinaryErrors errors;
   Options options;
   LazyModule module;
+  optional<ModuleIndex> module_index;
   std::vector<DefinedType> defined_types;
   std::vector<Function> functions;
-  std::map<string_view, Index> name_to_function;
-  Index imported_function_count = 0;
+  NameIndex names;
+  // The function body, followed by the instructions that produce the params,
+  // the initial values of the locals, the undef value and the return value.
+  PackedInstructionStream instrs;
+  Index undef_instr = 0;
   std::vector<Label> labels;
   std::vector<Block> bbs;
   std::vector<Value> values;
@@ -189,23 +196,29 @@ int Main(span<string_view> args) {
     parser.PrintHelpAndExit(1);
   }
 
-  auto optbuf = ReadFile(filename);
-  if (!optbuf) {
+  auto optfile = ReadFile(filename, MapFileTag{});
+  if (!optfile) {
     print(std::cerr, "Error reading file {}.\n", filename);
     return 1;
   }
 
-  SpanU8 data{*optbuf};
-  Tool tool{data, options};
+  SpanU8 data = optfile->data();
+  LocationBase location_base{data};
+  Tool tool{filename, data, options};
   int result = tool.Run();
   tool.errors.PrintTo(std::cerr);
   return result;
 }
 
-Tool::Tool(SpanU8 data, Options options)
+Tool::Tool(string_view filename, SpanU8 data, Options options)
     : errors{data},
       options{options},
-      module{ReadModule(data, options.features, errors)} {}
+      module{ReadModule(data, options.features, errors)},
+      module_index{LoadModuleIndex(filename, data)} {
+  if (module_index) {
+    module.index = &*module_index;
+  }
+}
 
 int Tool::Run() {
   DoPrepass();
@@ -227,9 +240,7 @@ int Tool::Run() {
 }
 
 void Tool::DoPrepass() {
-  ForEachFunctionName(module, [this](const IndexNamePair& pair) {
-    name_to_function.insert(std::make_pair(pair.second, pair.first));
-  });
+  names = NameIndex{module};
 
   for (auto section : module.sections) {
     if (section->is_known()) {
@@ -248,7 +259,6 @@ void Tool::DoPrepass() {
               functions.push_back(Function{import->index()});
             }
           }
-          imported_function_count = static_cast<Index>(functions.size());
           break;
 
         case SectionId::Function: {
@@ -267,9 +277,8 @@ void Tool::DoPrepass() {
 // TODO(binji): share code with cfg.cc
 optional<Index> Tool::GetFunctionIndex() {
   // Search by name.
-  auto iter = name_to_function.find(options.function);
-  if (iter != name_to_function.end()) {
-    return iter->second;
+  if (auto index = names.FindFunction(options.function)) {
+    return index;
   }
 
   // Try to convert the string to an integer and search by index.
@@ -291,61 +300,71 @@ optional<FunctionType> Tool::GetFunctionType(Index func_index) {
 }
 
 optional<Code> Tool::GetCode(Index find_index) {
-  for (auto section : module.sections) {
-    if (section->is_known()) {
-      auto known = section->known();
-      if (known->id == SectionId::Code) {
-        auto section = ReadCodeSection(known, module.context);
-        for (auto code : enumerate(section.sequence, imported_function_count)) {
-          if (code.index == find_index) {
-            return code.value;
-          }
-        }
-      }
+  if (auto index = ReadCodeSectionIndex(module)) {
+    if (auto code = index->GetCode(find_index)) {
+      return code->value();
     }
   }
   return nullopt;
 }
 
 void Tool::CalculateDFG(const FunctionType& type, Code code) {
-  // Create start block and label.
-  start_bbid = NewBlock();
-  StartBlock(start_bbid);
+  instrs = ReadPackedInstructionStream(code.body, module.context);
+  Index body_size = instrs.size();
+
+  // Append the other instructions now, since appending invalidates the
+  // PackedInstructions that refer to the stream.
+  auto append = [&](Instruction instr) {
+    instrs.Append(instr);
+    return instrs.size() - 1;
+  };
 
-  // Add params.
+  std::vector<Index> initial_instrs;
   for (u32 i = 0; i < type.param_types.size(); ++i) {
-    PushValue(NewValue(Instruction{At{Opcode::LocalGet}, At{i}}));
+    initial_instrs.push_back(append(Instruction{At{Opcode::LocalGet}, At{i}}));
   }
 
-  // Add locals, initialized to 0.
+  // Locals are initialized to 0.
   for (const auto& locals : code.locals) {
-    for (Index i = 0; i < locals->count; ++i) {
-      if (locals->type->is_numeric_type()) {
-        switch (locals->type->numeric_type()) {
-          case NumericType::I32:
-            PushValue(NewValue(Instruction{At{Opcode::I32Const}, At{s32{0}}}));
-            break;
-
-          case NumericType::F32:
-            PushValue(NewValue(Instruction{At{Opcode::F32Const}, At{f32{0}}}));
-            break;
-
-          case NumericType::I64:
-            PushValue(NewValue(Instruction{At{Opcode::I64Const}, At{s64{0}}}));
-            break;
-
-          case NumericType::F64:
-            PushValue(NewValue(Instruction{At{Opcode::F64Const}, At{f64{0}}}));
-            break;
-
-          case NumericType::V128:
-            PushValue(NewValue(Instruction{At{Opcode::V128Const}, At{v128{}}}));
-            break;
-        }
-      } else {
-        PushValue(NewValue(Instruction{At{Opcode::RefNull}}));
+    Index instr;
+    if (locals->type->is_numeric_type()) {
+      switch (locals->type->numeric_type()) {
+        case NumericType::I32:
+          instr = append(Instruction{At{Opcode::I32Const}, At{s32{0}}});
+          break;
+
+        case NumericType::F32:
+          instr = append(Instruction{At{Opcode::F32Const}, At{f32{0}}});
+          break;
+
+        case NumericType::I64:
+          instr = append(Instruction{At{Opcode::I64Const}, At{s64{0}}});
+          break;
+
+        case NumericType::F64:
+          instr = append(Instruction{At{Opcode::F64Const}, At{f64{0}}});
+          break;
+
+        case NumericType::V128:
+          instr = append(Instruction{At{Opcode::V128Const}, At{v128{}}});
+          break;
       }
+    } else {
+      instr = append(Instruction{At{Opcode::RefNull}});
     }
+    initial_instrs.insert(initial_instrs.end(), locals->count, instr);
+  }
+
+  undef_instr = append(Instruction{At{Opcode::Unreachable}});
+  Index return_instr = append(Instruction{At{Opcode::Return}});
+
+  // Create start block and label.
+  start_bbid = NewBlock();
+  StartBlock(start_bbid);
+
+  // Add params and locals.
+  for (Index instr : initial_instrs) {
+    PushValue(NewValue(instrs[instr]));
   }
 
   // Push a dummy label so the return value is still accessible after the final
@@ -356,17 +375,17 @@ void Tool::CalculateDFG(const FunctionType& type, Code code) {
   PushUndefValues(type.result_types.size());
   PushLabel(Opcode::Return, return_bbid, return_bbid);
 
-  for (const auto& instr : ReadExpression(code.body, module.context)) {
-    DoInstruction(instr);
+  for (Index i = 0; i < body_size; ++i) {
+    DoInstruction(instrs[i]);
   }
 
-  BasicInstruction(Instruction{At{Opcode::Return}}, type.result_types.size(),
-                   0);
+  BasicInstruction(instrs[return_instr], type.result_types.size(), 0);
   SealBlock(return_bbid);
 }
 
-void Tool::DoInstruction(const Instruction& instr) {
-  switch (instr.opcode) {
+void Tool::DoInstruction(const PackedInstruction& instr) {
+  auto opcode = instr.opcode();
+  switch (opcode) {
     case Opcode::Unreachable:
       MarkUnreachable();
       break;
@@ -375,7 +394,7 @@ void Tool::DoInstruction(const Instruction& instr) {
       auto value_count = BlockTypeToValueCount(instr.block_type_immediate());
       auto next = NewBlock(value_count);
       PushUndefValues(value_count);
-      PushLabel(instr.opcode, next, next);
+      PushLabel(opcode, next, next);
       break;
     }
 
@@ -385,7 +404,7 @@ void Tool::DoInstruction(const Instruction& instr) {
       auto next = NewBlock(value_count);
       AddPred(loop);
       PushUndefValues(value_count);
-      PushLabel(instr.opcode, loop, next);
+      PushLabel(opcode, loop, next);
       StartBlock(loop);
       break;
     }
@@ -397,7 +416,7 @@ void Tool::DoInstruction(const Instruction& instr) {
       AddPred(true_);
       BasicInstruction(instr, 1, 0);
       PushUndefValues(value_count);
-      PushLabel(instr.opcode, next, next);
+      PushLabel(opcode, next, next);
       StartBlock(true_);
       break;
     }
@@ -406,7 +425,7 @@ void Tool::DoInstruction(const Instruction& instr) {
       auto top = PopLabel();
       auto false_ = NewBlock();
       AddPred(false_, top.parent);
-      PushLabel(instr.opcode, top.next, top.next);
+      PushLabel(opcode, top.next, top.next);
       StartBlock(false_);
       break;
     }
@@ -435,12 +454,11 @@ void Tool::DoInstruction(const Instruction& instr) {
     }
 
     case Opcode::BrTable: {
-      const auto& immediate = instr.br_table_immediate();
       BasicInstruction(instr, 1, 0);
-      for (const auto& target : immediate->targets) {
+      for (Index target : instr.br_table_targets()) {
         Br(target);
       }
-      Br(immediate->default_target);
+      Br(instr.br_table_default_target());
       MarkUnreachable();
       break;
     }
@@ -457,9 +475,10 @@ void Tool::DoInstruction(const Instruction& instr) {
         BasicInstruction(instr, func_type_opt->param_types.size(),
                          func_type_opt->result_types.size());
       } else {
-        print(std::cerr, "*** Error: `{}` with unknown function\n", instr);
+        print(std::cerr, "*** Error: `{}` with unknown function\n",
+              *instr.ToInstruction());
       }
-      if (instr.opcode == Opcode::ReturnCall) {
+      if (opcode == Opcode::ReturnCall) {
         Return();
         MarkUnreachable();
       }
@@ -475,9 +494,10 @@ void Tool::DoInstruction(const Instruction& instr) {
         BasicInstruction(instr, func_type->param_types.size() + 1,
                          func_type->result_types.size());
       } else {
-        print(std::cerr, "*** Error: `{}` with unknown type\n", instr);
+        print(std::cerr, "*** Error: `{}` with unknown type\n",
+              *instr.ToInstruction());
       }
-      if (instr.opcode == Opcode::ReturnCallIndirect) {
+      if (opcode == Opcode::ReturnCallIndirect) {
         Return();
         MarkUnreachable();
       }
@@ -1068,7 +1088,7 @@ void Tool::Return() {
   Br(static_cast<Index>(labels.size() - 2));
 }
 
-ValueID Tool::NewValue(const Instruction& instr, size_t operand_count) {
+ValueID Tool::NewValue(const PackedInstruction& instr, size_t operand_count) {
   values.push_back(Value{current_bbid, instr, {}});
   auto value = static_cast<ValueID>(values.size() - 1);
   ValueIDs operands;
@@ -1085,7 +1105,7 @@ ValueID Tool::NewPhi(BBID bbid) {
 
 ValueID Tool::Undef() {
   if (undef == InvalidValueID) {
-    undef = NewValue(Instruction{At{Opcode::Unreachable}});
+    undef = NewValue(instrs[undef_instr]);
   }
   return undef;
 }
@@ -1154,7 +1174,7 @@ void Tool::PopValues(size_t count) {
   }
 }
 
-void Tool::BasicInstruction(const Instruction& instr,
+void Tool::BasicInstruction(const PackedInstruction& instr,
                             size_t operand_count,
                             size_t result_count) {
   assert(result_count <= 1);  // TODO support multi-value
@@ -1378,7 +1398,8 @@ void Tool::WriteDotFile() {
         if (value.is_phi()) {
           print(*stream, "phi");
         } else {
-          print(*stream, "{}", EscapeString(format("{}", *value.instr)));
+          print(*stream, "{}",
+                EscapeString(format("{}", *value.instr->ToInstruction())));
         }
         print(*stream, "\"]\n");
       }
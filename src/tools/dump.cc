@@ -26,6 +26,7 @@
 
 #include "src/tools/argparser.h"
 #include "src/tools/binary_errors.h"
+#include "wasp/base/at.h"
 #include "wasp/base/enumerate.h"
 #include "wasp/base/features.h"
 #include "wasp/base/file.h"
@@ -34,13 +35,17 @@
 #include "wasp/base/str_to_u32.h"
 #include "wasp/base/string_view.h"
 #include "wasp/base/types.h"
+#include "wasp/binary/code_section_index.h"
 #include "wasp/binary/formatters.h"
 #include "wasp/binary/lazy_expression.h"
 #include "wasp/binary/lazy_module.h"
+#include "wasp/binary/lazy_module_utils.h"
 #include "wasp/binary/linking_section/formatters.h"
 #include "wasp/binary/linking_section/sections.h"
+#include "wasp/binary/module_index.h"
 #include "wasp/binary/name_section/formatters.h"
 #include "wasp/binary/name_section/sections.h"
+#include "wasp/binary/section_directory.h"
 #include "wasp/binary/sections.h"
 #include "wasp/binary/visitor.h"
 
@@ -117,6 +122,7 @@ struct Tool {
     Tool& tool;
     Pass pass;
     SectionIndex section_index = 0;
+    optional<KnownSection> known_section;
     Index index = 0;
     Index function_count = 0;
     Index table_count = 0;
@@ -182,6 +188,7 @@ struct Tool {
   SpanU8 data;
   BinaryErrors errors;
   LazyModule module;
+  optional<ModuleIndex> module_index;
   std::vector<DefinedType> defined_types;
   std::vector<Function> functions;
   std::map<Index, string_view> function_names;
@@ -243,13 +250,14 @@ int Main(span<string_view> args) {
   }
 
   for (auto filename : filenames) {
-    auto optbuf = ReadFile(filename);
-    if (!optbuf) {
+    auto optfile = ReadFile(filename, MapFileTag{});
+    if (!optfile) {
       print(std::cerr, "Error reading file {}.\n", filename);
       continue;
     }
 
-    SpanU8 data{*optbuf};
+    SpanU8 data = optfile->data();
+    LocationBase location_base{data};
     Tool tool{filename, data, options};
     tool.Run();
     tool.errors.PrintTo(std::cerr);
@@ -263,7 +271,12 @@ Tool::Tool(string_view filename, SpanU8 data, Options options)
       options{options},
       data{data},
       errors{data},
-      module{ReadModule(data, options.features, errors)} {}
+      module{ReadModule(data, options.features, errors)},
+      module_index{LoadModuleIndex(filename, data)} {
+  if (module_index) {
+    module.index = &*module_index;
+  }
+}
 
 void Tool::Run() {
   if (!(module.magic && module.version)) {
@@ -297,7 +310,10 @@ void Tool::Run() {
 }
 
 void Tool::DoPrepass() {
-  for (auto section : enumerate(module.sections)) {
+  // Sections are read in module order, since the first name given to a
+  // function or global wins.
+  SectionDirectory directory{module};
+  for (auto section : enumerate(directory.sections())) {
     section_starts[section.index] = file_offset(section.value->data());
     if (section.value->is_known()) {
       auto known = section.value->known();
@@ -449,6 +465,9 @@ Tool::Visitor::Visitor(Tool& tool, Pass pass) : tool{tool}, pass{pass} {}
 
 visit::Result Tool::Visitor::OnSection(At<Section> section) {
   auto this_idx = section_index++;
+  known_section = section->is_known()
+                      ? optional<KnownSection>{section->known().value()}
+                      : nullopt;
   if (tool.SectionMatches(section)) {
     tool.DoSectionHeader(pass, section);
     if (section->is_custom()) {
@@ -749,6 +768,19 @@ visit::Result Tool::Visitor::BeginDataCountSection(DataCountSection section) {
 visit::Result Tool::Visitor::BeginCodeSection(LazyCodeSection section) {
   index = tool.imported_function_count;
   tool.DoCount(pass, section.count);
+  if (pass == Pass::Disassemble && tool.options.func_index && known_section) {
+    // Only one function is disassembled, so read its body directly instead of
+    // walking the whole section.
+    auto code_index =
+        tool.module.index && tool.module.index->code_section
+            ? *ReadCodeSectionIndex(tool.module)
+            : ReadCodeSectionIndex(*known_section, tool.module.context,
+                                   tool.imported_function_count);
+    if (auto code = code_index.GetCode(*tool.options.func_index)) {
+      tool.Disassemble(section_index, *tool.options.func_index, *code);
+    }
+    return visit::Result::Skip;
+  }
   return SkipUnless(tool.ShouldPrintDetails(pass) || pass == Pass::Disassemble);
 }
 
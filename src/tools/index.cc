@@ -0,0 +1,138 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "src/tools/index.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "fmt/format.h"
+#include "fmt/ostream.h"
+
+#include "src/tools/argparser.h"
+#include "src/tools/binary_errors.h"
+#include "wasp/base/at.h"
+#include "wasp/base/features.h"
+#include "wasp/base/file.h"
+#include "wasp/base/string_view.h"
+#include "wasp/binary/module_index.h"
+
+namespace wasp::tools::index {
+
+using fmt::print;
+
+using namespace ::wasp::binary;
+
+struct Options {
+  Features features;
+  bool verbose = false;
+  bool verify = false;
+};
+
+// Checks that the sidecar index of `filename` exists and matches the whole
+// module, not just its layout.
+bool VerifyFile(string_view filename, SpanU8 data, const Options& options) {
+  auto index_filename = GetModuleIndexFilename(filename);
+  auto index_file = ReadFile(index_filename, MapFileTag{});
+  if (!index_file) {
+    print(std::cerr, "{}: index file {} is missing.\n", filename,
+          index_filename);
+    return false;
+  }
+
+  auto index = ReadModuleIndex(index_file->data(), data);
+  if (!index || !VerifyModuleIndex(*index, data)) {
+    print(std::cerr, "{}: index file {} is out of date.\n", filename,
+          index_filename);
+    return false;
+  }
+
+  if (options.verbose) {
+    print("{}: OK\n", index_filename);
+  }
+  return true;
+}
+
+int Main(span<string_view> args) {
+  std::vector<string_view> filenames;
+  Options options;
+  options.features.EnableAll();
+
+  ArgParser parser{"wasp index"};
+  parser
+      .Add('h', "--help", "print help and exit",
+           [&]() { parser.PrintHelpAndExit(0); })
+      .Add('v', "--verbose",
+           "print the name of each index file written or verified",
+           [&]() { options.verbose = true; })
+      .Add("--verify",
+           "check that the existing index files match their modules, "
+           "instead of writing them",
+           [&]() { options.verify = true; })
+      .Add("<filenames...>", "input wasm files",
+           [&](string_view arg) { filenames.push_back(arg); });
+  parser.Parse(args);
+
+  if (filenames.empty()) {
+    print(std::cerr, "No filenames given.\n");
+    parser.PrintHelpAndExit(1);
+  }
+
+  bool ok = true;
+  for (auto filename : filenames) {
+    auto optfile = ReadFile(filename, MapFileTag{});
+    if (!optfile) {
+      print(std::cerr, "Error reading file {}.\n", filename);
+      ok = false;
+      continue;
+    }
+
+    SpanU8 data = optfile->data();
+    LocationBase location_base{data};
+    if (options.verify) {
+      ok &= VerifyFile(filename, data, options);
+      continue;
+    }
+
+    BinaryErrors errors{data};
+    auto index = BuildModuleIndex(data, options.features, errors);
+    if (errors.has_error()) {
+      errors.PrintTo(std::cerr);
+      ok = false;
+      continue;
+    }
+
+    auto index_filename = GetModuleIndexFilename(filename);
+    if (!SaveModuleIndex(filename, index)) {
+      print(std::cerr, "Unable to write file {}.\n", index_filename);
+      ok = false;
+      continue;
+    }
+    if (options.verbose) {
+      print("{}: {} imported functions, {} function bodies, {} function "
+            "names\n",
+            index_filename, index.GetImportCount(ExternalKind::Function),
+            index.code_offsets.empty() ? 0 : index.code_offsets.size() - 1,
+            index.function_names.size());
+    }
+  }
+
+  return ok ? 0 : 1;
+}
+
+}  // namespace wasp::tools::index
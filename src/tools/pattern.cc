@@ -28,6 +28,7 @@
 
 #include "src/tools/argparser.h"
 #include "src/tools/binary_errors.h"
+#include "wasp/base/at.h"
 #include "wasp/base/enumerate.h"
 #include "wasp/base/features.h"
 #include "wasp/base/file.h"
@@ -123,13 +124,14 @@ int Main(span<string_view> args) {
     parser.PrintHelpAndExit(1);
   }
 
-  auto optbuf = ReadFile(filename);
-  if (!optbuf) {
+  auto optfile = ReadFile(filename, MapFileTag{});
+  if (!optfile) {
     print(std::cerr, "Error reading file {}.\n", filename);
     return 1;
   }
 
-  SpanU8 data{*optbuf};
+  SpanU8 data = optfile->data();
+  LocationBase location_base{data};
   Tool tool{data, options};
 
   int result = tool.Run();
@@ -27,7 +27,7 @@
 namespace wasp::tools {
 
 TextErrors::TextErrors(string_view filename, SpanU8 data)
-    : filename{filename}, data{data} {}
+    : Errors{false}, filename{filename}, data{data} {}
 
 void TextErrors::PrintTo(std::ostream& os) const {
   if (has_error()) {
@@ -21,6 +21,7 @@
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -34,10 +35,11 @@
 #include "wasp/base/file.h"
 #include "wasp/base/formatters.h"
 #include "wasp/base/optional.h"
+#include "wasp/base/str_to_u32.h"
 #include "wasp/base/string_view.h"
+#include "wasp/base/thread_pool.h"
 #include "wasp/binary/formatters.h"
-#include "wasp/valid/context.h"
-#include "wasp/valid/validate_visitor.h"
+#include "wasp/valid/module_batch.h"
 
 namespace wasp {
 namespace tools {
@@ -49,20 +51,14 @@ using namespace ::wasp::binary;
 
 struct Options {
   Features features;
+  unsigned jobs = 1;
   bool verbose = false;
 };
 
-struct Tool {
-  explicit Tool(string_view filename, SpanU8 data, Options);
-
-  bool Run();
-
-  std::string filename;
-  Options options;
-  SpanU8 data;
-  BinaryErrors errors;
-  LazyModule module;
-  valid::ValidateVisitor visitor;
+struct FileResult {
+  bool read_file = false;
+  bool valid = false;
+  std::string errors;
 };
 
 int Main(span<string_view> args) {
@@ -75,6 +71,16 @@ int Main(span<string_view> args) {
            [&]() { parser.PrintHelpAndExit(0); })
       .Add('v', "--verbose", "print filename and whether it was valid",
            [&]() { options.verbose = true; })
+      .Add('j', "--jobs", "<n>",
+           "validate on <n> threads (0 uses one per core)",
+           [&](string_view arg) {
+             auto jobs = StrToU32(arg);
+             if (!jobs) {
+               print(std::cerr, "Invalid job count `{}`.\n", arg);
+               parser.PrintHelpAndExit(1);
+             }
+             options.jobs = *jobs;
+           })
       .AddFeatureFlags(options.features)
       .Add("<filenames...>", "input wasm files",
            [&](string_view arg) { filenames.push_back(arg); });
@@ -85,43 +91,43 @@ int Main(span<string_view> args) {
     parser.PrintHelpAndExit(1);
   }
 
-  bool ok = true;
+  ThreadPool pool{options.jobs};
+  valid::ModuleBatch batch{options.features, pool};
   for (auto filename : filenames) {
-    auto optbuf = ReadFile(filename);
-    if (!optbuf) {
-      print(std::cerr, "Error reading file {}.\n", filename);
-      ok = false;
-      continue;
-    }
+    batch.AddFile(filename);
+  }
 
-    SpanU8 data{*optbuf};
-    Tool tool{filename, data, options};
-    bool valid = tool.Run();
-    if (!valid || options.verbose) {
-      print("[{:^4}] {}\n", valid ? "OK" : "FAIL", filename);
-      tool.errors.PrintTo(std::cerr);
+  // The batch calls back on its worker threads, so format each file's errors
+  // there, and print them in order once all files are done.
+  std::vector<FileResult> results(filenames.size());
+  bool ok = batch.Run([&](const valid::ModuleBatchResult& result) {
+    auto& file_result = results[result.index];
+    file_result.read_file = result.read_file;
+    file_result.valid = result.valid;
+    if (result.read_file && (!result.valid || options.verbose)) {
+      BinaryErrors errors{result.data};
+      for (const auto& error : result.errors) {
+        errors.OnError(error.loc, error.message);
+      }
+      std::ostringstream stream;
+      errors.PrintTo(stream);
+      file_result.errors = stream.str();
+    }
+  });
+
+  for (auto pair : enumerate(filenames)) {
+    const auto& result = results[pair.index];
+    if (!result.read_file) {
+      print(std::cerr, "Error reading file {}.\n", pair.value);
+    } else if (!result.valid || options.verbose) {
+      print("[{:^4}] {}\n", result.valid ? "OK" : "FAIL", pair.value);
+      std::cerr << result.errors;
     }
-    ok &= valid;
   }
 
   return ok ? 0 : 1;
 }
 
-Tool::Tool(string_view filename, SpanU8 data, Options options)
-    : filename(filename),
-      options{options},
-      data{data},
-      errors{data},
-      module{ReadModule(data, options.features, errors)},
-      visitor{options.features, errors} {}
-
-bool Tool::Run() {
-  if (module.magic && module.version) {
-    visit::Visit(module, visitor);
-  }
-  return !errors.has_error();
-}
-
 }  // namespace validate
 }  // namespace tools
 }  // namespace wasp
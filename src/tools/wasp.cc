@@ -26,6 +26,7 @@
 #include "src/tools/cfg.h"
 #include "src/tools/dfg.h"
 #include "src/tools/dump.h"
+#include "src/tools/index.h"
 #include "src/tools/pattern.h"
 #include "src/tools/validate.h"
 #include "src/tools/wat2wasm.h"
@@ -51,6 +52,7 @@ int main(int argc, char** argv) {
       {"callgraph", wasp::tools::callgraph::Main},
       {"cfg", wasp::tools::cfg::Main},
       {"dfg", wasp::tools::dfg::Main},
+      {"index", wasp::tools::index::Main},
       {"validate", wasp::tools::validate::Main},
       {"pattern", wasp::tools::pattern::Main},
       {"wat2wasm", wasp::tools::wat2wasm::Main},
@@ -79,6 +81,7 @@ void PrintHelp(int errcode) {
   print(std::cerr, "  callgraph   Generate DOT file for the function call graph.\n");
   print(std::cerr, "  cfg         Generate DOT file of a function's control flow graph.\n");
   print(std::cerr, "  dfg         Generate DOT file of a function's data flow graph.\n");
+  print(std::cerr, "  index       Write an index file to speed up later commands.\n");
   print(std::cerr, "  validate    Validate a WebAssembly file.\n");
   print(std::cerr, "  pattern     Find common instruction sequences.\n");
   print(std::cerr, "  wat2wasm    Convert a WebAssembly text file to binary.\n");
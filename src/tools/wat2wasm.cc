@@ -23,6 +23,7 @@
 
 #include "src/tools/argparser.h"
 #include "src/tools/text_errors.h"
+#include "wasp/base/at.h"
 #include "wasp/base/buffer.h"
 #include "wasp/base/errors.h"
 #include "wasp/base/features.h"
@@ -101,8 +102,8 @@ int Main(span<string_view> args) {
     parser.PrintHelpAndExit(1);
   }
 
-  auto optbuf = ReadFile(filename);
-  if (!optbuf) {
+  auto optfile = ReadFile(filename, MapFileTag{});
+  if (!optfile) {
     print(std::cerr, "Error reading file {}.\n", filename);
     return 1;
   }
@@ -113,7 +114,8 @@ int Main(span<string_view> args) {
         fs::path(filename).replace_extension(".wasm").string();
   }
 
-  SpanU8 data{*optbuf};
+  SpanU8 data = optfile->data();
+  LocationBase location_base{data};
   Tool tool{filename, data, options};
   return tool.Run();
 }
@@ -0,0 +1,389 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/valid/canonical_types.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+#include "wasp/base/hash.h"
+#include "wasp/base/hashmap.h"
+#include "wasp/valid/types.h"
+
+namespace wasp::valid {
+
+namespace {
+
+using namespace ::wasp::binary;
+
+// A type is written as a sequence of tokens, where each type index is replaced
+// by the current ID of that type.
+using Signature = std::vector<u32>;
+
+enum : u32 {
+  kFunctionType,
+  kStructType,
+  kArrayType,
+  kNumericType,
+  kReferenceType,
+  kRtt,
+  kPackedType,
+  kHeapKind,
+  kTypeId,
+  kUnknownIndex,
+};
+
+struct SignatureHash {
+  size_t operator()(const Signature& signature) const {
+    return HashContainer(signature);
+  }
+};
+
+using SignatureMap = flat_hash_map<Signature, Index, SignatureHash>;
+
+class SignatureWriter {
+ public:
+  // If `refs` is non-null, the index of every type that is referenced is
+  // appended to it.
+  SignatureWriter(const std::vector<Index>& ids,
+                  Signature& out,
+                  std::vector<Index>* refs = nullptr)
+      : ids_{ids}, out_{out}, refs_{refs} {}
+
+  void Write(const DefinedType& type) {
+    if (type.is_function_type()) {
+      out_.push_back(kFunctionType);
+      Write(type.function_type()->param_types);
+      Write(type.function_type()->result_types);
+    } else if (type.is_struct_type()) {
+      const auto& fields = type.struct_type()->fields;
+      out_.push_back(kStructType);
+      out_.push_back(static_cast<u32>(fields.size()));
+      for (const auto& field : fields) {
+        Write(field);
+      }
+    } else {
+      assert(type.is_array_type());
+      out_.push_back(kArrayType);
+      Write(type.array_type()->field);
+    }
+  }
+
+ private:
+  void Write(const HeapType& type) {
+    if (type.is_heap_kind()) {
+      out_.push_back(kHeapKind);
+      out_.push_back(static_cast<u32>(type.heap_kind().value()));
+      return;
+    }
+
+    Index index = type.index();
+    if (index < ids_.size()) {
+      if (refs_) {
+        refs_->push_back(index);
+      }
+      out_.push_back(kTypeId);
+      out_.push_back(ids_[index]);
+    } else {
+      out_.push_back(kUnknownIndex);
+      out_.push_back(index);
+    }
+  }
+
+  void Write(const ValueType& type) {
+    if (type.is_numeric_type()) {
+      out_.push_back(kNumericType);
+      out_.push_back(static_cast<u32>(type.numeric_type().value()));
+    } else if (type.is_reference_type()) {
+      // Canonicalize in case one of the types is "ref null X" and the other is
+      // "Xref".
+      ReferenceType reference_type = Canonicalize(type.reference_type());
+      assert(reference_type.is_ref());
+      const RefType& ref = reference_type.ref();
+      out_.push_back(kReferenceType);
+      out_.push_back(static_cast<u32>(ref.null));
+      Write(ref.heap_type.value());
+    } else {
+      assert(type.is_rtt());
+      out_.push_back(kRtt);
+      out_.push_back(type.rtt()->depth);
+      Write(type.rtt()->type.value());
+    }
+  }
+
+  void Write(const ValueTypeList& types) {
+    out_.push_back(static_cast<u32>(types.size()));
+    for (const auto& type : types) {
+      Write(type.value());
+    }
+  }
+
+  void Write(const FieldType& field) {
+    if (field.type->is_value_type()) {
+      Write(field.type->value_type().value());
+    } else {
+      out_.push_back(kPackedType);
+      out_.push_back(static_cast<u32>(field.type->packed_type().value()));
+    }
+    out_.push_back(static_cast<u32>(field.mut.value()));
+  }
+
+  const std::vector<Index>& ids_;
+  Signature& out_;
+  std::vector<Index>* refs_;
+};
+
+}  // namespace
+
+auto CanonicalizeTypes(const std::vector<DefinedType>& types)
+    -> std::vector<Index> {
+  const auto type_count = static_cast<Index>(types.size());
+  std::vector<Index> ids(type_count);
+  Signature signature;
+
+  // Collect the types that each type refers to.
+  std::vector<Index> refs;
+  std::vector<Index> refs_begin(type_count + 1);
+  for (Index i = 0; i < type_count; ++i) {
+    refs_begin[i] = static_cast<Index>(refs.size());
+    SignatureWriter{ids, signature, &refs}.Write(types[i]);
+    signature.clear();
+  }
+  refs_begin[type_count] = static_cast<Index>(refs.size());
+
+  // Visit the types depth-first. A type that can reach a cycle is recursive;
+  // every other type is finished only after the types it refers to, so its
+  // signature can be hash-consed directly.
+  enum class State : u8 { New, Active, Finite, Recursive };
+  struct Frame {
+    Index type;
+    Index next_ref;
+    bool recursive;
+  };
+
+  std::vector<State> states(type_count, State::New);
+  std::vector<Frame> stack;
+  SignatureMap interned;
+  Index next_id = 0;
+  for (Index root = 0; root < type_count; ++root) {
+    if (states[root] != State::New) {
+      continue;
+    }
+    states[root] = State::Active;
+    stack.push_back(Frame{root, refs_begin[root], false});
+    while (!stack.empty()) {
+      Frame& frame = stack.back();
+      if (frame.next_ref < refs_begin[frame.type + 1]) {
+        Index ref = refs[frame.next_ref++];
+        switch (states[ref]) {
+          case State::New:
+            states[ref] = State::Active;
+            stack.push_back(Frame{ref, refs_begin[ref], false});
+            break;
+
+          case State::Active:
+          case State::Recursive:
+            frame.recursive = true;
+            break;
+
+          case State::Finite:
+            break;
+        }
+        continue;
+      }
+
+      Frame done = frame;
+      stack.pop_back();
+      if (done.recursive) {
+        states[done.type] = State::Recursive;
+        if (!stack.empty()) {
+          stack.back().recursive = true;
+        }
+      } else {
+        states[done.type] = State::Finite;
+        signature.clear();
+        SignatureWriter{ids, signature}.Write(types[done.type]);
+        auto [iter, inserted] = interned.try_emplace(signature, next_id);
+        if (inserted) {
+          next_id++;
+        }
+        ids[done.type] = iter->second;
+      }
+    }
+  }
+
+  // A recursive type can't be the same as a finite one, so the recursive types
+  // get IDs starting at `first_block`. Each ID is a block of types that may
+  // still be the same; they all start in one block.
+  //
+  // A block is split by the signatures of its members. When a type moves to a
+  // new block, only the types that refer to it can change signature, so only
+  // those are checked again. As in Hopcroft's algorithm, the largest part of a
+  // split block keeps its ID, so a type moves at most log2(n) times. Checking
+  // every type in every round instead takes O(n^2) for a long chain of types.
+  const Index first_block = next_id;
+  std::vector<std::vector<Index>> blocks;
+  // The position of each type in its block.
+  std::vector<Index> positions(type_count);
+  std::vector<Index> touched;
+  std::vector<bool> is_touched(type_count);
+  for (Index i = 0; i < type_count; ++i) {
+    if (states[i] == State::Recursive) {
+      if (blocks.empty()) {
+        blocks.emplace_back();
+      }
+      ids[i] = first_block;
+      positions[i] = static_cast<Index>(blocks[0].size());
+      blocks[0].push_back(i);
+      touched.push_back(i);
+      is_touched[i] = true;
+    }
+  }
+
+  // Collect the types that refer to each type. Only recursive types can refer
+  // to a recursive type.
+  std::vector<Index> referrers(refs.size());
+  std::vector<Index> referrers_begin(type_count + 1);
+  for (Index ref : refs) {
+    referrers_begin[ref + 1]++;
+  }
+  for (Index i = 0; i < type_count; ++i) {
+    referrers_begin[i + 1] += referrers_begin[i];
+  }
+  {
+    std::vector<Index> next = referrers_begin;
+    for (Index i = 0; i < type_count; ++i) {
+      for (Index j = refs_begin[i]; j < refs_begin[i + 1]; ++j) {
+        referrers[next[refs[j]]++] = i;
+      }
+    }
+  }
+
+  // The types of a block whose signature is unchanged since the block was last
+  // checked all have the same signature, so one of them stands for the rest.
+  // The splits of a round are all found before any type is moved, so every
+  // block is checked with the same IDs.
+  struct Move {
+    Index type;
+    Index block;
+  };
+  std::vector<Move> moves;
+  std::vector<std::vector<Index>> groups;
+  std::vector<size_t> group_sizes;
+  SignatureMap group_map;
+  while (!touched.empty()) {
+    std::sort(touched.begin(), touched.end(), [&](Index lhs, Index rhs) {
+      return std::make_pair(ids[lhs], lhs) < std::make_pair(ids[rhs], rhs);
+    });
+
+    moves.clear();
+    for (size_t begin = 0; begin < touched.size();) {
+      const Index block = ids[touched[begin]] - first_block;
+      size_t end = begin;
+      while (end < touched.size() &&
+             ids[touched[end]] - first_block == block) {
+        ++end;
+      }
+
+      groups.clear();
+      group_sizes.clear();
+      group_map.clear();
+      const auto& members = blocks[block];
+      const size_t untouched = members.size() - (end - begin);
+      if (untouched > 0) {
+        // At most `end - begin` members are skipped.
+        Index other =
+            *std::find_if(members.begin(), members.end(),
+                          [&](Index type) { return !is_touched[type]; });
+        signature.clear();
+        SignatureWriter{ids, signature}.Write(types[other]);
+        group_map.emplace(signature, 0);
+        groups.emplace_back();
+        group_sizes.push_back(untouched);
+      }
+      for (size_t i = begin; i < end; ++i) {
+        Index type = touched[i];
+        signature.clear();
+        SignatureWriter{ids, signature}.Write(types[type]);
+        auto [iter, inserted] =
+            group_map.try_emplace(signature, static_cast<Index>(groups.size()));
+        if (inserted) {
+          groups.emplace_back();
+          group_sizes.push_back(0);
+        }
+        groups[iter->second].push_back(type);
+        group_sizes[iter->second]++;
+      }
+
+      if (groups.size() > 1) {
+        size_t largest = std::max_element(group_sizes.begin(),
+                                          group_sizes.end()) -
+                         group_sizes.begin();
+        for (size_t group = 0; group < groups.size(); ++group) {
+          if (group == largest) {
+            continue;
+          }
+          auto new_block = static_cast<Index>(blocks.size());
+          if (group == 0 && untouched > 0) {
+            for (Index type : blocks[block]) {
+              if (!is_touched[type]) {
+                moves.push_back(Move{type, new_block});
+              }
+            }
+          }
+          for (Index type : groups[group]) {
+            moves.push_back(Move{type, new_block});
+          }
+          blocks.emplace_back();
+        }
+      }
+      begin = end;
+    }
+
+    for (Index type : touched) {
+      is_touched[type] = false;
+    }
+    touched.clear();
+    for (auto move : moves) {
+      // Remove the type from its block by swapping it with the last one.
+      auto& old_members = blocks[ids[move.type] - first_block];
+      Index last = old_members.back();
+      old_members[positions[move.type]] = last;
+      positions[last] = positions[move.type];
+      old_members.pop_back();
+
+      auto& new_members = blocks[move.block];
+      positions[move.type] = static_cast<Index>(new_members.size());
+      new_members.push_back(move.type);
+      ids[move.type] = first_block + move.block;
+
+      for (Index j = referrers_begin[move.type];
+           j < referrers_begin[move.type + 1]; ++j) {
+        Index referrer = referrers[j];
+        if (!is_touched[referrer]) {
+          is_touched[referrer] = true;
+          touched.push_back(referrer);
+        }
+      }
+    }
+  }
+
+  return ids;
+}
+
+}  // namespace wasp::valid
@@ -18,15 +18,19 @@
 
 #include <cassert>
 
+#include "wasp/valid/canonical_types.h"
+
 namespace wasp::valid {
 
 Label::Label(LabelType label_type,
-             StackTypeSpan param_types,
-             StackTypeSpan result_types,
+             Index types_begin,
+             Index param_count,
+             Index result_count,
              Index type_stack_limit)
     : label_type{label_type},
-      param_types{param_types.begin(), param_types.end()},
-      result_types{result_types.begin(), result_types.end()},
+      types_begin{types_begin},
+      param_count{param_count},
+      result_count{result_count},
       type_stack_limit{type_stack_limit},
       unreachable{false} {}
 
@@ -41,7 +45,31 @@ Context::Context(const Context& other, Errors& errors) {
 }
 
 void Context::Reset() {
-  *this = Context{features, *errors};
+  // Clear the containers instead of replacing them, so their buffers are
+  // reused when a Context validates more than one module.
+  types.clear();
+  functions.clear();
+  tables.clear();
+  memories.clear();
+  globals.clear();
+  events.clear();
+  element_segments.clear();
+  defined_type_count = 0;
+  imported_function_count = 0;
+  imported_global_count = 0;
+  declared_data_count = nullopt;
+  code_count = 0;
+  locals.Reset();
+  type_stack.clear();
+  label_stack.clear();
+  label_types.clear();
+  scratch_types.clear();
+  // flat_hash_set::clear() frees large tables; erase the elements instead so
+  // the storage is reused by the next module.
+  export_names.erase(export_names.begin(), export_names.end());
+  declared_functions.clear();
+  canonical_type_ids.clear();
+  match_types.Reset();
 }
 
 bool Context::IsStackPolymorphic() const {
@@ -49,6 +77,86 @@ bool Context::IsStackPolymorphic() const {
   return label_stack.back().unreachable;
 }
 
+auto Context::GetCanonicalTypeId(Index index) -> optional<Index> {
+  UpdateCanonicalTypeIds();
+  if (index >= canonical_type_ids.size()) {
+    return nullopt;
+  }
+  return canonical_type_ids[index];
+}
+
+void Context::UpdateCanonicalTypeIds() {
+  if (canonical_type_ids.size() != types.size()) {
+    canonical_type_ids = CanonicalizeTypes(types);
+    match_types.Reset();
+  }
+}
+
+void Context::DeclareFunction(Index index) {
+  if (index >= functions.size()) {
+    return;
+  }
+  if (declared_functions.size() < functions.size()) {
+    declared_functions.resize(functions.size());
+  }
+  declared_functions[index] = true;
+}
+
+bool Context::IsFunctionDeclared(Index index) const {
+  return index < declared_functions.size() && declared_functions[index];
+}
+
+void Context::PushLabel(LabelType label_type,
+                        StackTypeSpan param_types,
+                        StackTypeSpan result_types,
+                        Index type_stack_limit) {
+  auto types_begin = static_cast<Index>(label_types.size());
+  label_types.insert(label_types.end(), param_types.begin(), param_types.end());
+  label_types.insert(label_types.end(), result_types.begin(),
+                     result_types.end());
+  label_stack.emplace_back(label_type, types_begin,
+                           static_cast<Index>(param_types.size()),
+                           static_cast<Index>(result_types.size()),
+                           type_stack_limit);
+}
+
+void Context::PushLabel(LabelType label_type,
+                        const binary::FunctionType& function_type,
+                        Index type_stack_limit) {
+  auto types_begin = static_cast<Index>(label_types.size());
+  for (auto value_type : function_type.param_types) {
+    label_types.push_back(StackType{*value_type});
+  }
+  for (auto value_type : function_type.result_types) {
+    label_types.push_back(StackType{*value_type});
+  }
+  label_stack.emplace_back(
+      label_type, types_begin,
+      static_cast<Index>(function_type.param_types.size()),
+      static_cast<Index>(function_type.result_types.size()), type_stack_limit);
+}
+
+void Context::PopLabel() {
+  assert(!label_stack.empty());
+  label_types.resize(label_stack.back().types_begin);
+  label_stack.pop_back();
+}
+
+StackTypeSpan Context::GetParamTypes(const Label& label) const {
+  return StackTypeSpan{label_types}.subspan(label.types_begin,
+                                            label.param_count);
+}
+
+StackTypeSpan Context::GetResultTypes(const Label& label) const {
+  return StackTypeSpan{label_types}.subspan(
+      label.types_begin + label.param_count, label.result_count);
+}
+
+StackTypeSpan Context::GetBrTypes(const Label& label) const {
+  return label.label_type == LabelType::Loop ? GetParamTypes(label)
+                                             : GetResultTypes(label);
+}
+
 bool Context::IsFunctionType(Index index) const {
   return index < types.size() && types[index].is_function_type();
 }
@@ -61,52 +169,41 @@ bool Context::IsArrayType(Index index) const {
   return index < types.size() && types[index].is_array_type();
 }
 
-void TypeRelationSet::Reset(Index size) {
-  disjoint_set_.Reset(size);
-  assume_.clear();
+void TypeRelationSet::Reset() {
+  results_.clear();
+  keys_.clear();
 }
 
-auto TypeRelationSet::Get(Index expected, Index actual) -> optional<bool> {
-  MaybeSwapIndexes(expected, actual);
-  if (!(disjoint_set_.IsValid(expected) && disjoint_set_.IsValid(actual))) {
-    // If the indexes are invalid, then there's no point in checking whether
-    // they're equal.
-    return false;
-  }
-
-  if (disjoint_set_.IsSameSet(expected, actual)) {
-    return true;
-  }
-
-  auto iter = assume_.find({expected, actual});
-  if (iter == assume_.end()) {
+auto TypeRelationSet::Get(Index expected, Index actual) const
+    -> optional<bool> {
+  auto iter = results_.find(MakeKey(expected, actual));
+  if (iter == results_.end()) {
     return nullopt;
   }
-
   return iter->second;
 }
 
 void TypeRelationSet::Assume(Index expected, Index actual) {
-  MaybeSwapIndexes(expected, actual);
-  assume_.insert({{expected, actual}, true});
-}
-
-void TypeRelationSet::Resolve(Index expected, Index actual, bool is_same) {
-  MaybeSwapIndexes(expected, actual);
-  auto iter = assume_.find({expected, actual});
-  assert(iter != assume_.end());
-  if (is_same) {
-    disjoint_set_.MergeSets(expected, actual);
-    assume_.erase(iter);
-  } else {
-    iter->second = false;
-  }
+  auto key = MakeKey(expected, actual);
+  results_.insert({key, true});
+  keys_.push_back(key);
 }
 
-void TypeRelationSet::MaybeSwapIndexes(Index& lhs, Index& rhs) {
-  if (lhs > rhs) {
-    std::swap(lhs, rhs);
+void TypeRelationSet::Resolve(Index expected, Index actual, bool is_related) {
+  auto key = MakeKey(expected, actual);
+  assert(results_.find(key) != results_.end());
+  if (!is_related) {
+    while (keys_.back() != key) {
+      results_.erase(keys_.back());
+      keys_.pop_back();
+    }
+    results_[key] = false;
   }
 }
 
+// static
+u64 TypeRelationSet::MakeKey(Index expected, Index actual) {
+  return (u64{expected} << 32) | actual;
+}
+
 }  // namespace wasp::valid
@@ -43,17 +43,9 @@ bool IsSame(Context& context,
       return true;
     }
 
-    auto is_same_opt = context.same_types.Get(expected_index, actual_index);
-    if (is_same_opt) {
-      return *is_same_opt;
-    }
-
-    // Assume that they are the same and check that everything still is valid.
-    context.same_types.Assume(expected_index, actual_index);
-    bool is_same = IsSame(context, context.types[expected_index],
-                          context.types[actual_index]);
-    context.same_types.Resolve(expected_index, actual_index, is_same);
-    return is_same;
+    auto expected_id = context.GetCanonicalTypeId(expected_index);
+    auto actual_id = context.GetCanonicalTypeId(actual_index);
+    return expected_id && actual_id && *expected_id == *actual_id;
   }
   return false;
 }
@@ -235,19 +227,27 @@ bool IsMatch(Context& context,
       return true;
     }
 
-    // Check whether heap types match, but make sure to handle recursive
-    // structures. This is the same logic used in IsSame(HeapType, HeapType).
+    auto expected_id = context.GetCanonicalTypeId(expected_index);
+    auto actual_id = context.GetCanonicalTypeId(actual_index);
+    if (!(expected_id && actual_id)) {
+      return false;
+    }
+    if (*expected_id == *actual_id) {
+      return true;
+    }
 
-    auto is_match_opt = context.match_types.Get(expected_index, actual_index);
+    // Check whether heap types match, but make sure to handle recursive
+    // structures.
+    auto is_match_opt = context.match_types.Get(*expected_id, *actual_id);
     if (is_match_opt) {
       return *is_match_opt;
     }
 
     // Assume that they match and check that everything still is valid.
-    context.match_types.Assume(expected_index, actual_index);
+    context.match_types.Assume(*expected_id, *actual_id);
     bool is_match = IsMatch(context, context.types[expected_index],
                             context.types[actual_index]);
-    context.match_types.Resolve(expected_index, actual_index, is_match);
+    context.match_types.Resolve(*expected_id, *actual_id, is_match);
     return is_match;
   }
 
@@ -0,0 +1,147 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/valid/module_batch.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "wasp/base/at.h"
+#include "wasp/base/errors.h"
+#include "wasp/base/file.h"
+#include "wasp/base/thread_pool.h"
+#include "wasp/binary/lazy_module.h"
+#include "wasp/binary/visitor.h"
+#include "wasp/valid/validate_visitor.h"
+
+namespace wasp::valid {
+
+namespace {
+
+// Collects the errors of one module. Cleared before each module, so the
+// vector's capacity is reused.
+class ErrorList : public Errors {
+ public:
+  ErrorList() : Errors{false} {}
+
+  void Clear() { errors.clear(); }
+  bool has_error() const { return !errors.empty(); }
+
+  std::vector<Error> errors;
+
+ protected:
+  void HandlePushContext(Location loc, string_view desc) override {}
+  void HandlePopContext() override {}
+  void HandleOnError(Location loc, string_view message) override {
+    errors.push_back(Error{loc, std::string(message)});
+  }
+};
+
+}  // namespace
+
+struct ModuleBatch::Worker {
+  explicit Worker(const Features& features) : visitor{features, errors} {}
+
+  ErrorList errors;
+  ValidateVisitor visitor;
+};
+
+ModuleBatch::ModuleBatch(const Features& features, ThreadPool& pool)
+    : features_{features}, pool_{pool} {}
+
+ModuleBatch::~ModuleBatch() = default;
+
+void ModuleBatch::Add(SpanU8 data) {
+  items_.push_back(Item{std::string{}, data, false});
+}
+
+void ModuleBatch::AddFile(string_view filename) {
+  items_.push_back(Item{std::string{filename}, SpanU8{}, true});
+}
+
+void ModuleBatch::Clear() {
+  items_.clear();
+}
+
+bool ModuleBatch::Run(const ModuleBatchCallback& callback) {
+  const Index count = size();
+  if (count == 1 && pool_.size() > 1) {
+    // Validate a single module on the calling thread, so the pool's threads
+    // are free to validate its function bodies in parallel.
+    if (workers_.empty()) {
+      workers_.push_back(std::make_unique<Worker>(features_));
+    }
+    Worker& worker = *workers_[0];
+    worker.visitor.pool = &pool_;
+    bool valid = Process(worker, 0, callback);
+    worker.visitor.pool = nullptr;
+    return valid;
+  }
+
+  // ParallelFor uses at most one worker per module.
+  const auto worker_count = std::min<Index>(pool_.size(), count);
+  while (workers_.size() < worker_count) {
+    workers_.push_back(std::make_unique<Worker>(features_));
+  }
+
+  std::atomic<bool> all_valid{true};
+  pool_.ParallelFor(count, 1, [&](unsigned worker, size_t begin, size_t end) {
+    for (size_t index = begin; index < end; ++index) {
+      if (!Process(*workers_[worker], static_cast<Index>(index), callback)) {
+        all_valid = false;
+      }
+    }
+  });
+  return all_valid;
+}
+
+bool ModuleBatch::Process(Worker& worker,
+                          Index index,
+                          const ModuleBatchCallback& callback) {
+  const auto& item = items_[index];
+  ModuleBatchResult result;
+  result.index = index;
+  result.filename = item.filename;
+
+  optional<MappedFile> file;
+  SpanU8 data = item.data;
+  if (item.is_file) {
+    file = ReadFile(item.filename, MapFileTag{});
+    if (!file) {
+      result.read_file = false;
+      callback(result);
+      return false;
+    }
+    data = file->data();
+  }
+
+  LocationBase location_base{data};
+  worker.errors.Clear();
+  worker.visitor.context.Reset();
+  auto module = binary::ReadModule(data, features_, worker.errors);
+  if (module.magic && module.version) {
+    binary::visit::Visit(module, worker.visitor);
+  }
+
+  result.data = data;
+  result.valid = !worker.errors.has_error();
+  result.errors = worker.errors.errors;
+  callback(result);
+  return result.valid;
+}
+
+}  // namespace wasp::valid
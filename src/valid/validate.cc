@@ -33,8 +33,13 @@ namespace wasp::valid {
 
 bool BeginTypeSection(Context& context, Index type_count) {
   context.defined_type_count = type_count;
-  context.same_types.Reset(type_count);
-  context.match_types.Reset(type_count);
+  context.canonical_type_ids.clear();
+  context.match_types.Reset();
+  return true;
+}
+
+bool BeginExportSection(Context& context, Index export_count) {
+  context.export_names.reserve(context.export_names.size() + export_count);
   return true;
 }
 
@@ -50,6 +55,7 @@ bool BeginCode(Context& context, Location loc) {
   const binary::Function& function = context.functions[func_index];
   context.type_stack.clear();
   context.label_stack.clear();
+  context.label_types.clear();
   context.locals.Reset();
   // Don't validate the index, should have already been validated at this point.
   if (function.type_index < context.defined_type_count) {
@@ -63,13 +69,11 @@ bool BeginCode(Context& context, Location loc) {
     assert(defined_type.is_function_type());
     const auto& function_type = defined_type.function_type();
     context.locals.Append(function_type->param_types);
-    context.label_stack.push_back(
-        Label{LabelType::Function, ToStackTypeList(function_type->param_types),
-              ToStackTypeList(function_type->result_types), 0});
+    context.PushLabel(LabelType::Function, *function_type, 0);
     return true;
   } else {
     // Not valid, but try to continue anyway.
-    context.label_stack.push_back(Label{LabelType::Function, {}, {}, 0});
+    context.PushLabel(LabelType::Function, {}, {}, 0);
     return false;
   }
 }
@@ -189,7 +193,7 @@ bool Validate(Context& context,
       auto index = instruction->index_immediate();
       // ref.func indexes are implicitly declared by referencing them in a
       // constant expression.
-      context.declared_functions.insert(index);
+      context.DeclareFunction(index);
       if (!ValidateIndex(context, index, static_cast<Index>(context.functions.size()),
                          "func index")) {
         return false;
@@ -259,7 +263,7 @@ bool Validate(Context& context,
                          "function index")) {
         valid = false;
       }
-      context.declared_functions.insert(index);
+      context.DeclareFunction(index);
       break;
     }
 
@@ -314,7 +318,7 @@ bool Validate(Context& context, const At<binary::ElementSegment>& value) {
     for (auto index : elements.list) {
       valid &= ValidateIndex(context, index, max_index, "index");
       if (elements.kind == ExternalKind::Function) {
-        context.declared_functions.insert(index);
+        context.DeclareFunction(index);
       }
     }
   } else if (value->has_expressions()) {
@@ -332,18 +336,17 @@ bool Validate(Context& context, const At<binary::Export>& value) {
   ErrorsContextGuard guard{*context.errors, value.loc(), "export"};
   bool valid = true;
 
-  if (context.export_names.find(value->name) != context.export_names.end()) {
+  if (!context.export_names.insert(value->name).second) {
     context.errors->OnError(value.loc(),
                             concat("Duplicate export name ", value->name));
     valid = false;
   }
-  context.export_names.insert(value->name);
 
   switch (value->kind) {
     case ExternalKind::Function:
       valid &= ValidateIndex(context, value->index, static_cast<Index>(context.functions.size()),
                              "function index");
-      context.declared_functions.insert(value->index);
+      context.DeclareFunction(value->index);
       break;
 
     case ExternalKind::Table:
@@ -698,14 +701,22 @@ bool Validate(Context& context, const At<binary::DefinedType>& value) {
   ErrorsContextGuard guard{*context.errors, value.loc(), "defined type"};
   context.types.push_back(value);
 
+  bool valid;
   if (value->is_function_type()) {
-    return Validate(context, value->function_type());
+    valid = Validate(context, value->function_type());
   } else if (value->is_struct_type()) {
-    return Validate(context, value->struct_type());
+    valid = Validate(context, value->struct_type());
   } else {
     assert(value->is_array_type());
-    return Validate(context, value->array_type());
+    valid = Validate(context, value->array_type());
   }
+
+  // Canonicalize once the whole type section has been seen, so it is done
+  // before any copies of the context are made to validate function bodies.
+  if (context.types.size() == context.defined_type_count) {
+    context.UpdateCanonicalTypeIds();
+  }
+  return valid;
 }
 
 bool Validate(Context& context, const At<binary::ValueType>& value) {
@@ -763,6 +774,8 @@ bool Validate(Context& context, const binary::Module& value) {
   valid &= ValidateKnownSection(context, value.memories);
   valid &= ValidateKnownSection(context, value.globals);
   valid &= ValidateKnownSection(context, value.events);
+  valid &=
+      BeginExportSection(context, static_cast<Index>(value.exports.size()));
   valid &= ValidateKnownSection(context, value.exports);
   valid &= ValidateKnownSection(context, value.start);
   valid &= ValidateKnownSection(context, value.element_segments);
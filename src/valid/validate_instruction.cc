@@ -26,6 +26,7 @@
 #include "wasp/base/macros.h"
 #include "wasp/base/types.h"
 #include "wasp/binary/formatters.h"
+#include "wasp/binary/packed_instruction_stream.h"
 #include "wasp/valid/context.h"
 #include "wasp/valid/formatters.h"
 #include "wasp/valid/match.h"
@@ -79,15 +80,15 @@ bool AllTrue(T first, Args... rest) {
   return !!first & AllTrue(rest...);
 }
 
-optional<FunctionType> GetFunctionType(Context& context, At<Index> index) {
+const FunctionType* GetFunctionType(Context& context, At<Index> index) {
   if (!ValidateIndex(context, index, static_cast<Index>(context.types.size()), "type index")) {
-    return nullopt;
+    return nullptr;
   }
   if (!context.types[index].is_function_type()) {
     context.errors->OnError(index.loc(), "Expected a function type");
-    return nullopt;
+    return nullptr;
   }
-  return context.types[index].function_type();
+  return &context.types[index].function_type().value();
 }
 
 optional<StructType> GetStructType(Context& context, At<Index> index) {
@@ -163,22 +164,6 @@ optional<PackedType> GetStructFieldPackedType(Context& context,
   return GetFieldPackedType(context, loc, *field_type);
 }
 
-optional<FunctionType> GetBlockTypeSignature(Context& context,
-                                             BlockType block_type) {
-  if (block_type.is_void()) {
-    return FunctionType{};
-  } else if (block_type.is_value_type()) {
-    const auto& value_type = block_type.value_type();
-    if (!Validate(context, value_type)) {
-      return nullopt;
-    }
-    return FunctionType{{}, {value_type}};
-  } else {
-    assert(block_type.is_index());
-    return GetFunctionType(context, block_type.index());
-  }
-}
-
 Label& TopLabel(Context& context) {
   assert(!context.label_stack.empty());
   return context.label_stack.back();
@@ -259,8 +244,9 @@ Function MaybeDefault(optional<Function> value) {
   return value.value_or(Function{0});
 }
 
-FunctionType MaybeDefault(optional<FunctionType> value) {
-  return value.value_or(FunctionType{});
+const FunctionType& MaybeDefault(const FunctionType* value) {
+  static const FunctionType default_function_type;
+  return value ? *value : default_function_type;
 }
 
 TableType MaybeDefault(optional<TableType> value) {
@@ -281,8 +267,33 @@ ReferenceType MaybeDefault(optional<ReferenceType> value) {
   return value.value_or(ReferenceType::Externref_NoLocation());
 }
 
-Label MaybeDefault(const Label* value) {
-  return value ? *value : Label{LabelType::Block, {}, {}, 0};
+StackTypeSpan GetBrTypes(Context& context, const Label* label) {
+  return label ? context.GetBrTypes(*label) : StackTypeSpan{};
+}
+
+// Converts to stack types using context.scratch_types, so no allocation is
+// needed. The result is only valid until the next call.
+StackTypeSpan ToScratchStackTypes(Context& context,
+                                  const ValueTypeList& value_types) {
+  context.scratch_types.clear();
+  for (auto value_type : value_types) {
+    context.scratch_types.push_back(StackType{*value_type});
+  }
+  return context.scratch_types;
+}
+
+auto ToScratchStackTypes(Context& context, const FunctionType& function_type)
+    -> std::pair<StackTypeSpan, StackTypeSpan> {
+  context.scratch_types.clear();
+  for (auto value_type : function_type.param_types) {
+    context.scratch_types.push_back(StackType{*value_type});
+  }
+  for (auto value_type : function_type.result_types) {
+    context.scratch_types.push_back(StackType{*value_type});
+  }
+  StackTypeSpan types{context.scratch_types};
+  auto param_count = function_type.param_types.size();
+  return {types.subspan(0, param_count), types.subspan(param_count)};
 }
 
 optional<StackType> PeekType(Context& context, Location loc) {
@@ -338,8 +349,8 @@ bool CheckResultTypes(Context& context,
                       const FunctionType& function_type) {
   auto* label = GetFunctionLabel(context);
   assert(label != nullptr);
-  auto caller = ToStackTypeList(function_type.result_types);
-  auto callee = label->br_types();
+  auto caller = ToScratchStackTypes(context, function_type.result_types);
+  auto callee = context.GetBrTypes(*label);
 
   if (!IsMatch(context, callee, caller)) {
     context.errors->OnError(
@@ -440,12 +451,12 @@ auto PopTypedReference(Context& context, Location loc)
 }
 
 auto PopFunctionReference(Context& context, Location loc)
-    -> std::pair<optional<StackType>, std::optional<FunctionType>> {
+    -> std::pair<optional<StackType>, const FunctionType*> {
   auto [stack_type, index] = PopTypedReference(context, loc);
   if (stack_type && !stack_type->is_any() && index) {
     return {stack_type, GetFunctionType(context, *index)};
   } else {
-    return {stack_type, nullopt};
+    return {stack_type, nullptr};
   }
 }
 
@@ -497,9 +508,9 @@ bool PopAndPushTypes(Context& context,
 bool PopAndPushTypes(Context& context,
                      Location loc,
                      const FunctionType& function_type) {
-  return PopAndPushTypes(context, loc,
-                         ToStackTypeList(function_type.param_types),
-                         ToStackTypeList(function_type.result_types));
+  auto [param_types, result_types] =
+      ToScratchStackTypes(context, function_type);
+  return PopAndPushTypes(context, loc, param_types, result_types);
 }
 
 void SetUnreachable(Context& context) {
@@ -525,14 +536,12 @@ Label* GetFunctionLabel(Context& context) {
 bool PushLabel(Context& context,
                Location loc,
                LabelType label_type,
-               const FunctionType& type) {
-  auto stack_param_types = ToStackTypeList(type.param_types);
-  auto stack_result_types = ToStackTypeList(type.result_types);
-  bool valid = PopTypes(context, loc, stack_param_types);
-  context.label_stack.emplace_back(label_type, stack_param_types,
-                                   stack_result_types,
-                                   static_cast<Index>(context.type_stack.size()));
-  PushTypes(context, stack_param_types);
+               StackTypeSpan param_types,
+               StackTypeSpan result_types) {
+  bool valid = PopTypes(context, loc, param_types);
+  context.PushLabel(label_type, param_types, result_types,
+                    static_cast<Index>(context.type_stack.size()));
+  PushTypes(context, param_types);
   return valid;
 }
 
@@ -540,11 +549,25 @@ bool PushLabel(Context& context,
                Location loc,
                LabelType label_type,
                BlockType block_type) {
-  auto sig = GetBlockTypeSignature(context, block_type);
-  if (!sig) {
-    return false;
+  if (block_type.is_void()) {
+    return PushLabel(context, loc, label_type, {}, {});
+  } else if (block_type.is_value_type()) {
+    const auto& value_type = block_type.value_type();
+    if (!Validate(context, value_type)) {
+      return false;
+    }
+    const StackType result_types[] = {StackType{value_type}};
+    return PushLabel(context, loc, label_type, {}, result_types);
+  } else {
+    assert(block_type.is_index());
+    const auto* function_type = GetFunctionType(context, block_type.index());
+    if (!function_type) {
+      return false;
+    }
+    auto [param_types, result_types] =
+        ToScratchStackTypes(context, *function_type);
+    return PushLabel(context, loc, label_type, param_types, result_types);
   }
-  return PushLabel(context, loc, label_type, *sig);
 }
 
 bool CheckTypeStackEmpty(Context& context, Location loc) {
@@ -563,7 +586,7 @@ bool Catch(Context& context, Location loc) {
     context.errors->OnError(loc, "Got catch instruction without try");
     return false;
   }
-  bool valid = PopTypes(context, loc, top_label.result_types);
+  bool valid = PopTypes(context, loc, context.GetResultTypes(top_label));
   valid &= CheckTypeStackEmpty(context, loc);
   ResetTypeStackToLimit(context);
   PushTypes(context, span_exnref);
@@ -578,10 +601,10 @@ bool Else(Context& context, Location loc) {
     context.errors->OnError(loc, "Got else instruction without if");
     return false;
   }
-  bool valid = PopTypes(context, loc, top_label.result_types);
+  bool valid = PopTypes(context, loc, context.GetResultTypes(top_label));
   valid &= CheckTypeStackEmpty(context, loc);
   ResetTypeStackToLimit(context);
-  PushTypes(context, top_label.param_types);
+  PushTypes(context, context.GetParamTypes(top_label));
   top_label.label_type = LabelType::Else;
   top_label.unreachable = false;
   return valid;
@@ -595,17 +618,17 @@ bool End(Context& context, Location loc) {
   } else if (top_label.label_type == LabelType::Let) {
     context.locals.Pop();
   }
-  valid &= PopTypes(context, loc, top_label.result_types);
+  valid &= PopTypes(context, loc, context.GetResultTypes(top_label));
   valid &= CheckTypeStackEmpty(context, loc);
   ResetTypeStackToLimit(context);
-  PushTypes(context, top_label.result_types);
-  context.label_stack.pop_back();
+  PushTypes(context, context.GetResultTypes(top_label));
+  context.PopLabel();
   return valid;
 }
 
 bool Br(Context& context, Location loc, At<Index> depth) {
   const auto* label = GetLabel(context, depth);
-  bool valid = PopTypes(context, loc, MaybeDefault(label).br_types());
+  bool valid = PopTypes(context, loc, GetBrTypes(context, label));
   SetUnreachable(context);
   return AllTrue(label, valid);
 }
@@ -613,10 +636,9 @@ bool Br(Context& context, Location loc, At<Index> depth) {
 bool BrIf(Context& context, Location loc, At<Index> depth) {
   bool valid = PopType(context, loc, StackType::I32());
   const auto* label = GetLabel(context, depth);
-  auto label_ = MaybeDefault(label);
-  return AllTrue(
-      valid, label,
-      PopAndPushTypes(context, loc, label_.br_types(), label_.br_types()));
+  auto br_types = GetBrTypes(context, label);
+  return AllTrue(valid, label,
+                 PopAndPushTypes(context, loc, br_types, br_types));
 }
 
 bool BrTable(Context& context,
@@ -628,27 +650,28 @@ bool BrTable(Context& context,
     return false;
   }
 
-  StackTypeSpan br_types = default_label->br_types();
+  StackTypeSpan br_types = context.GetBrTypes(*default_label);
   valid &= CheckTypes(context, immediate->default_target.loc(), br_types);
 
   for (auto target : immediate->targets) {
     const auto* label = GetLabel(context, target);
     if (label) {
+      StackTypeSpan label_br_types = context.GetBrTypes(*label);
       if (context.features.function_references_enabled()) {
-        if (br_types.size() != label->br_types().size()) {
+        if (br_types.size() != label_br_types.size()) {
           context.errors->OnError(
               target.loc(),
               concat("br_table labels must have the same arity; expected ",
-                     br_types.size(), ", got ", label->br_types().size()));
+                     br_types.size(), ", got ", label_br_types.size()));
           valid = false;
         }
-        valid &= CheckTypes(context, target.loc(), label->br_types());
+        valid &= CheckTypes(context, target.loc(), label_br_types);
       } else {
-        if (br_types != label->br_types()) {
+        if (br_types != label_br_types) {
           context.errors->OnError(
               target.loc(),
               concat("br_table labels must have the same signature; expected ",
-                     br_types, ", got ", label->br_types()));
+                     br_types, ", got ", label_br_types));
           valid = false;
         }
       }
@@ -706,8 +729,7 @@ bool SelectT(Context& context,
     return false;
   }
   valid &= Validate(context, value_types);
-  StackTypeList stack_types = ToStackTypeList(value_types);
-  StackType type = stack_types[0];
+  StackType type{*value_types->front()};
   const StackType pop_types[] = {type, type};
   const StackType push_type[] = {type};
   return AllTrue(valid, PopAndPushTypes(context, loc, pop_types, push_type));
@@ -764,8 +786,7 @@ bool TableSet(Context& context, Location loc, At<Index> index) {
 }
 
 bool RefFunc(Context& context, Location loc, At<Index> index) {
-  if (context.declared_functions.find(index) ==
-      context.declared_functions.end()) {
+  if (!context.IsFunctionDeclared(index)) {
     context.errors->OnError(loc,
                             concat("Undeclared function reference ", index));
     return false;
@@ -778,21 +799,26 @@ bool RefFunc(Context& context, Location loc, At<Index> index) {
 }
 
 bool CheckAlignment(Context& context,
-                    const At<Instruction>& instruction,
+                    Location loc,
+                    At<Opcode> opcode,
+                    const At<MemArgImmediate>& immediate,
                     u32 max_align) {
-  if (instruction->mem_arg_immediate()->align_log2 > max_align) {
-    context.errors->OnError(instruction.loc(),
-                            concat("Invalid alignment ", instruction));
+  if (immediate->align_log2 > max_align) {
+    context.errors->OnError(
+        loc, concat("Invalid alignment ", opcode, " ", immediate));
     return false;
   }
   return true;
 }
 
-bool Load(Context& context, Location loc, const At<Instruction>& instruction) {
+bool Load(Context& context,
+          Location loc,
+          At<Opcode> opcode,
+          const At<MemArgImmediate>& immediate) {
   auto memory_type = GetMemoryType(context, 0);
   StackTypeSpan span;
   u32 max_align;
-  switch (instruction->opcode) {
+  switch (opcode) {
     case Opcode::I32Load:    span = span_i32; max_align = 2; break;
     case Opcode::I64Load:    span = span_i64; max_align = 3; break;
     case Opcode::F32Load:    span = span_f32; max_align = 2; break;
@@ -822,16 +848,19 @@ bool Load(Context& context, Location loc, const At<Instruction>& instruction) {
       WASP_UNREACHABLE();
   }
 
-  bool valid = CheckAlignment(context, instruction, max_align);
+  bool valid = CheckAlignment(context, loc, opcode, immediate, max_align);
   return AllTrue(memory_type, valid,
                  PopAndPushTypes(context, loc, span_i32, span));
 }
 
-bool Store(Context& context, Location loc, const At<Instruction>& instruction) {
+bool Store(Context& context,
+           Location loc,
+           At<Opcode> opcode,
+           const At<MemArgImmediate>& immediate) {
   auto memory_type = GetMemoryType(context, 0);
   StackTypeSpan span;
   u32 max_align;
-  switch (instruction->opcode) {
+  switch (opcode) {
     case Opcode::I32Store:   span = span_i32_i32; max_align = 2; break;
     case Opcode::I64Store:   span = span_i32_i64; max_align = 3; break;
     case Opcode::F32Store:   span = span_i32_f32; max_align = 2; break;
@@ -846,7 +875,7 @@ bool Store(Context& context, Location loc, const At<Instruction>& instruction) {
       WASP_UNREACHABLE();
   }
 
-  bool valid = CheckAlignment(context, instruction, max_align);
+  bool valid = CheckAlignment(context, loc, opcode, immediate, max_align);
   return AllTrue(memory_type, valid, PopTypes(context, loc, span));
 }
 
@@ -946,11 +975,13 @@ bool TableFill(Context& context, Location loc, At<Index> index) {
 }
 
 bool CheckAtomicAlignment(Context& context,
-                          const At<Instruction>& instruction,
+                          Location loc,
+                          At<Opcode> opcode,
+                          const At<MemArgImmediate>& immediate,
                           u32 align) {
-  if (instruction->mem_arg_immediate()->align_log2 != align) {
-    context.errors->OnError(instruction.loc(),
-                            concat("Invalid atomic alignment ", instruction));
+  if (immediate->align_log2 != align) {
+    context.errors->OnError(
+        loc, concat("Invalid atomic alignment ", opcode, " ", immediate));
     return false;
   }
   return true;
@@ -958,39 +989,42 @@ bool CheckAtomicAlignment(Context& context,
 
 bool MemoryAtomicNotify(Context& context,
                         Location loc,
-                        const At<Instruction>& instruction) {
+                        At<Opcode> opcode,
+                        const At<MemArgImmediate>& immediate) {
   const u32 align = 2;
   auto memory_type = GetMemoryType(context, 0);
-  bool valid = CheckAtomicAlignment(context, instruction, align);
+  bool valid = CheckAtomicAlignment(context, loc, opcode, immediate, align);
   return AllTrue(memory_type, valid,
                  PopAndPushTypes(context, loc, span_i32_i32, span_i32));
 }
 
 bool MemoryAtomicWait(Context& context,
                       Location loc,
-                      const At<Instruction>& instruction) {
+                      At<Opcode> opcode,
+                      const At<MemArgImmediate>& immediate) {
   auto memory_type = GetMemoryType(context, 0);
   StackTypeSpan span;
   u32 align;
-  switch (instruction->opcode) {
+  switch (opcode) {
     case Opcode::MemoryAtomicWait32: span = span_i32_i32_i64; align = 2; break;
     case Opcode::MemoryAtomicWait64: span = span_i32_i64_i64; align = 3; break;
     default:
       WASP_UNREACHABLE();
   }
 
-  bool valid = CheckAtomicAlignment(context, instruction, align);
+  bool valid = CheckAtomicAlignment(context, loc, opcode, immediate, align);
   return AllTrue(memory_type, valid,
                  PopAndPushTypes(context, loc, span, span_i32));
 }
 
 bool AtomicLoad(Context& context,
                 Location loc,
-                const At<Instruction>& instruction) {
+                At<Opcode> opcode,
+                const At<MemArgImmediate>& immediate) {
   auto memory_type = GetMemoryType(context, 0);
   StackTypeSpan span;
   u32 align;
-  switch (instruction->opcode) {
+  switch (opcode) {
     case Opcode::I32AtomicLoad:    span = span_i32; align = 2; break;
     case Opcode::I64AtomicLoad:    span = span_i64; align = 3; break;
     case Opcode::I32AtomicLoad8U:  span = span_i32; align = 0; break;
@@ -1002,18 +1036,19 @@ bool AtomicLoad(Context& context,
       WASP_UNREACHABLE();
   }
 
-  bool valid = CheckAtomicAlignment(context, instruction, align);
+  bool valid = CheckAtomicAlignment(context, loc, opcode, immediate, align);
   return AllTrue(memory_type, valid,
                  PopAndPushTypes(context, loc, span_i32, span));
 }
 
 bool AtomicStore(Context& context,
                  Location loc,
-                 const At<Instruction>& instruction) {
+                 At<Opcode> opcode,
+                 const At<MemArgImmediate>& immediate) {
   auto memory_type = GetMemoryType(context, 0);
   StackTypeSpan span;
   u32 align;
-  switch (instruction->opcode) {
+  switch (opcode) {
     case Opcode::I32AtomicStore:   span = span_i32_i32; align = 2; break;
     case Opcode::I64AtomicStore:   span = span_i32_i64; align = 3; break;
     case Opcode::I32AtomicStore8:  span = span_i32_i32; align = 0; break;
@@ -1025,17 +1060,18 @@ bool AtomicStore(Context& context,
       WASP_UNREACHABLE();
   }
 
-  bool valid = CheckAtomicAlignment(context, instruction, align);
+  bool valid = CheckAtomicAlignment(context, loc, opcode, immediate, align);
   return AllTrue(memory_type, valid, PopTypes(context, loc, span));
 }
 
 bool AtomicRmw(Context& context,
                Location loc,
-               const At<Instruction>& instruction) {
+               At<Opcode> opcode,
+               const At<MemArgImmediate>& immediate) {
   auto memory_type = GetMemoryType(context, 0);
   StackTypeSpan params, results;
   u32 align;
-  switch (instruction->opcode) {
+  switch (opcode) {
     case Opcode::I32AtomicRmwAdd:
     case Opcode::I32AtomicRmwSub:
     case Opcode::I32AtomicRmwAnd:
@@ -1109,7 +1145,7 @@ bool AtomicRmw(Context& context,
       WASP_UNREACHABLE();
   }
 
-  bool valid = CheckAtomicAlignment(context, instruction, align);
+  bool valid = CheckAtomicAlignment(context, loc, opcode, immediate, align);
   return AllTrue(memory_type, valid,
                  PopAndPushTypes(context, loc, params, results));
 }
@@ -1119,8 +1155,9 @@ bool ReturnCall(Context& context, Location loc, At<Index> function_index) {
   auto function_type =
       GetFunctionType(context, MaybeDefault(function).type_index);
   bool valid = CheckResultTypes(context, loc, MaybeDefault(function_type));
-  valid &= PopTypes(context,
-      loc, ToStackTypeList(MaybeDefault(function_type).param_types));
+  valid &= PopTypes(context, loc,
+                    ToScratchStackTypes(
+                        context, MaybeDefault(function_type).param_types));
   SetUnreachable(context);
   return AllTrue(function, function_type, valid);
 }
@@ -1132,8 +1169,9 @@ bool ReturnCallIndirect(Context& context,
   auto function_type = GetFunctionType(context, immediate->index);
   bool valid = CheckResultTypes(context, loc, MaybeDefault(function_type));
   valid &= PopType(context, loc, StackType::I32());
-  valid &= PopTypes(context,
-      loc, ToStackTypeList(MaybeDefault(function_type).param_types));
+  valid &= PopTypes(context, loc,
+                    ToScratchStackTypes(
+                        context, MaybeDefault(function_type).param_types));
   SetUnreachable(context);
   return AllTrue(table_type, function_type, valid);
 }
@@ -1142,8 +1180,9 @@ bool Throw(Context& context, Location loc, At<Index> index) {
   auto event_type = GetEventType(context, index);
   auto function_type =
       GetFunctionType(context, MaybeDefault(event_type).type_index);
-  bool valid = PopTypes(context,
-      loc, ToStackTypeList(MaybeDefault(function_type).param_types));
+  bool valid = PopTypes(context, loc,
+                        ToScratchStackTypes(
+                            context, MaybeDefault(function_type).param_types));
   SetUnreachable(context);
   return AllTrue(event_type, function_type, valid);
 }
@@ -1162,8 +1201,10 @@ bool BrOnExn(Context& context,
       GetFunctionType(context, MaybeDefault(event_type).type_index);
   auto* label = GetLabel(context, immediate->target);
   bool valid =
-      IsMatch(context, ToStackTypeList(MaybeDefault(function_type).param_types),
-              MaybeDefault(label).br_types());
+      IsMatch(context,
+              ToScratchStackTypes(context,
+                                  MaybeDefault(function_type).param_types),
+              GetBrTypes(context, label));
   valid &= PopAndPushTypes(context, loc, span_exnref, span_exnref);
   return AllTrue(event_type, function_type, label, valid);
 }
@@ -1174,8 +1215,8 @@ bool BrOnNull(Context& context, Location loc, const At<Index>& depth) {
   auto type = MaybeDefault(type_opt);
 
   const auto* label = GetLabel(context, depth);
-  auto label_ = MaybeDefault(label);
-  valid &= PopAndPushTypes(context, loc, label_.br_types(), label_.br_types());
+  auto br_types = GetBrTypes(context, label);
+  valid &= PopAndPushTypes(context, loc, br_types, br_types);
 
   if (IsNullableType(type)) {
     PushType(context, AsNonNullableType(type));
@@ -1224,7 +1265,8 @@ bool ReturnCallRef(Context& context, Location loc) {
 
   bool valid = CheckResultTypes(context, loc, MaybeDefault(function_type));
   valid &= PopTypes(context, loc,
-                    ToStackTypeList(MaybeDefault(function_type).param_types));
+                    ToScratchStackTypes(
+                        context, MaybeDefault(function_type).param_types));
   SetUnreachable(context);
   return AllTrue(function_type, valid);
 }
@@ -1302,10 +1344,11 @@ bool Let(Context& context, Location loc, const At<LetImmediate>& immediate) {
 
 bool SimdLane(Context& context,
               Location loc,
-              const At<Instruction>& instruction) {
+              At<Opcode> opcode,
+              At<SimdLaneImmediate> lane) {
   StackTypeSpan params, results;
   u8 num_lanes;
-  switch (instruction->opcode) {
+  switch (opcode) {
     case Opcode::I8X16ExtractLaneS:
     case Opcode::I8X16ExtractLaneU: num_lanes = 16; goto extract_i32;
     case Opcode::I16X8ExtractLaneS:
@@ -1359,10 +1402,8 @@ bool SimdLane(Context& context,
   }
 
   bool valid = true;
-  if (instruction->simd_lane_immediate() >= num_lanes) {
-    context.errors->OnError(
-        instruction.loc(),
-        concat("Invalid lane immediate ", instruction->simd_lane_immediate()));
+  if (lane >= num_lanes) {
+    context.errors->OnError(loc, concat("Invalid lane immediate ", lane));
     valid = false;
   }
   return AllTrue(valid, PopAndPushTypes(context, loc, params, results));
@@ -1475,7 +1516,7 @@ bool BrOnCast(Context& context, Location loc, const At<Index>& immediate) {
       StackType{ValueType{ReferenceType{RefType{rtt_opt->type, Null::Yes}}}}};
 
   auto* label = GetLabel(context, immediate);
-  auto label_types = MaybeDefault(label).br_types();
+  auto label_types = GetBrTypes(context, label);
   if (!IsMatch(context, sub_type, label_types)) {
     context.errors->OnError(
         loc, concat("Label type is ", label_types, ", got ", sub_type));
@@ -1748,27 +1789,33 @@ bool Validate(Context& context,
 }
 
 bool Validate(Context& context,
-              const At<LocalsList>& value,
+              const LocalsList& value,
               RequireDefaultable require_defaultable) {
   bool valid = true;
-  for (auto&& locals : *value) {
+  for (auto&& locals : value) {
     valid &= Validate(context, locals, require_defaultable);
   }
   return valid;
 }
 
-bool Validate(Context& context, const At<Instruction>& value) {
-  ErrorsContextGuard guard{*context.errors, value.loc(), "instruction"};
+namespace {
+
+// Validates an Instruction or a PackedInstruction. Both have the same immediate
+// accessors, so a packed instruction is validated without first being decoded
+// into an Instruction.
+template <typename T>
+bool ValidateInstruction(Context& context,
+                         Location loc,
+                         At<Opcode> opcode,
+                         const T& value) {
+  ErrorsContextGuard guard{*context.errors, loc, "instruction"};
   if (context.label_stack.empty()) {
-    context.errors->OnError(value.loc(),
-                            "Unexpected instruction after function end");
+    context.errors->OnError(loc, "Unexpected instruction after function end");
     return false;
   }
 
-  Location loc = value.loc();
-
   StackTypeSpan params, results;
-  switch (value->opcode) {
+  switch (opcode) {
     case Opcode::Unreachable:
       SetUnreachable(context);
       return true;
@@ -1778,16 +1825,16 @@ bool Validate(Context& context, const At<Instruction>& value) {
 
     case Opcode::Block:
       return PushLabel(context, loc, LabelType::Block,
-                       value->block_type_immediate());
+                       value.block_type_immediate());
 
     case Opcode::Loop:
       return PushLabel(context, loc, LabelType::Loop,
-                       value->block_type_immediate());
+                       value.block_type_immediate());
 
     case Opcode::If: {
       bool valid = PopType(context, loc, StackType::I32());
       valid &=
-          PushLabel(context, loc, LabelType::If, value->block_type_immediate());
+          PushLabel(context, loc, LabelType::If, value.block_type_immediate());
       return valid;
     }
 
@@ -1799,37 +1846,37 @@ bool Validate(Context& context, const At<Instruction>& value) {
 
     case Opcode::Try:
       return PushLabel(context, loc, LabelType::Try,
-                       value->block_type_immediate());
+                       value.block_type_immediate());
 
     case Opcode::Catch:
       return Catch(context, loc);
 
     case Opcode::Throw:
-      return Throw(context, loc, value->index_immediate());
+      return Throw(context, loc, value.index_immediate());
 
     case Opcode::Rethrow:
       return Rethrow(context, loc);
 
     case Opcode::BrOnExn:
-      return BrOnExn(context, loc, value->br_on_exn_immediate());
+      return BrOnExn(context, loc, value.br_on_exn_immediate());
 
     case Opcode::Br:
-      return Br(context, loc, value->index_immediate());
+      return Br(context, loc, value.index_immediate());
 
     case Opcode::BrIf:
-      return BrIf(context, loc, value->index_immediate());
+      return BrIf(context, loc, value.index_immediate());
 
     case Opcode::BrTable:
-      return BrTable(context, loc, value->br_table_immediate());
+      return BrTable(context, loc, value.br_table_immediate());
 
     case Opcode::Return:
       return Br(context, loc, static_cast<Index>(context.label_stack.size() - 1));
 
     case Opcode::Call:
-      return Call(context, loc, value->index_immediate());
+      return Call(context, loc, value.index_immediate());
 
     case Opcode::CallIndirect:
-      return CallIndirect(context, loc, value->call_indirect_immediate());
+      return CallIndirect(context, loc, value.call_indirect_immediate());
 
     case Opcode::Drop:
       return DropTypes(context, loc, 1);
@@ -1838,31 +1885,31 @@ bool Validate(Context& context, const At<Instruction>& value) {
       return Select(context, loc);
 
     case Opcode::SelectT:
-      return SelectT(context, loc, value->select_immediate());
+      return SelectT(context, loc, value.select_immediate());
 
     case Opcode::LocalGet:
-      return LocalGet(context, value->index_immediate());
+      return LocalGet(context, value.index_immediate());
 
     case Opcode::LocalSet:
-      return LocalSet(context, loc, value->index_immediate());
+      return LocalSet(context, loc, value.index_immediate());
 
     case Opcode::LocalTee:
-      return LocalTee(context, loc, value->index_immediate());
+      return LocalTee(context, loc, value.index_immediate());
 
     case Opcode::GlobalGet:
-      return GlobalGet(context, value->index_immediate());
+      return GlobalGet(context, value.index_immediate());
 
     case Opcode::GlobalSet:
-      return GlobalSet(context, loc, value->index_immediate());
+      return GlobalSet(context, loc, value.index_immediate());
 
     case Opcode::TableGet:
-      return TableGet(context, loc, value->index_immediate());
+      return TableGet(context, loc, value.index_immediate());
 
     case Opcode::TableSet:
-      return TableSet(context, loc, value->index_immediate());
+      return TableSet(context, loc, value.index_immediate());
 
     case Opcode::RefNull:
-      PushType(context, ToStackType(value->heap_type_immediate()));
+      PushType(context, ToStackType(value.heap_type_immediate()));
       return true;
 
     case Opcode::RefIsNull: {
@@ -1872,10 +1919,10 @@ bool Validate(Context& context, const At<Instruction>& value) {
     }
 
     case Opcode::RefFunc:
-      return RefFunc(context, loc, value->index_immediate());
+      return RefFunc(context, loc, value.index_immediate());
 
     case Opcode::BrOnNull:
-      return BrOnNull(context, loc, value->index_immediate());
+      return BrOnNull(context, loc, value.index_immediate());
 
     case Opcode::RefAsNonNull:
       return RefAsNonNull(context, loc);
@@ -1887,10 +1934,10 @@ bool Validate(Context& context, const At<Instruction>& value) {
       return ReturnCallRef(context, loc);
 
     case Opcode::FuncBind:
-      return FuncBind(context, loc, value->index_immediate());
+      return FuncBind(context, loc, value.index_immediate());
 
     case Opcode::Let:
-      return Let(context, loc, value->let_immediate());
+      return Let(context, loc, value.let_immediate());
 
     case Opcode::I32Load:
     case Opcode::I64Load:
@@ -1917,7 +1964,7 @@ bool Validate(Context& context, const At<Instruction>& value) {
     case Opcode::I32X4Load16X4U:
     case Opcode::I64X2Load32X2S:
     case Opcode::I64X2Load32X2U:
-      return Load(context, loc, value);
+      return Load(context, loc, opcode, value.mem_arg_immediate());
 
     case Opcode::I32Store:
     case Opcode::I64Store:
@@ -1929,7 +1976,7 @@ bool Validate(Context& context, const At<Instruction>& value) {
     case Opcode::I64Store16:
     case Opcode::I64Store32:
     case Opcode::V128Store:
-      return Store(context, loc, value);
+      return Store(context, loc, opcode, value.mem_arg_immediate());
 
     case Opcode::MemorySize:
       return MemorySize(context);
@@ -2159,40 +2206,40 @@ bool Validate(Context& context, const At<Instruction>& value) {
       break;
 
     case Opcode::ReturnCall:
-      return ReturnCall(context, loc, value->index_immediate());
+      return ReturnCall(context, loc, value.index_immediate());
 
     case Opcode::ReturnCallIndirect:
-      return ReturnCallIndirect(context, loc, value->call_indirect_immediate());
+      return ReturnCallIndirect(context, loc, value.call_indirect_immediate());
 
     case Opcode::MemoryInit:
-      return MemoryInit(context, loc, value->init_immediate());
+      return MemoryInit(context, loc, value.init_immediate());
 
     case Opcode::DataDrop:
-      return DataDrop(context, value->index_immediate());
+      return DataDrop(context, value.index_immediate());
 
     case Opcode::MemoryCopy:
-      return MemoryCopy(context, loc, value->copy_immediate());
+      return MemoryCopy(context, loc, value.copy_immediate());
 
     case Opcode::MemoryFill:
       return MemoryFill(context, loc);
 
     case Opcode::TableInit:
-      return TableInit(context, loc, value->init_immediate());
+      return TableInit(context, loc, value.init_immediate());
 
     case Opcode::ElemDrop:
-      return ElemDrop(context, value->index_immediate());
+      return ElemDrop(context, value.index_immediate());
 
     case Opcode::TableCopy:
-      return TableCopy(context, loc, value->copy_immediate());
+      return TableCopy(context, loc, value.copy_immediate());
 
     case Opcode::TableGrow:
-      return TableGrow(context, loc, value->index_immediate());
+      return TableGrow(context, loc, value.index_immediate());
 
     case Opcode::TableSize:
-      return TableSize(context, value->index_immediate());
+      return TableSize(context, value.index_immediate());
 
     case Opcode::TableFill:
-      return TableFill(context, loc, value->index_immediate());
+      return TableFill(context, loc, value.index_immediate());
 
     case Opcode::V128Const:
       PushType(context, StackType::V128());
@@ -2331,7 +2378,7 @@ bool Validate(Context& context, const At<Instruction>& value) {
       break;
 
     case Opcode::V8X16Shuffle:
-      return SimdShuffle(context, loc, value->shuffle_immediate());
+      return SimdShuffle(context, loc, value.shuffle_immediate());
 
     case Opcode::I8X16Splat:
     case Opcode::I16X8Splat:
@@ -2365,7 +2412,7 @@ bool Validate(Context& context, const At<Instruction>& value) {
     case Opcode::I64X2ReplaceLane:
     case Opcode::F32X4ReplaceLane:
     case Opcode::F64X2ReplaceLane:
-      return SimdLane(context, loc, value);
+      return SimdLane(context, loc, opcode, value.simd_lane_immediate());
 
     case Opcode::I8X16AnyTrue:
     case Opcode::I8X16AllTrue:
@@ -2392,11 +2439,12 @@ bool Validate(Context& context, const At<Instruction>& value) {
       break;
 
     case Opcode::MemoryAtomicNotify:
-      return MemoryAtomicNotify(context, loc, value);
+      return MemoryAtomicNotify(context, loc, opcode,
+                                value.mem_arg_immediate());
 
     case Opcode::MemoryAtomicWait32:
     case Opcode::MemoryAtomicWait64:
-      return MemoryAtomicWait(context, loc, value);
+      return MemoryAtomicWait(context, loc, opcode, value.mem_arg_immediate());
 
     case Opcode::I32AtomicLoad:
     case Opcode::I64AtomicLoad:
@@ -2405,7 +2453,7 @@ bool Validate(Context& context, const At<Instruction>& value) {
     case Opcode::I64AtomicLoad8U:
     case Opcode::I64AtomicLoad16U:
     case Opcode::I64AtomicLoad32U:
-      return AtomicLoad(context, loc, value);
+      return AtomicLoad(context, loc, opcode, value.mem_arg_immediate());
 
     case Opcode::I32AtomicStore:
     case Opcode::I64AtomicStore:
@@ -2414,7 +2462,7 @@ bool Validate(Context& context, const At<Instruction>& value) {
     case Opcode::I64AtomicStore8:
     case Opcode::I64AtomicStore16:
     case Opcode::I64AtomicStore32:
-      return AtomicStore(context, loc, value);
+      return AtomicStore(context, loc, opcode, value.mem_arg_immediate());
 
     case Opcode::I32AtomicRmwAdd:
     case Opcode::I32AtomicRmw8AddU:
@@ -2465,7 +2513,7 @@ bool Validate(Context& context, const At<Instruction>& value) {
     case Opcode::I64AtomicRmw8CmpxchgU:
     case Opcode::I64AtomicRmw16CmpxchgU:
     case Opcode::I64AtomicRmw32CmpxchgU:
-      return AtomicRmw(context, loc, value);
+      return AtomicRmw(context, loc, opcode, value.mem_arg_immediate());
 
     case Opcode:: RefEq:
       params = span_eqref_eqref, results = span_i32;
@@ -2481,57 +2529,76 @@ bool Validate(Context& context, const At<Instruction>& value) {
       break;
 
     case Opcode:: RttCanon:
-      return RttCanon(context, loc, value->heap_type_immediate());
+      return RttCanon(context, loc, value.heap_type_immediate());
 
     case Opcode:: RttSub:
-      return RttSub(context, loc, value->heap_type_immediate());
+      return RttSub(context, loc, value.heap_type_immediate());
 
     case Opcode:: RefTest:
-      return RefTest(context, loc, value->heap_type_2_immediate());
+      return RefTest(context, loc, value.heap_type_2_immediate());
 
     case Opcode:: RefCast:
-      return RefCast(context, loc, value->heap_type_2_immediate());
+      return RefCast(context, loc, value.heap_type_2_immediate());
 
     case Opcode:: BrOnCast:
-      return BrOnCast(context, loc, value->index_immediate());
+      return BrOnCast(context, loc, value.index_immediate());
 
     case Opcode:: StructNewWithRtt:
-      return StructNewWithRtt(context, loc, value->index_immediate());
+      return StructNewWithRtt(context, loc, value.index_immediate());
 
     case Opcode:: StructNewDefaultWithRtt:
-      return StructNewDefaultWithRtt(context, loc, value->index_immediate());
+      return StructNewDefaultWithRtt(context, loc, value.index_immediate());
 
     case Opcode:: StructGet:
-      return StructGet(context, loc, value->struct_field_immediate());
+      return StructGet(context, loc, value.struct_field_immediate());
 
     case Opcode:: StructGetS:
     case Opcode:: StructGetU:
-      return StructGetPacked(context, loc, value->struct_field_immediate());
+      return StructGetPacked(context, loc, value.struct_field_immediate());
 
     case Opcode:: StructSet:
-      return StructSet(context, loc, value->struct_field_immediate());
+      return StructSet(context, loc, value.struct_field_immediate());
 
     case Opcode:: ArrayNewWithRtt:
-      return ArrayNewWithRtt(context, loc, value->index_immediate());
+      return ArrayNewWithRtt(context, loc, value.index_immediate());
 
     case Opcode:: ArrayNewDefaultWithRtt:
-      return ArrayNewDefaultWithRtt(context, loc, value->index_immediate());
+      return ArrayNewDefaultWithRtt(context, loc, value.index_immediate());
 
     case Opcode:: ArrayGet:
-      return ArrayGet(context, loc, value->index_immediate());
+      return ArrayGet(context, loc, value.index_immediate());
 
     case Opcode:: ArrayGetS:
     case Opcode:: ArrayGetU:
-      return ArrayGetPacked(context, loc, value->index_immediate());
+      return ArrayGetPacked(context, loc, value.index_immediate());
 
     case Opcode:: ArraySet:
-      return ArraySet(context, loc, value->index_immediate());
+      return ArraySet(context, loc, value.index_immediate());
 
     case Opcode:: ArrayLen:
-      return ArrayLen(context, loc, value->index_immediate());
+      return ArrayLen(context, loc, value.index_immediate());
   }
 
   return PopAndPushTypes(context, loc, params, results);
 }
 
+}  // namespace
+
+bool Validate(Context& context, const At<Instruction>& value) {
+  return ValidateInstruction(context, value.loc(), value->opcode, *value);
+}
+
+bool Validate(Context& context, const PackedInstruction& value) {
+  return ValidateInstruction(context, value.loc(), value.opcode(), value);
+}
+
+bool Validate(Context& context, const PackedInstructionStream& value) {
+  for (auto instr : value) {
+    if (!Validate(context, instr)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 }  // namespace wasp::valid
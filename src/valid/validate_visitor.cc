@@ -16,13 +16,51 @@
 
 #include "wasp/valid/validate_visitor.h"
 
+#include <atomic>
 #include <cassert>
+#include <memory>
+#include <vector>
+
+#include "wasp/base/errors_nop.h"
+#include "wasp/base/recording_errors.h"
+#include "wasp/base/thread_pool.h"
+#include "wasp/binary/lazy_module.h"
+#include "wasp/binary/read.h"
 
 namespace wasp::valid {
 
+namespace {
+
+// Bodies are handed out to the workers in chunks, to amortize the cost of
+// synchronizing between them.
+constexpr size_t kFunctionsPerChunk = 16;
+
+struct CodeResult {
+  RecordingErrors errors;
+  bool failed = false;
+  // True if the body ended with unclosed blocks. When read sequentially, they
+  // are still open when the next body is read.
+  bool unclosed_blocks = false;
+};
+
+}  // namespace
+
 ValidateVisitor::ValidateVisitor(Features features, Errors& errors)
     : context{features, errors}, features{features}, errors{errors} {}
 
+ValidateVisitor::ValidateVisitor(Features features,
+                                 Errors& errors,
+                                 ThreadPool* pool)
+    : context{features, errors},
+      features{features},
+      errors{errors},
+      pool{pool} {}
+
+auto ValidateVisitor::BeginModule(binary::LazyModule& module) -> Result {
+  binary_context = &module.context;
+  return Result::Ok;
+}
+
 auto ValidateVisitor::BeginTypeSection(binary::LazyTypeSection sec) -> Result {
   return FailUnless(valid::BeginTypeSection(context, sec.count.value_or(0)));
 }
@@ -53,6 +91,11 @@ auto ValidateVisitor::OnGlobal(const At<binary::Global>& global) -> Result {
   return FailUnless(Validate(context, global));
 }
 
+auto ValidateVisitor::BeginExportSection(binary::LazyExportSection sec)
+    -> Result {
+  return FailUnless(valid::BeginExportSection(context, sec.count.value_or(0)));
+}
+
 auto ValidateVisitor::OnExport(const At<binary::Export>& export_) -> Result {
   return FailUnless(Validate(context, export_));
 }
@@ -71,6 +114,14 @@ auto ValidateVisitor::OnDataCount(const At<binary::DataCount>& data_count)
   return FailUnless(Validate(context, data_count));
 }
 
+auto ValidateVisitor::BeginCodeSection(binary::LazyCodeSection sec)
+    -> Result {
+  if (pool == nullptr || pool->size() <= 1 || binary_context == nullptr) {
+    return Result::Ok;
+  }
+  return ValidateCodeSectionParallel(sec);
+}
+
 auto ValidateVisitor::BeginCode(const At<binary::Code>& code) -> Result {
   return FailUnless(valid::BeginCode(context, code.loc()) &&
                     Validate(context, code->locals, RequireDefaultable::Yes));
@@ -81,10 +132,98 @@ auto ValidateVisitor::OnInstruction(const At<binary::Instruction>& instruction)
   return FailUnless(Validate(context, instruction));
 }
 
+auto ValidateVisitor::OnInstructions(
+    span<const At<binary::Instruction>> instructions) -> Result {
+  for (const auto& instruction : instructions) {
+    if (!Validate(context, instruction)) {
+      return Result::Fail;
+    }
+  }
+  return Result::Ok;
+}
+
 auto ValidateVisitor::OnData(const At<binary::DataSegment>& segment) -> Result {
   return FailUnless(Validate(context, segment));
 }
 
+// Returns Result::Skip if the bodies were validated, or Result::Ok if the
+// section should be validated sequentially instead. Nothing is reported in that
+// case, so the sequential pass produces the same errors as it otherwise would.
+auto ValidateVisitor::ValidateCodeSectionParallel(binary::LazyCodeSection sec)
+    -> Result {
+  // Read the code entries up front. If the section is malformed, its read
+  // errors are reported in order by the sequential pass.
+  ErrorsNop errors_nop;
+  binary::Context read_context{binary_context->features, errors_nop};
+  std::vector<At<binary::Code>> codes;
+  SpanU8 data = sec.sequence.data();
+  while (!data.empty()) {
+    auto code = binary::Read<binary::Code>(&data, read_context);
+    if (!code) {
+      return Result::Ok;
+    }
+    codes.push_back(std::move(*code));
+  }
+  if (!sec.count || codes.size() != sec.count->value()) {
+    return Result::Ok;
+  }
+
+  const size_t count = codes.size();
+  const Index first_code = context.code_count;
+  const bool track_context = errors.track_context();
+
+  std::vector<CodeResult> results(count);
+  // The sequential pass stops at the first body that fails, so the bodies
+  // after it don't need to be validated.
+  std::atomic<size_t> stop_index{count};
+  // Each worker validates with its own copy of the module-level context,
+  // created on first use.
+  std::vector<std::unique_ptr<ValidateVisitor>> workers(pool->size());
+
+  auto validate_range = [&](unsigned worker_index, size_t begin, size_t end) {
+    auto& worker = workers[worker_index];
+    if (!worker) {
+      worker = std::make_unique<ValidateVisitor>(features, errors);
+      worker->context = Context{context, errors};
+    }
+    for (size_t i = begin; i < end && i <= stop_index; ++i) {
+      auto& result = results[i];
+      result.errors = RecordingErrors{track_context};
+      worker->context.errors = &result.errors;
+      worker->context.code_count = first_code + static_cast<Index>(i);
+
+      binary::Context code_context{binary_context->features, result.errors};
+      code_context.declared_data_count = binary_context->declared_data_count;
+      result.failed = binary::visit::VisitCode(codes[i], code_context,
+                                               *worker) == Result::Fail;
+      result.unclosed_blocks = !code_context.open_blocks.empty();
+
+      if (result.failed || result.unclosed_blocks) {
+        size_t stop = stop_index;
+        while (i < stop && !stop_index.compare_exchange_weak(stop, i)) {
+        }
+      }
+    }
+  };
+  pool->ParallelFor(count, kFunctionsPerChunk, validate_range);
+
+  // Unclosed blocks change how the following body is read, so that can only be
+  // reproduced sequentially. It doesn't matter for the last body.
+  const size_t stop = stop_index;
+  if (stop < count && !results[stop].failed && stop + 1 < count) {
+    return Result::Ok;
+  }
+
+  for (size_t i = 0; i < count && i <= stop; ++i) {
+    results[i].errors.Replay(errors);
+  }
+  if (stop < count && results[stop].failed) {
+    return Result::Fail;
+  }
+  context.code_count += static_cast<Index>(count);
+  return Result::Skip;
+}
+
 auto ValidateVisitor::FailUnless(bool b) -> Result {
   return b ? Result::Ok : Result::Fail;
 }
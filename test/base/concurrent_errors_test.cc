@@ -0,0 +1,140 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/base/concurrent_errors.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "test/test_utils.h"
+#include "wasp/base/thread_pool.h"
+
+using namespace ::wasp;
+using namespace ::wasp::test;
+
+TEST(ConcurrentErrorsTest, Basic) {
+  const SpanU8 data = "abcdef"_su8;
+  ConcurrentErrors errors;
+  EXPECT_FALSE(errors.HasError());
+
+  errors.PushContext(data.subspan(0, 4), "outer");
+  errors.OnError(data.subspan(3, 1), "second");
+  errors.PopContext();
+  errors.OnError(data.subspan(1, 1), "first");
+  EXPECT_TRUE(errors.HasError());
+
+  auto entries = errors.GetEntries();
+  ASSERT_EQ(2u, entries.size());
+  EXPECT_EQ("first", entries[0].error.message);
+  EXPECT_TRUE(entries[0].context.empty());
+  EXPECT_EQ("second", entries[1].error.message);
+  ASSERT_EQ(1u, entries[1].context.size());
+  EXPECT_EQ("outer", entries[1].context[0].message);
+
+  TestErrors test_errors;
+  errors.Replay(test_errors);
+  ExpectErrors({{Error{data.subspan(1, 1), "first"}},
+                {Error{data.subspan(0, 4), "outer"},
+                 Error{data.subspan(3, 1), "second"}}},
+               test_errors);
+
+  errors.Clear();
+  EXPECT_FALSE(errors.HasError());
+  EXPECT_TRUE(errors.GetEntries().empty());
+}
+
+TEST(ConcurrentErrorsTest, NoContext) {
+  const SpanU8 data = "abc"_su8;
+  ConcurrentErrors errors{false};
+  errors.PushContext(data, "ignored");
+  errors.OnError(data, "error");
+  errors.PopContext();
+
+  auto entries = errors.GetEntries();
+  ASSERT_EQ(1u, entries.size());
+  EXPECT_TRUE(entries[0].context.empty());
+}
+
+TEST(ConcurrentErrorsTest, SeparateBuffers) {
+  std::vector<u8> first(4), second(4);
+  const SpanU8 data1{first}, data2{second};
+
+  // The order between the buffers doesn't depend on the reporting order.
+  ConcurrentErrors errors1, errors2;
+  errors1.OnError(data1.subspan(0, 2), "a");
+  errors1.OnError(data2.subspan(0, 2), "b");
+  errors1.OnError(data1.subspan(0, 1), "c");
+  errors2.OnError(data1.subspan(0, 1), "c");
+  errors2.OnError(data2.subspan(0, 2), "b");
+  errors2.OnError(data1.subspan(0, 2), "a");
+
+  auto entries1 = errors1.GetEntries();
+  auto entries2 = errors2.GetEntries();
+  ASSERT_EQ(3u, entries1.size());
+  ASSERT_EQ(3u, entries2.size());
+  for (size_t i = 0; i < entries1.size(); ++i) {
+    EXPECT_EQ(entries1[i].error.message, entries2[i].error.message) << i;
+  }
+
+  // Errors at the same start are ordered by size.
+  auto pos = [&](string_view message) {
+    for (size_t i = 0; i < entries1.size(); ++i) {
+      if (entries1[i].error.message == message) {
+        return i;
+      }
+    }
+    return entries1.size();
+  };
+  EXPECT_LT(pos("c"), pos("a"));
+}
+
+TEST(ConcurrentErrorsTest, ManyThreads) {
+  constexpr int kTasks = 64;
+  constexpr int kErrorsPerTask = 16;
+  std::vector<u8> buffer(kTasks * kErrorsPerTask);
+  const SpanU8 data{buffer};
+
+  ConcurrentErrors errors;
+  {
+    ThreadPool pool{4};
+    // Report in reverse order, interleaving the threads' contexts.
+    for (int task = kTasks - 1; task >= 0; --task) {
+      pool.Enqueue([&, task]() {
+        auto task_data = data.subspan(task * kErrorsPerTask, kErrorsPerTask);
+        errors.PushContext(task_data, "task " + std::to_string(task));
+        for (int i = kErrorsPerTask - 1; i >= 0; --i) {
+          errors.OnError(task_data.subspan(i, 1), std::to_string(i));
+        }
+        errors.PopContext();
+      });
+    }
+  }
+
+  EXPECT_TRUE(errors.HasError());
+  auto entries = errors.GetEntries();
+  ASSERT_EQ(size_t{kTasks * kErrorsPerTask}, entries.size());
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const auto& entry = entries[i];
+    EXPECT_EQ(data.subspan(i, 1), entry.error.loc) << i;
+    EXPECT_EQ(std::to_string(i % kErrorsPerTask), entry.error.message) << i;
+    ASSERT_EQ(1u, entry.context.size()) << i;
+    EXPECT_EQ("task " + std::to_string(i / kErrorsPerTask),
+              entry.context[0].message)
+        << i;
+  }
+}
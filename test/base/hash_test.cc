@@ -91,3 +91,12 @@ TEST(HashTest, UserDefined) {
   EXPECT_EQ(2, map[(S{0, 0})]);
   EXPECT_EQ(1, map[(S{1, 1})]);
 }
+
+TEST(HashTest, HashBytes) {
+  EXPECT_EQ((Hash128{0, 0}), HashBytes(""_su8));
+  EXPECT_EQ((Hash128{0xcbd8a7b341bd9b02ull, 0x5b1e906a48ae1d19ull}),
+            HashBytes("hello"_su8));
+  EXPECT_EQ((Hash128{0xe34bbc7bbc071b6cull, 0x7a433ca9c49a9347ull}),
+            HashBytes("The quick brown fox jumps over the lazy dog"_su8));
+  EXPECT_NE(HashBytes("hello"_su8), HashBytes("hello"_su8, 1));
+}
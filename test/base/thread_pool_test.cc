@@ -0,0 +1,119 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/base/thread_pool.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "wasp/base/at.h"
+
+using namespace ::wasp;
+
+TEST(ThreadPoolTest, RunsAllTasks) {
+  std::atomic<int> sum{0};
+  {
+    ThreadPool pool{3};
+    EXPECT_EQ(3u, pool.size());
+    for (int i = 1; i <= 100; ++i) {
+      pool.Enqueue([&sum, i]() { sum += i; });
+    }
+  }
+  // The destructor finishes all queued tasks.
+  EXPECT_EQ(5050, sum);
+}
+
+TEST(ThreadPoolTest, LocationBase) {
+  const u8 data[4] = {};
+  const u8* const default_base = LocationBase::Get();
+  std::atomic<int> count{0};
+  {
+    ThreadPool pool{2};
+    {
+      LocationBase location_base{data};
+      EXPECT_EQ(data, LocationBase::Get());
+      for (int i = 0; i < 10; ++i) {
+        pool.Enqueue([&]() {
+          if (LocationBase::Get() == data) {
+            ++count;
+          }
+        });
+      }
+    }
+    EXPECT_EQ(default_base, LocationBase::Get());
+  }
+  // Every task ran with the enqueuing thread's base.
+  EXPECT_EQ(10, count);
+}
+
+TEST(ThreadPoolTest, DefaultThreadCount) {
+  ThreadPool pool;
+  EXPECT_EQ(ThreadPool::DefaultThreadCount(), pool.size());
+  EXPECT_LE(1u, pool.size());
+}
+
+TEST(ThreadPoolTest, ParallelFor) {
+  ThreadPool pool{3};
+  std::vector<int> visited(100);
+  std::vector<size_t> ranges;
+  std::mutex mutex;
+  pool.ParallelFor(visited.size(), 16,
+                   [&](unsigned worker, size_t begin, size_t end) {
+                     EXPECT_LT(worker, 3u);
+                     for (size_t i = begin; i < end; ++i) {
+                       ++visited[i];
+                     }
+                     std::lock_guard<std::mutex> lock{mutex};
+                     ranges.push_back(end - begin);
+                   });
+  EXPECT_EQ(std::vector<int>(100, 1), visited);
+  // Six ranges of 16, and one of 4.
+  EXPECT_EQ(7u, ranges.size());
+}
+
+TEST(ThreadPoolTest, ParallelFor_WorkerCount) {
+  ThreadPool pool{4};
+  std::atomic<unsigned> max_worker{0};
+  pool.ParallelFor(2, 1, [&](unsigned worker, size_t, size_t) {
+    unsigned max = max_worker;
+    while (worker > max && !max_worker.compare_exchange_weak(max, worker)) {
+    }
+  });
+  // Only one worker per chunk is used.
+  EXPECT_GT(2u, max_worker);
+}
+
+TEST(ThreadPoolTest, ParallelFor_CallerTask) {
+  ThreadPool pool{2};
+  std::atomic<int> sum{0};
+  bool caller_ran = false;
+  pool.ParallelFor(
+      10, 1,
+      [&](unsigned, size_t begin, size_t) { sum += static_cast<int>(begin); },
+      [&]() { caller_ran = true; });
+  EXPECT_TRUE(caller_ran);
+  EXPECT_EQ(45, sum);
+}
+
+TEST(ThreadPoolTest, ParallelFor_Empty) {
+  ThreadPool pool{2};
+  bool called = false;
+  pool.ParallelFor(0, 4, [&](unsigned, size_t, size_t) { called = true; });
+  EXPECT_FALSE(called);
+}
@@ -16,7 +16,11 @@
 
 #include "wasp/base/utf8.h"
 
+#include <algorithm>
 #include <cassert>
+#include <iterator>
+#include <random>
+#include <string>
 
 #include "gtest/gtest.h"
 
@@ -24,6 +28,39 @@ using namespace ::wasp;
 
 namespace {
 
+// Checks `s` with each supported validator. The vectorized validators also
+// see it surrounded by ASCII, so it is checked at the start, middle and end of
+// a block, and across block boundaries.
+::testing::AssertionResult CheckUtf8(bool expected, string_view s) {
+  if (IsValidUtf8(s) != expected) {
+    return ::testing::AssertionFailure() << "IsValidUtf8";
+  }
+  if (IsValidUtf8(s, Utf8Validator::Scalar) != expected) {
+    return ::testing::AssertionFailure() << "Scalar";
+  }
+
+  char buf[256];
+  std::fill(std::begin(buf), std::end(buf), 'a');
+  for (auto validator : {Utf8Validator::Sse2, Utf8Validator::Avx2}) {
+    if (!IsUtf8ValidatorSupported(validator)) {
+      continue;
+    }
+    for (size_t before : {0, 13, 30}) {
+      std::copy(s.begin(), s.end(), buf + before);
+      for (size_t after : {0, 33}) {
+        string_view padded{buf, before + s.size() + after};
+        if (IsValidUtf8(padded, validator) != expected) {
+          return ::testing::AssertionFailure()
+                 << "validator " << static_cast<int>(validator) << ", "
+                 << before << " bytes before, " << after << " bytes after";
+        }
+      }
+      std::fill(buf + before, buf + before + s.size(), 'a');
+    }
+  }
+  return ::testing::AssertionSuccess();
+}
+
 void assert_is_valid_utf8(bool expected,
                           int length,
                           int cu0 = 0,
@@ -37,12 +74,12 @@ void assert_is_valid_utf8(bool expected,
     // Make sure it fails if there are continuation bytes past the end of the
     // string.
     for (int bad_length = 1; bad_length < length; ++bad_length) {
-      ASSERT_FALSE(IsValidUtf8(string_view(buf, bad_length)))
+      ASSERT_TRUE(CheckUtf8(false, string_view(buf, bad_length)))
           << cu0 << ", " << cu1 << ", " << cu2 << ", " << cu3;
     }
   }
 
-  ASSERT_TRUE(expected == IsValidUtf8(string_view(buf, length)))
+  ASSERT_TRUE(CheckUtf8(expected, string_view(buf, length)))
       << cu0 << ", " << cu1 << ", " << cu2 << ", " << cu3;
 }
 
@@ -169,3 +206,31 @@ TEST(Utf8Test, invalid_4_bytes) {
     assert_is_valid_utf8(false, 4, cu0, 0x80, 0x80, 0x80);
   }
 }
+
+TEST(Utf8Test, validators_match_scalar) {
+  // Code points of each encoded length, plus bytes that are never valid.
+  const std::string pieces[] = {
+      "a",        "~",        "\xc2\x80", "\xdf\xbf",         "\xe0\xa0\x80",
+      "\xed\x9f\xbf", "\xef\xbf\xbf", "\xf0\x90\x80\x80", "\xf4\x8f\xbf\xbf",
+      "\x80",     "\xc0",     "\xed\xa0\x80", "\xf4\x90\x80\x80", "\xff",
+  };
+
+  std::mt19937 rng{1234};
+  std::uniform_int_distribution<size_t> piece_dist{0, std::size(pieces) - 1};
+  std::uniform_int_distribution<int> length_dist{0, 48};
+  std::uniform_int_distribution<int> byte_dist{0, 255};
+
+  for (int i = 0; i < 20000; ++i) {
+    std::string s;
+    for (int count = length_dist(rng); count > 0; --count) {
+      // Mostly ASCII, like real names.
+      s += piece_dist(rng) < 4 ? pieces[piece_dist(rng)] : std::string(1, 'x');
+    }
+    if (i % 4 == 0 && !s.empty()) {
+      s[byte_dist(rng) % s.size()] = static_cast<char>(byte_dist(rng));
+    }
+
+    bool expected = IsValidUtf8(s, Utf8Validator::Scalar);
+    ASSERT_TRUE(CheckUtf8(expected, s)) << i;
+  }
+}
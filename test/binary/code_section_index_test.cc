@@ -0,0 +1,144 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "wasp/binary/code_section_index.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "test/binary/constants.h"
+#include "test/binary/test_utils.h"
+#include "test/test_utils.h"
+#include "wasp/binary/read/context.h"
+
+using namespace ::wasp;
+using namespace ::wasp::binary;
+using namespace ::wasp::binary::test;
+using namespace ::wasp::test;
+
+TEST(BinaryCodeSectionIndexTest, Basic) {
+  TestErrors errors;
+  Context context{errors};
+  auto index = ReadCodeSectionIndex(
+      "\x02"                           // Count.
+      "\x02\x00\x0b"                   // (func)
+      "\x05\x01\x01\x7f\x6a\x0b"_su8,  // (func (local i32) i32.add)
+      context);
+
+  EXPECT_EQ((At{"\x02"_su8, Index{2}}), index.count);
+  EXPECT_EQ(2u, index.size());
+  EXPECT_EQ("\x02\x00\x0b"_su8, index.GetCodeData(0));
+  EXPECT_EQ("\x05\x01\x01\x7f\x6a\x0b"_su8, index.GetCodeData(1));
+
+  // Read out of order.
+  EXPECT_EQ((At{"\x05\x01\x01\x7f\x6a\x0b"_su8,
+                Code{{At{"\x01\x7f"_su8, Locals{At{"\x01"_su8, Index{1}},
+                                                At{"\x7f"_su8, VT_I32}}}},
+                     At{"\x6a\x0b"_su8, "\x6a\x0b"_expr}}}),
+            index.GetCode(1));
+  EXPECT_EQ((At{"\x02\x00\x0b"_su8, Code{{}, At{"\x0b"_su8, "\x0b"_expr}}}),
+            index.GetCode(0));
+  EXPECT_EQ(0u, context.code_count);
+  ExpectNoErrors(errors);
+}
+
+TEST(BinaryCodeSectionIndexTest, FirstIndex) {
+  TestErrors errors;
+  Context context{errors};
+  auto index = ReadCodeSectionIndex(
+      "\x02"               // Count.
+      "\x02\x00\x0b"       // (func)
+      "\x02\x00\x0b"_su8,  // (func)
+      context, 3);
+
+  EXPECT_EQ(3u, index.first_index());
+  EXPECT_FALSE(index.contains(0));
+  EXPECT_FALSE(index.contains(2));
+  EXPECT_TRUE(index.contains(3));
+  EXPECT_TRUE(index.contains(4));
+  EXPECT_FALSE(index.contains(5));
+
+  EXPECT_EQ(nullopt, index.GetCode(2));
+  EXPECT_NE(nullopt, index.GetCode(3));
+  EXPECT_NE(nullopt, index.GetCode(4));
+  EXPECT_EQ(nullopt, index.GetCode(5));
+  EXPECT_TRUE(index.GetCodeData(5).empty());
+  ExpectNoErrors(errors);
+}
+
+TEST(BinaryCodeSectionIndexTest, Empty) {
+  TestErrors errors;
+  Context context{errors};
+  auto index = ReadCodeSectionIndex("\x00"_su8, context);
+
+  EXPECT_TRUE(index.empty());
+  EXPECT_EQ(nullopt, index.GetCode(0));
+  ExpectNoErrors(errors);
+}
+
+TEST(BinaryCodeSectionIndexTest, LengthPastEnd) {
+  TestErrors errors;
+  Context context{errors};
+  auto index = ReadCodeSectionIndex(
+      "\x02"               // Count.
+      "\x02\x00\x0b"       // (func)
+      "\x05\x00\x0b"_su8,  // Length is too long.
+      context);
+
+  EXPECT_EQ(1u, index.size());
+  EXPECT_NE(nullopt, index.GetCode(0));
+  EXPECT_EQ(nullopt, index.GetCode(1));
+  ExpectError({{4, "Length extends past end: 5 > 2"}}, errors,
+              "\x02\x02\x00\x0b\x05\x00\x0b"_su8);
+}
+
+TEST(BinaryCodeSectionIndexTest, Offsets) {
+  TestErrors errors;
+  Context context{errors};
+  auto data =
+      "\x02"                           // Count.
+      "\x02\x00\x0b"                   // (func)
+      "\x05\x01\x01\x7f\x6a\x0b"_su8;  // (func (local i32) i32.add)
+
+  CodeSectionIndex index{data, context, 0, {0, 3, 9}};
+  EXPECT_EQ(2u, index.size());
+  EXPECT_EQ("\x05\x01\x01\x7f\x6a\x0b"_su8, index.GetCodeData(1));
+  ExpectNoErrors(errors);
+}
+
+TEST(BinaryCodeSectionIndexTest, InvalidOffsets) {
+  TestErrors errors;
+  Context context{errors};
+  auto data =
+      "\x02"                           // Count.
+      "\x02\x00\x0b"                   // (func)
+      "\x05\x01\x01\x7f\x6a\x0b"_su8;  // (func (local i32) i32.add)
+
+  const std::vector<u32> tests[] = {
+      {},            // No end offset.
+      {1, 3, 9},     // Doesn't start at 0.
+      {0, 3, 10},    // Past the end of the data.
+      {0, 9, 3},     // Not increasing.
+      {0, 3, 3, 9},  // Empty body.
+  };
+
+  for (const auto& offsets : tests) {
+    // The section is scanned instead.
+    CodeSectionIndex index{data, context, 0, offsets};
+    EXPECT_EQ((std::vector<u32>{0, 3, 9}), index.offsets());
+  }
+  ExpectNoErrors(errors);
+}
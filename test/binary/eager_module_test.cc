@@ -0,0 +1,86 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/binary/eager_module.h"
+
+#include "gtest/gtest.h"
+#include "test/binary/constants.h"
+#include "test/test_utils.h"
+#include "wasp/base/features.h"
+
+using namespace ::wasp;
+using namespace ::wasp::binary;
+using namespace ::wasp::binary::test;
+using namespace ::wasp::test;
+
+TEST(BinaryEagerModuleTest, Basic) {
+  TestErrors errors;
+  auto module = ReadModuleEager(
+      "\0asm\x01\0\0\0"_su8
+      "\x01\x09\x02\x60\x00\x01\x7f\x60\x01\x7f\x00"_su8  // Type section.
+      "\x03\x03\x02\x00\x01"_su8                          // Function section.
+      "\x07\x05\x01\x01\x66\x00\x00"_su8                  // Export section.
+      "\x0a\x0c\x02"_su8                                  // Code section.
+      "\x04\x00\x41\x01\x0b"_su8                          //   i32.const 1
+      "\x05\x01\x01\x7f\x1a\x0b"_su8,                     //   (local i32) drop
+      Features{}, errors);
+  ExpectNoErrors(errors);
+
+  EXPECT_EQ(2u, module.types.size());
+  EXPECT_EQ(2u, module.functions.size());
+  EXPECT_EQ(Index{1}, module.functions[1]->type_index);
+  ASSERT_EQ(1u, module.exports.size());
+  EXPECT_EQ("f", module.exports[0]->name.value());
+  EXPECT_EQ(nullopt, module.start);
+  EXPECT_EQ(nullopt, module.data_count);
+
+  ASSERT_EQ(2u, module.codes.size());
+  EXPECT_TRUE(module.codes[0]->locals.empty());
+  ASSERT_EQ(2u, module.codes[0]->body.instructions.size());
+  EXPECT_EQ((At{"\x41\x01"_su8, Instruction{At{"\x41"_su8, Opcode::I32Const},
+                                            At{"\x01"_su8, s32{1}}}}),
+            module.codes[0]->body.instructions[0]);
+  EXPECT_EQ(Opcode::End, module.codes[0]->body.instructions[1]->opcode);
+
+  ASSERT_EQ(1u, module.codes[1]->locals.size());
+  EXPECT_EQ((At{"\x01\x7f"_su8,
+                Locals{At{"\x01"_su8, Index{1}}, At{"\x7f"_su8, VT_I32}}}),
+            module.codes[1]->locals[0]);
+  ASSERT_EQ(2u, module.codes[1]->body.instructions.size());
+  EXPECT_EQ(Opcode::Drop, module.codes[1]->body.instructions[0]->opcode);
+}
+
+TEST(BinaryEagerModuleTest, Empty) {
+  TestErrors errors;
+  auto module = ReadModuleEager("\0asm\x01\0\0\0"_su8, Features{}, errors);
+  ExpectNoErrors(errors);
+  EXPECT_EQ(Module{}, module);
+}
+
+TEST(BinaryEagerModuleTest, MalformedBody) {
+  TestErrors errors;
+  auto module = ReadModuleEager(
+      "\0asm\x01\0\0\0"_su8
+      "\x01\x04\x01\x60\x00\x00"_su8  // Type section.
+      "\x03\x02\x01\x00"_su8          // Function section.
+      "\x0a\x05\x01"_su8              // Code section.
+      "\x03\x00\x41\x0b"_su8,         //   i32.const <truncated>
+      Features{}, errors);
+  EXPECT_FALSE(errors.errors.empty());
+  EXPECT_EQ(1u, module.types.size());
+  EXPECT_EQ(1u, module.functions.size());
+}
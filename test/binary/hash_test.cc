@@ -0,0 +1,107 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/binary/hash.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "test/test_utils.h"
+#include "wasp/base/features.h"
+#include "wasp/base/thread_pool.h"
+#include "wasp/binary/code_section_index.h"
+#include "wasp/binary/lazy_module.h"
+#include "wasp/binary/read/context.h"
+
+using namespace ::wasp;
+using namespace ::wasp::binary;
+using namespace ::wasp::test;
+
+namespace {
+
+const SpanU8 kHeader = "\0asm\x01\0\0\0"_su8;
+const SpanU8 kTypeSection = "\x01\x04\x01\x60\x00\x00"_su8;
+const SpanU8 kNameSection = "\x00\x08\x04name\x00\x01\x00"_su8;
+const SpanU8 kFooSection = "\x00\x05\x03\x66oo\x00"_su8;
+
+std::vector<u8> Concat(std::initializer_list<SpanU8> spans) {
+  std::vector<u8> result;
+  for (auto span : spans) {
+    result.insert(result.end(), span.begin(), span.end());
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(BinaryHashTest, HashSections) {
+  auto data = Concat({kHeader, kTypeSection, kNameSection});
+  TestErrors errors;
+  auto module = ReadModule(SpanU8{data}, Features{}, errors);
+  ThreadPool pool{2};
+  auto sections = HashSections(module, pool);
+
+  ASSERT_EQ(2u, sections.size());
+  EXPECT_EQ(SectionId::Type, sections[0].id);
+  EXPECT_EQ("", sections[0].name);
+  EXPECT_EQ(HashBytes("\x01\x60\x00\x00"_su8, 1), sections[0].hash);
+  EXPECT_EQ(SectionId::Custom, sections[1].id);
+  EXPECT_EQ("name", sections[1].name);
+  EXPECT_EQ(HashBytes("\x00\x01\x00"_su8, HashBytes("name"_su8).low),
+            sections[1].hash);
+  ExpectNoErrors(errors);
+}
+
+TEST(BinaryHashTest, HashModule) {
+  auto plain = Concat({kHeader, kTypeSection});
+  auto named = Concat({kHeader, kTypeSection, kNameSection});
+  auto foo = Concat({kHeader, kTypeSection, kFooSection, kNameSection});
+  TestErrors errors;
+  ThreadPool pool{2};
+  auto hash = [&](const std::vector<u8>& data,
+                  const std::vector<string_view>& ignored) {
+    auto module = ReadModule(SpanU8{data}, Features{}, errors);
+    return HashModule(module, pool, ignored);
+  };
+
+  EXPECT_NE(hash(plain, {}), hash(named, {}));
+  EXPECT_EQ(hash(plain, {}), hash(named, {"name"}));
+  EXPECT_NE(hash(plain, {"name"}), hash(foo, {"name"}));
+  EXPECT_EQ(hash(plain, {}), hash(foo, {"name", "foo"}));
+  ExpectNoErrors(errors);
+}
+
+TEST(BinaryHashTest, HashFunctionBodies) {
+  // 200 bodies, where body `i` is `(local i32) i32.const (i % 3)`.
+  std::vector<u8> data{0xc8, 0x01};
+  for (int i = 0; i < 200; ++i) {
+    data.insert(data.end(), {0x06, 0x01, 0x01, 0x7f, 0x41, u8(i % 3), 0x0b});
+  }
+  TestErrors errors;
+  Context context{errors};
+  auto index = ReadCodeSectionIndex(SpanU8{data}, context, 5);
+  ThreadPool pool{4};
+  auto hashes = HashFunctionBodies(index, pool);
+
+  ASSERT_EQ(200u, hashes.size());
+  for (size_t i = 0; i < hashes.size(); ++i) {
+    std::vector<u8> body{0x01, 0x01, 0x7f, 0x41, u8(i % 3), 0x0b};
+    EXPECT_EQ(HashBytes(SpanU8{body}), hashes[i]);
+  }
+  EXPECT_NE(hashes[0], hashes[1]);
+  ExpectNoErrors(errors);
+}
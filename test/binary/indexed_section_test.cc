@@ -0,0 +1,203 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/binary/indexed_section.h"
+
+#include <atomic>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "test/binary/test_utils.h"
+#include "test/test_utils.h"
+#include "wasp/base/buffer.h"
+#include "wasp/base/thread_pool.h"
+#include "wasp/binary/name_section/read.h"
+#include "wasp/binary/name_section/types.h"
+#include "wasp/binary/read/context.h"
+#include "wasp/binary/sections.h"
+
+using namespace ::wasp;
+using namespace ::wasp::binary;
+using namespace ::wasp::binary::test;
+using namespace ::wasp::test;
+
+namespace {
+
+// Exports with names of different lengths, so each element has a different
+// size.
+const SpanU8 kExportSection =
+    "\x05"                    // Count.
+    "\x01"
+    "a\x00\x00"               // (export "a" (func 0))
+    "\x02"
+    "bb\x00\x01"              // (export "bb" (func 1))
+    "\x03"
+    "ccc\x00\x02"             // (export "ccc" (func 2))
+    "\x04"
+    "dddd\x00\x03"            // (export "dddd" (func 3))
+    "\x01"
+    "e\x00\x04"_su8;          // (export "e" (func 4))
+
+const char* const kExportNames[] = {"a", "bb", "ccc", "dddd", "e"};
+
+}  // namespace
+
+TEST(BinaryIndexedSectionTest, Basic) {
+  TestErrors errors;
+  Context context{errors};
+  IndexedSection<Export> exports{kExportSection, context};
+
+  EXPECT_EQ((At{"\x05"_su8, Index{5}}), exports.count);
+  EXPECT_EQ(5u, exports.size());
+  EXPECT_FALSE(exports.is_fixed_size());
+
+  // Read out of order.
+  for (Index i : {3, 0, 4, 1, 2}) {
+    auto export_ = exports[i];
+    ASSERT_TRUE(export_.has_value());
+    EXPECT_EQ(kExportNames[i], export_->value().name.value());
+    EXPECT_EQ(i, export_->value().index.value());
+  }
+  EXPECT_EQ(nullopt, exports[5]);
+  ExpectNoErrors(errors);
+}
+
+TEST(BinaryIndexedSectionTest, Stride) {
+  for (Index stride : {2, 3, 5, 100}) {
+    TestErrors errors;
+    Context context{errors};
+    IndexedSection<Export> exports{kExportSection, context, stride};
+
+    EXPECT_EQ(stride, exports.stride());
+    EXPECT_EQ(5u, exports.size());
+    for (Index i = 0; i < 5; ++i) {
+      auto export_ = exports[i];
+      ASSERT_TRUE(export_.has_value());
+      EXPECT_EQ(kExportNames[i], export_->value().name.value());
+      EXPECT_EQ(i, export_->value().index.value());
+    }
+    ExpectNoErrors(errors);
+  }
+}
+
+TEST(BinaryIndexedSectionTest, FromLazySection) {
+  TestErrors errors;
+  Context context{errors};
+  auto section = ReadExportSection(kExportSection, context);
+  IndexedSection<Export> exports{section, context};
+
+  EXPECT_EQ(section.count, exports.count);
+  EXPECT_EQ(5u, exports.size());
+  EXPECT_EQ("dddd", exports[3]->value().name.value());
+  ExpectNoErrors(errors);
+}
+
+TEST(BinaryIndexedSectionTest, FixedSize) {
+  TestErrors errors;
+  Context context{errors};
+  IndexedSection<Function> functions{
+      "\x04\x00\x01\x02\x01"_su8,  // 4 functions, type indexes 0, 1, 2, 1.
+      context, 2};
+
+  EXPECT_EQ(4u, functions.size());
+  EXPECT_TRUE(functions.is_fixed_size());
+  EXPECT_EQ(Index{2}, functions[2]->value().type_index.value());
+  EXPECT_EQ(Index{1}, functions[3]->value().type_index.value());
+  EXPECT_EQ(Index{0}, functions[0]->value().type_index.value());
+  EXPECT_EQ(nullopt, functions[4]);
+  ExpectNoErrors(errors);
+}
+
+TEST(BinaryIndexedSectionTest, ContextCounts) {
+  TestErrors errors;
+  Context context{errors};
+  IndexedSection<Function> functions{"\x02\x00\x00"_su8, context};
+  IndexedSection<Code> codes{"\x02\x02\x00\x0b\x02\x00\x0b"_su8, context};
+
+  EXPECT_EQ(2u, functions.size());
+  EXPECT_EQ(2u, codes.size());
+  // Building an index doesn't count the elements as read.
+  EXPECT_EQ(0u, context.defined_function_count);
+  EXPECT_EQ(0u, context.code_count);
+  ExpectNoErrors(errors);
+}
+
+TEST(BinaryIndexedSectionTest, NameAssoc) {
+  TestErrors errors;
+  Context context{errors};
+  IndexedSection<NameAssoc> names{
+      "\x03"                       // Count.
+      "\x00\x04zero"               // 0 => "zero"
+      "\x02\x03two"                // 2 => "two"
+      "\x05\x04\x66ive"_su8,       // 5 => "five"
+      context};
+
+  ASSERT_EQ(3u, names.size());
+  EXPECT_EQ(Index{5}, names[2]->value().index.value());
+  EXPECT_EQ("five", names[2]->value().name.value());
+  EXPECT_EQ("zero", names[0]->value().name.value());
+  ExpectNoErrors(errors);
+}
+
+TEST(BinaryIndexedSectionTest, Malformed) {
+  TestErrors errors;
+  Context context{errors};
+  IndexedSection<Export> exports{
+      "\x02"               // Count.
+      "\x01"
+      "a\x00\x00"          // (export "a" (func 0))
+      "\x05"
+      "b\x00\x01"_su8,     // Name length is too long.
+      context};
+
+  EXPECT_EQ(1u, exports.size());
+  EXPECT_EQ("a", exports[0]->value().name.value());
+  EXPECT_EQ(nullopt, exports[1]);
+  EXPECT_FALSE(errors.errors.empty());
+}
+
+TEST(BinaryIndexedSectionTest, ForEachParallel) {
+  // Use enough elements that there is more than one chunk.
+  const Index count = 1000;
+  Buffer data;
+  data.push_back(0xe8);  // 1000 as a LEB128.
+  data.push_back(0x07);
+  for (Index i = 0; i < count; ++i) {
+    data.push_back(0x00);  // Name map index 0, then a name of length i % 4.
+    data.push_back(static_cast<u8>(i % 4));
+    for (Index j = 0; j < i % 4; ++j) {
+      data.push_back('x');
+    }
+  }
+
+  TestErrors errors;
+  Context context{errors};
+  IndexedSection<NameAssoc> names{data, context, 7};
+  ASSERT_EQ(count, names.size());
+
+  ThreadPool pool{4};
+  std::vector<std::atomic<int>> seen(count);
+  names.ForEachParallel(pool, [&](Index index, const At<NameAssoc>& name) {
+    EXPECT_EQ(index % 4, name->name->size());
+    seen[index]++;
+  });
+
+  for (Index i = 0; i < count; ++i) {
+    EXPECT_EQ(1, seen[i].load()) << "index " << i;
+  }
+  ExpectNoErrors(errors);
+}
@@ -65,3 +65,148 @@ TEST(BinaryLazyExprTest, SimpleFunction) {
             *it++);
   ASSERT_EQ(end, it);
 }
+
+TEST(BinaryLazyExprTest, Raw) {
+  TestErrors errors;
+  Context context{errors};
+  // local.get 0
+  // br_table 0 1 0
+  // end
+  auto expr =
+      ReadRawExpression("\x20\x00\x0e\x02\x00\x01\x00\x0b"_su8, context);
+  auto it = expr.begin(), end = expr.end();
+  EXPECT_EQ(Opcode::LocalGet, it->value().opcode);
+  EXPECT_EQ("\x20\x00"_su8, it->value().data);
+  EXPECT_EQ("\x00"_su8, it->value().immediate);
+  ++it;
+  ASSERT_NE(end, it);
+  EXPECT_EQ(Opcode::BrTable, it->value().opcode);
+  EXPECT_EQ("\x0e\x02\x00\x01\x00"_su8, it->value().data);
+  EXPECT_EQ("\x02\x00\x01\x00"_su8, it->value().immediate);
+  ++it;
+  ASSERT_NE(end, it);
+  EXPECT_EQ(Opcode::End, it->value().opcode);
+  EXPECT_TRUE(it->value().immediate.empty());
+  ++it;
+  ASSERT_EQ(end, it);
+  ExpectNoErrors(errors);
+}
+
+TEST(BinaryLazyExprTest, Raw_DecodeInstruction) {
+  TestErrors errors;
+  Features features;
+  features.EnableAll();
+  Context context{features, errors};
+  context.declared_data_count = 1;
+
+  // Each instruction is read both fully and raw; they must cover the same
+  // bytes and decode to the same value.
+  const SpanU8 instrs[] = {
+      "\x02\x40"_su8,                          // block
+      "\x0b"_su8,                              // end
+      "\x0c\x80\x01"_su8,                      // br 128
+      "\x0e\x03\x00\x01\x02\x03"_su8,          // br_table
+      "\x10\x05"_su8,                          // call 5
+      "\x11\x02\x00"_su8,                      // call_indirect
+      "\x1c\x02\x7f\x7e"_su8,                  // select (result i32 i64)
+      "\x28\x02\xff\x01"_su8,                  // i32.load
+      "\x3f\x00"_su8,                          // memory.size
+      "\x41\x7f"_su8,                          // i32.const -1
+      "\x42\x80\x80\x01"_su8,                  // i64.const
+      "\x43\x00\x00\x80\x3f"_su8,              // f32.const 1
+      "\x44\x00\x00\x00\x00\x00\x00\xf0\x3f"_su8,  // f64.const 1
+      "\xd0\x70"_su8,                          // ref.null func
+      "\xfc\x08\x01\x00"_su8,                  // memory.init
+      "\xfc\x09\x01"_su8,                      // data.drop
+      "\xfc\x0e\x01\x02"_su8,                  // table.copy
+      "\xfd\x15\x03"_su8,                      // i8x16.extract_lane_s
+  };
+
+  for (auto instr : instrs) {
+    SpanU8 full_data = instr;
+    SpanU8 raw_data = instr;
+    auto full = Read<Instruction>(&full_data, context);
+    auto raw = Read<RawInstruction>(&raw_data, context);
+    ASSERT_TRUE(full.has_value());
+    ASSERT_TRUE(raw.has_value());
+    EXPECT_EQ(instr, raw->value().data);
+    EXPECT_TRUE(full_data.empty());
+    EXPECT_TRUE(raw_data.empty());
+    EXPECT_EQ(full, DecodeInstruction(raw->value(), context));
+  }
+  ExpectNoErrors(errors);
+}
+
+TEST(BinaryLazyExprTest, Raw_Errors) {
+  // The raw reader reports the same errors as the full reader.
+  const SpanU8 data = "\x0e\x02\x00"_su8;  // br_table, missing a target.
+
+  TestErrors full_errors;
+  Context full_context{full_errors};
+  for (auto instr : ReadExpression(data, full_context)) {
+    (void)instr;
+  }
+
+  TestErrors raw_errors;
+  Context raw_context{raw_errors};
+  for (auto instr : ReadRawExpression(data, raw_context)) {
+    (void)instr;
+  }
+
+  ASSERT_EQ(1u, full_errors.errors.size());
+  ExpectError(full_errors.errors[0], raw_errors);
+}
+
+TEST(BinaryLazyExprTest, Raw_AllOpcodes) {
+  // Every opcode is read both fully and raw, followed by several immediates
+  // (valid or not). Both readers must consume the same bytes and report the
+  // same errors.
+  Features features;
+  features.EnableAll();
+
+  std::vector<std::vector<u8>> opcodes;
+#define WASP_V(prefix, code, Name, str) opcodes.push_back({code});
+#define WASP_FEATURE_V(prefix, code, Name, str, feature) \
+  WASP_V(prefix, code, Name, str)
+#define WASP_PREFIX_V(prefix, code, Name, str, feature)                   \
+  opcodes.push_back(code < 0x80 ? std::vector<u8>{prefix, code}           \
+                                : std::vector<u8>{prefix, u8(code | 0x80), \
+                                                  u8(code >> 7)});
+#include "wasp/base/def/opcode.def"
+#undef WASP_V
+#undef WASP_FEATURE_V
+#undef WASP_PREFIX_V
+
+  const SpanU8 immediates[] = {
+      ""_su8,
+      "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"_su8,
+      "\x01\x01\x01\x01\x01\x01\x01\x01\x01\x01\x01\x01\x01\x01\x01\x01"_su8,
+      "\x40\x02\x7f\x7e\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"_su8,
+      "\x7f\x80\x80\x80\x80\x10\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"_su8,
+  };
+
+  for (const auto& opcode : opcodes) {
+    for (auto immediate : immediates) {
+      std::vector<u8> bytes = opcode;
+      bytes.insert(bytes.end(), immediate.begin(), immediate.end());
+
+      TestErrors full_errors;
+      Context full_context{features, full_errors};
+      full_context.declared_data_count = 1;
+      SpanU8 full_data{bytes};
+      auto full = Read<Instruction>(&full_data, full_context);
+
+      TestErrors raw_errors;
+      Context raw_context{features, raw_errors};
+      raw_context.declared_data_count = 1;
+      SpanU8 raw_data{bytes};
+      auto raw = Read<RawInstruction>(&raw_data, raw_context);
+
+      EXPECT_EQ(full.has_value(), raw.has_value());
+      EXPECT_EQ(full_data.size(), raw_data.size());
+      EXPECT_EQ(full_context.open_blocks, raw_context.open_blocks);
+      EXPECT_EQ(full_context.seen_final_end, raw_context.seen_final_end);
+      ExpectErrors(full_errors.errors, raw_errors);
+    }
+  }
+}
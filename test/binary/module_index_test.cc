@@ -0,0 +1,158 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/binary/module_index.h"
+
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "test/test_utils.h"
+#include "wasp/base/buffer.h"
+#include "wasp/base/features.h"
+#include "wasp/base/hash.h"
+#include "wasp/binary/lazy_module.h"
+#include "wasp/binary/lazy_module_utils.h"
+
+using namespace ::wasp;
+using namespace ::wasp::binary;
+using namespace ::wasp::test;
+
+namespace {
+
+const SpanU8 kModule =
+    "\0asm\x01\0\0\0"_su8
+    "\x01\x04\x01\x60\x00\x00"_su8                  // Type section.
+    "\x02\x07\x01\x01m\x01\x66\x00\x00"_su8         // Import section.
+    "\x03\x03\x02\x00\x00"_su8                      // Function section.
+    "\x07\x08\x01\x04main\x00\x01"_su8              // Export section.
+    "\x0a\x09\x02"_su8                              // Code section.
+    "\x02\x00\x0b"_su8                              //   (func)
+    "\x04\x00\x10\x00\x0b"_su8                      //   (func call 0)
+    "\x00\x0b\x04name\x01\x04\x01\x02\x01g"_su8;   // Name section.
+
+}  // namespace
+
+TEST(BinaryModuleIndexTest, HashModuleContents) {
+  EXPECT_EQ(HashBytes(""_su8).low, HashModuleContents(""_su8));
+  EXPECT_EQ(HashBytes("abc"_su8).low, HashModuleContents("abc"_su8));
+
+  Buffer data(100);
+  auto hash = HashModuleContents(data);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = 1;
+    EXPECT_NE(hash, HashModuleContents(data)) << "index " << i;
+    data[i] = 0;
+  }
+}
+
+TEST(BinaryModuleIndexTest, Build) {
+  TestErrors errors;
+  auto index = BuildModuleIndex(kModule, Features{}, errors);
+  ExpectNoErrors(errors);
+
+  EXPECT_EQ(u64(kModule.size()), index.module_size);
+  EXPECT_EQ(HashModuleLayout(kModule), index.layout_hash);
+  EXPECT_EQ(HashModuleContents(kModule), index.content_hash);
+
+  EXPECT_EQ(1u, index.GetImportCount(ExternalKind::Function));
+  EXPECT_EQ(0u, index.GetImportCount(ExternalKind::Memory));
+  EXPECT_EQ(0u, index.GetImportCount(ExternalKind::Event));
+
+  ASSERT_EQ(3u, index.function_names.size());
+  EXPECT_EQ(0u, index.function_names[0].index);
+  EXPECT_EQ("f", GetString(kModule, index.function_names[0].name));
+  EXPECT_EQ(1u, index.function_names[1].index);
+  EXPECT_EQ("main", GetString(kModule, index.function_names[1].name));
+  EXPECT_EQ(2u, index.function_names[2].index);
+  EXPECT_EQ("g", GetString(kModule, index.function_names[2].name));
+
+  ASSERT_TRUE(index.code_section.has_value());
+  EXPECT_EQ((std::vector<u32>{0, 3, 8}), index.code_offsets);
+}
+
+TEST(BinaryModuleIndexTest, RoundTrip) {
+  TestErrors errors;
+  auto index = BuildModuleIndex(kModule, Features{}, errors);
+  auto buffer = WriteModuleIndex(index);
+  auto read = ReadModuleIndex(buffer, kModule);
+  ASSERT_TRUE(read.has_value());
+
+  EXPECT_EQ(index.module_size, read->module_size);
+  EXPECT_EQ(index.layout_hash, read->layout_hash);
+  EXPECT_EQ(index.content_hash, read->content_hash);
+  EXPECT_EQ(index.import_counts, read->import_counts);
+  EXPECT_EQ(index.code_offsets, read->code_offsets);
+  ASSERT_EQ(index.function_names.size(), read->function_names.size());
+  for (size_t i = 0; i < index.function_names.size(); ++i) {
+    EXPECT_EQ(index.function_names[i].index, read->function_names[i].index);
+    EXPECT_EQ(GetString(kModule, index.function_names[i].name),
+              GetString(kModule, read->function_names[i].name));
+  }
+}
+
+TEST(BinaryModuleIndexTest, Mismatch) {
+  TestErrors errors;
+  auto index = BuildModuleIndex(kModule, Features{}, errors);
+  auto buffer = WriteModuleIndex(index);
+
+  EXPECT_TRUE(VerifyModuleIndex(index, kModule));
+
+  // Same layout, different contents. Only the layout is checked when reading.
+  Buffer changed{kModule.begin(), kModule.end()};
+  changed.back() = 'h';
+  auto read = ReadModuleIndex(buffer, changed);
+  ASSERT_TRUE(read.has_value());
+  EXPECT_FALSE(VerifyModuleIndex(*read, changed));
+
+  // Same size, different layout: the type section's size is changed.
+  changed = Buffer{kModule.begin(), kModule.end()};
+  changed[9] = 0x05;
+  EXPECT_EQ(nullopt, ReadModuleIndex(buffer, changed));
+  EXPECT_FALSE(VerifyModuleIndex(index, changed));
+
+  // Different size.
+  EXPECT_EQ(nullopt, ReadModuleIndex(buffer, kModule.first(8)));
+
+  // Function names that aren't sorted by index.
+  auto unsorted = index;
+  std::swap(unsorted.function_names[0], unsorted.function_names[2]);
+  EXPECT_EQ(nullopt, ReadModuleIndex(WriteModuleIndex(unsorted), kModule));
+
+  // Truncated index.
+  for (size_t size = 0; size < buffer.size(); ++size) {
+    EXPECT_EQ(nullopt,
+              ReadModuleIndex(SpanU8{buffer}.first(size), kModule))
+        << "size " << size;
+  }
+}
+
+TEST(BinaryModuleIndexTest, LazyModuleUtils) {
+  TestErrors errors;
+  auto index = BuildModuleIndex(kModule, Features{}, errors);
+
+  auto module = ReadModule(kModule, Features{}, errors);
+  module.index = &index;
+  EXPECT_EQ(1u, GetImportCount(module, ExternalKind::Function));
+
+  auto code_index = ReadCodeSectionIndex(module);
+  ASSERT_TRUE(code_index.has_value());
+  EXPECT_EQ(1u, code_index->first_index());
+  EXPECT_EQ(2u, code_index->size());
+  EXPECT_EQ("\x04\x00\x10\x00\x0b"_su8, code_index->GetCodeData(2));
+  ExpectNoErrors(errors);
+}
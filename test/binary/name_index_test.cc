@@ -0,0 +1,190 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/binary/name_section/name_index.h"
+
+#include <iterator>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "test/test_utils.h"
+#include "wasp/base/buffer.h"
+#include "wasp/base/features.h"
+#include "wasp/binary/lazy_module.h"
+#include "wasp/binary/module_index.h"
+#include "wasp/binary/write.h"
+
+using namespace ::wasp;
+using namespace ::wasp::binary;
+using namespace ::wasp::test;
+
+namespace {
+
+void WriteSection(Buffer& out, u8 id, const Buffer& contents) {
+  auto iter = Write(id, std::back_inserter(out));
+  Write(static_cast<u32>(contents.size()), iter);
+  out.insert(out.end(), contents.begin(), contents.end());
+}
+
+// Builds a module that imports function 0 as "f", exports function 1 as "g",
+// and has a name section that names every even function below 80 "n<index>",
+// and the locals 0 and 1 of every fourth function "l0" and "l1".
+Buffer MakeModule(bool sorted = true) {
+  auto name_index = [&](Index i, Index count) {
+    return sorted ? i : count - 1 - i;
+  };
+
+  Buffer function_names;
+  auto out = Write(u32{40}, std::back_inserter(function_names));
+  for (Index i = 0; i < 40; ++i) {
+    Index index = name_index(i, 40) * 2;
+    out = Write(index, out);
+    out = Write(string_view{"n" + std::to_string(index)}, out);
+  }
+
+  Buffer local_names;
+  out = Write(u32{20}, std::back_inserter(local_names));
+  for (Index i = 0; i < 20; ++i) {
+    out = Write(name_index(i, 20) * 4, out);
+    out = Write(u32{2}, out);
+    out = Write(u32{0}, out);
+    out = Write(string_view{"l0"}, out);
+    out = Write(u32{1}, out);
+    out = Write(string_view{"l1"}, out);
+  }
+
+  Buffer name_section;
+  Write(string_view{"name"}, std::back_inserter(name_section));
+  WriteSection(name_section, 1, function_names);
+  WriteSection(name_section, 2, local_names);
+
+  Buffer module{'\0', 'a', 's', 'm', 1, 0, 0, 0};
+  WriteSection(module, 2, Buffer{1, 1, 'm', 1, 'f', 0, 0});  // Import.
+  WriteSection(module, 7, Buffer{1, 1, 'g', 0, 1});          // Export.
+  WriteSection(module, 0, name_section);
+  return module;
+}
+
+}  // namespace
+
+TEST(BinaryNameIndexTest, GetFunctionName) {
+  for (bool sorted : {true, false}) {
+    auto data = MakeModule(sorted);
+    TestErrors errors;
+    auto module = ReadModule(data, Features{}, errors);
+    NameIndex names{module};
+
+    EXPECT_EQ("f", names.GetFunctionName(0));  // Import name wins.
+    EXPECT_EQ("g", names.GetFunctionName(1));
+    EXPECT_EQ("n2", names.GetFunctionName(2));
+    EXPECT_EQ("n32", names.GetFunctionName(32));
+    EXPECT_EQ("n34", names.GetFunctionName(34));
+    EXPECT_EQ("n78", names.GetFunctionName(78));
+    EXPECT_EQ(nullopt, names.GetFunctionName(3));
+    EXPECT_EQ(nullopt, names.GetFunctionName(80));
+    ExpectNoErrors(errors);
+  }
+}
+
+TEST(BinaryNameIndexTest, GetLocalName) {
+  for (bool sorted : {true, false}) {
+    auto data = MakeModule(sorted);
+    TestErrors errors;
+    auto module = ReadModule(data, Features{}, errors);
+    NameIndex names{module};
+
+    EXPECT_EQ("l0", names.GetLocalName(0, 0));
+    EXPECT_EQ("l1", names.GetLocalName(4, 1));
+    EXPECT_EQ("l0", names.GetLocalName(76, 0));
+    EXPECT_EQ(nullopt, names.GetLocalName(4, 2));
+    EXPECT_EQ(nullopt, names.GetLocalName(2, 0));
+    EXPECT_EQ(nullopt, names.GetLocalName(80, 0));
+    ExpectNoErrors(errors);
+  }
+}
+
+TEST(BinaryNameIndexTest, FindFunction) {
+  auto data = MakeModule();
+  TestErrors errors;
+  auto module = ReadModule(data, Features{}, errors);
+  NameIndex names{module};
+
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_EQ(Index{0}, names.FindFunction("f"));
+    EXPECT_EQ(Index{0}, names.FindFunction("n0"));
+    EXPECT_EQ(Index{1}, names.FindFunction("g"));
+    EXPECT_EQ(Index{40}, names.FindFunction("n40"));
+    EXPECT_EQ(nullopt, names.FindFunction("n1"));
+    // The second iteration uses the hash map.
+    names.BuildFunctionNameMap();
+  }
+  ExpectNoErrors(errors);
+}
+
+TEST(BinaryNameIndexTest, ModuleIndex) {
+  auto data = MakeModule();
+  TestErrors errors;
+  auto index = BuildModuleIndex(data, Features{}, errors);
+
+  // The sidecar has every name, sorted by index, with the import name first.
+  ASSERT_EQ(42u, index.function_names.size());
+  EXPECT_EQ(0u, index.function_names[0].index);
+  EXPECT_EQ("f", GetString(data, index.function_names[0].name));
+  EXPECT_EQ(0u, index.function_names[1].index);
+  EXPECT_EQ("n0", GetString(data, index.function_names[1].name));
+  EXPECT_EQ(1u, index.function_names[2].index);
+  EXPECT_EQ("g", GetString(data, index.function_names[2].name));
+
+  // Point function 2's name at the export name, so names that come from the
+  // sidecar can be told apart from names read from the module.
+  ASSERT_EQ(2u, index.function_names[3].index);
+  index.function_names[3].name = index.function_names[2].name;
+
+  auto module = ReadModule(data, Features{}, errors);
+  module.index = &index;
+  NameIndex names{module};
+
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_EQ("f", names.GetFunctionName(0));
+    EXPECT_EQ("g", names.GetFunctionName(1));
+    EXPECT_EQ("g", names.GetFunctionName(2));
+    EXPECT_EQ("n4", names.GetFunctionName(4));
+    EXPECT_EQ(nullopt, names.GetFunctionName(3));
+    EXPECT_EQ(nullopt, names.GetFunctionName(80));
+
+    EXPECT_EQ(Index{0}, names.FindFunction("n0"));
+    EXPECT_EQ(Index{1}, names.FindFunction("g"));
+    EXPECT_EQ(nullopt, names.FindFunction("n2"));
+    // The second iteration uses the hash map.
+    names.BuildFunctionNameMap();
+  }
+
+  // Local names are still read from the module.
+  EXPECT_EQ("l1", names.GetLocalName(4, 1));
+  ExpectNoErrors(errors);
+}
+
+TEST(BinaryNameIndexTest, NoNames) {
+  TestErrors errors;
+  auto module = ReadModule("\0asm\x01\0\0\0"_su8, Features{}, errors);
+  NameIndex names{module};
+
+  EXPECT_EQ(nullopt, names.GetFunctionName(0));
+  EXPECT_EQ(nullopt, names.GetLocalName(0, 0));
+  EXPECT_EQ(nullopt, names.FindFunction("f"));
+  ExpectNoErrors(errors);
+}
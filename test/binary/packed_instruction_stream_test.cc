@@ -0,0 +1,235 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/binary/packed_instruction_stream.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "test/binary/constants.h"
+#include "test/test_utils.h"
+#include "wasp/binary/lazy_expression.h"
+#include "wasp/binary/read/context.h"
+
+using namespace ::wasp;
+using namespace ::wasp::binary;
+using namespace ::wasp::binary::test;
+using namespace ::wasp::test;
+
+namespace {
+
+const SpanU8 kExpr =
+    "\x02\x7f"                                  // block (result i32)
+    "\x41\x05"                                  // i32.const 5
+    "\x0e\x02\x00\x01\x00"                      // br_table 0 1 0
+    "\x0b"                                      // end
+    "\x42\x7f"                                  // i64.const -1
+    "\x43\x00\x00\x80\x3f"                      // f32.const 1
+    "\x44\x00\x00\x00\x00\x00\x00\xf0\x3f"      // f64.const 1
+    "\x28\x02\x08"                              // i32.load align=4 offset=8
+    "\x11\x01\x00"                              // call_indirect 1 0
+    "\x1c\x01\x7f"                              // select (result i32)
+    "\x17\x40\x01\x02\x7f"                      // let (local i32 i32)
+    "\xfd\x0c\x00\x01\x02\x03\x04\x05\x06\x07"  // v128.const
+    "\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f"          //
+    "\xfd\x0d\x00\x01\x02\x03\x04\x05\x06\x07"  // i8x16.shuffle
+    "\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f"          //
+    "\xfd\x15\x03"                              // i8x16.extract_lane_s 3
+    "\xfb\x41\x70\x6f"                          // ref.cast func extern
+    "\xfc\x0e\x00\x01"                          // table.copy 0 1
+    "\xd0\x70"                                  // ref.null func
+    "\x0b"_su8;                                 // end
+
+}  // namespace
+
+TEST(BinaryPackedInstructionStreamTest, RoundTrip) {
+  TestErrors errors;
+  Context context{errors};
+  context.features.EnableAll();
+
+  std::vector<At<Instruction>> expected;
+  for (const auto& instr : ReadExpression(kExpr, context)) {
+    expected.push_back(instr);
+  }
+  ExpectNoErrors(errors);
+  ASSERT_EQ(18u, expected.size());
+
+  auto stream = ReadPackedInstructionStream(kExpr, context);
+  ExpectNoErrors(errors);
+  ASSERT_EQ(expected.size(), stream.size());
+
+  Index index = 0;
+  for (auto instr : stream) {
+    EXPECT_EQ(expected[index], instr.ToInstruction());
+    EXPECT_EQ(expected[index].loc(), instr.loc());
+    EXPECT_EQ(expected[index]->opcode, instr.opcode());
+    ++index;
+  }
+  EXPECT_EQ(expected.size(), index);
+}
+
+TEST(BinaryPackedInstructionStreamTest, RandomAccess) {
+  TestErrors errors;
+  Context context{errors};
+  context.features.EnableAll();
+  auto stream = ReadPackedInstructionStream(kExpr, context);
+
+  EXPECT_EQ(Opcode::End, stream[17].opcode());
+  EXPECT_EQ(Opcode::I32Const, stream[1].opcode());
+  EXPECT_EQ(Opcode::Block, stream[0].opcode());
+  EXPECT_EQ((At{"\x41\x05"_su8, Instruction{At{"\x41"_su8, Opcode::I32Const},
+                                            At{"\x05"_su8, s32{5}}}}),
+            stream[1].ToInstruction());
+}
+
+TEST(BinaryPackedInstructionStreamTest, Immediates) {
+  TestErrors errors;
+  Context context{errors};
+  context.features.EnableAll();
+
+  std::vector<At<Instruction>> expected;
+  for (const auto& instr : ReadExpression(kExpr, context)) {
+    expected.push_back(instr);
+  }
+  auto stream = ReadPackedInstructionStream(kExpr, context);
+  ASSERT_EQ(expected.size(), stream.size());
+  ExpectNoErrors(errors);
+
+  for (Index i = 0; i < stream.size(); ++i) {
+    EXPECT_EQ(expected[i].loc(), stream[i].data());
+    EXPECT_EQ(expected[i]->immediate.index(), stream[i].immediate_kind());
+    EXPECT_EQ(expected[i]->has_no_immediate(), stream[i].has_no_immediate());
+    EXPECT_EQ(expected[i]->has_br_table_immediate(),
+              stream[i].has_br_table_immediate());
+  }
+
+  EXPECT_EQ(expected[0]->block_type_immediate(),
+            stream[0].block_type_immediate());
+  EXPECT_EQ(expected[1]->s32_immediate(), stream[1].s32_immediate());
+  EXPECT_EQ(expected[2]->br_table_immediate(), stream[2].br_table_immediate());
+  EXPECT_EQ(expected[4]->s64_immediate(), stream[4].s64_immediate());
+  EXPECT_EQ(expected[5]->f32_immediate(), stream[5].f32_immediate());
+  EXPECT_EQ(expected[6]->f64_immediate(), stream[6].f64_immediate());
+  EXPECT_EQ(expected[7]->mem_arg_immediate(), stream[7].mem_arg_immediate());
+  EXPECT_EQ(expected[8]->call_indirect_immediate(),
+            stream[8].call_indirect_immediate());
+  EXPECT_EQ(expected[9]->select_immediate(), stream[9].select_immediate());
+  EXPECT_EQ(expected[10]->let_immediate(), stream[10].let_immediate());
+  EXPECT_EQ(expected[11]->v128_immediate(), stream[11].v128_immediate());
+  EXPECT_EQ(expected[12]->shuffle_immediate(), stream[12].shuffle_immediate());
+  EXPECT_EQ(expected[13]->simd_lane_immediate(),
+            stream[13].simd_lane_immediate());
+  EXPECT_EQ(expected[14]->heap_type_2_immediate(),
+            stream[14].heap_type_2_immediate());
+  EXPECT_EQ(expected[15]->copy_immediate(), stream[15].copy_immediate());
+  EXPECT_EQ(expected[16]->heap_type_immediate(),
+            stream[16].heap_type_immediate());
+}
+
+TEST(BinaryPackedInstructionStreamTest, BrTableTargets) {
+  TestErrors errors;
+  Context context{errors};
+  auto stream = ReadPackedInstructionStream(
+      "\x0e\x03\x02\x01\x00\x04"  // br_table 2 1 0 4
+      "\x0e\x00\x05"_su8,         // br_table 5
+      context);
+  ASSERT_EQ(2u, stream.size());
+
+  auto instr = stream[0];
+  ASSERT_TRUE(instr.has_br_table_immediate());
+  auto targets = instr.br_table_targets();
+  EXPECT_EQ((std::vector<Index>{2, 1, 0}),
+            std::vector<Index>(targets.begin(), targets.end()));
+  EXPECT_EQ((At{"\x04"_su8, Index{4}}), instr.br_table_default_target());
+
+  EXPECT_TRUE(stream[1].br_table_targets().empty());
+  EXPECT_EQ((At{"\x05"_su8, Index{5}}), stream[1].br_table_default_target());
+  ExpectNoErrors(errors);
+}
+
+TEST(BinaryPackedInstructionStreamTest, AppendWithoutLocations) {
+  PackedInstructionStream stream;
+  std::vector<At<Instruction>> instrs = {
+      Instruction{Opcode::Nop},
+      Instruction{Opcode::I32Const, s32{-5}},
+      Instruction{Opcode::I64Const, s64{-5}},
+      Instruction{Opcode::F64Const, f64{1.5}},
+      Instruction{Opcode::LocalGet, Index{3}},
+      Instruction{At{Opcode::Block}, At{BlockType{At{ValueType::I32_NoLocation()}}}},
+      Instruction{At{Opcode::BrTable},
+                  At{BrTableImmediate{{At{Index{1}}, At{Index{2}}},
+                                      At{Index{0}}}}},
+      Instruction{At{Opcode::SelectT}, At{SelectImmediate{At{ValueType::I32_NoLocation()},
+                                            At{ValueType::Funcref_NoLocation()}}}},
+      Instruction{At{Opcode::RefNull}, At{HeapType{At{HeapKind::Func}}}},
+      Instruction{
+          At{Opcode::BrOnCast},
+          At{BrOnCastImmediate{At{Index{1}},
+                               HeapType2Immediate{At{HeapType{At{Index{0}}}},
+                                                  At{HeapType{At{HeapKind::Extern}}}}}}},
+      Instruction{At{Opcode::RttSub},
+                  At{RttSubImmediate{At{Index{2}},
+                                     HeapType2Immediate{At{HeapType{At{HeapKind::Any}}},
+                                                At{HeapType{At{Index{1}}}}}}}},
+      Instruction{At{Opcode::StructGet},
+                  At{StructFieldImmediate{At{Index{1}}, At{Index{2}}}}},
+      Instruction{At{Opcode::V128Const}, At{v128{u32{1}, u32{2}, u32{3}, u32{4}}}},
+  };
+  for (const auto& instr : instrs) {
+    stream.Append(instr);
+  }
+
+  ASSERT_EQ(instrs.size(), stream.size());
+  for (Index i = 0; i < stream.size(); ++i) {
+    EXPECT_EQ(instrs[i], stream[i].ToInstruction());
+    EXPECT_EQ(Location{}, stream[i].loc());
+  }
+
+  stream.clear();
+  EXPECT_TRUE(stream.empty());
+  EXPECT_EQ(stream.begin(), stream.end());
+}
+
+TEST(BinaryPackedInstructionStreamTest, MalformedVectorImmediate) {
+  const SpanU8 kExprs[] = {
+      "\x01\x0e\x02\x00"_su8,          // nop; br_table 0 <missing>
+      "\x01\x0e\x01\x00"_su8,          // nop; br_table 0 (no default)
+      "\x01\x1c\x02\x7f"_su8,          // nop; select (result i32 <missing>)
+      "\x01\x17\x40\x01\x02"_su8,      // nop; let (local <missing>)
+      "\x01\x17\x40\x01\x02\x00"_su8,  // nop; let (local <bad type>)
+  };
+
+  for (auto expr : kExprs) {
+    TestErrors full_errors;
+    Context full_context{full_errors};
+    full_context.features.EnableAll();
+    for (const auto& instr : ReadExpression(expr, full_context)) {
+      (void)instr;
+    }
+
+    TestErrors errors;
+    Context context{errors};
+    context.features.EnableAll();
+    auto stream = ReadPackedInstructionStream(expr, context);
+
+    // The partly-read instruction is not left in the stream.
+    ASSERT_EQ(1u, stream.size());
+    EXPECT_EQ(Opcode::Nop, stream[0].opcode());
+    EXPECT_FALSE(full_errors.errors.empty());
+    ExpectErrors(full_errors.errors, errors);
+  }
+}
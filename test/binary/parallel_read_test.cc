@@ -0,0 +1,145 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/binary/parallel_read.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "test/binary/test_utils.h"
+#include "test/test_utils.h"
+#include "wasp/base/thread_pool.h"
+#include "wasp/binary/code_section_index.h"
+#include "wasp/binary/lazy_expression.h"
+#include "wasp/binary/read.h"
+#include "wasp/binary/read/context.h"
+#include "wasp/binary/sections.h"
+
+using namespace ::wasp;
+using namespace ::wasp::binary;
+using namespace ::wasp::binary::test;
+using namespace ::wasp::test;
+
+namespace {
+
+// Creates a code section with `count` bodies. Each body is `i32.const i`,
+// except for the ones in `bad`, which are missing the final `end`.
+std::vector<u8> MakeCodeSection(u8 count, const std::vector<u8>& bad) {
+  std::vector<u8> data{count};
+  for (u8 i = 0; i < count; ++i) {
+    if (std::find(bad.begin(), bad.end(), i) != bad.end()) {
+      data.insert(data.end(), {0x02, 0x00, 0x00});  // unreachable
+    } else {
+      data.insert(data.end(), {0x04, 0x00, 0x41, u8(i & 0x3f), 0x0b});
+    }
+  }
+  return data;
+}
+
+}  // namespace
+
+TEST(BinaryParallelReadTest, Basic) {
+  auto data = MakeCodeSection(3, {});
+  TestErrors errors;
+  Context context{errors};
+  auto index = ReadCodeSectionIndex(SpanU8{data}, context, 2);
+  ThreadPool pool{2};
+  auto bodies = ReadFunctionBodiesParallel(index, context, pool);
+
+  ASSERT_EQ(3u, bodies.size());
+  for (Index i = 0; i < 3; ++i) {
+    EXPECT_EQ(i + 2, bodies[i].index);
+    EXPECT_TRUE(bodies[i].ok);
+    ASSERT_EQ(2u, bodies[i].instructions.size());
+    const auto& instrs = bodies[i].instructions;
+    EXPECT_EQ(Opcode::I32Const, *instrs[0]->opcode);
+    EXPECT_EQ(s32(i), *instrs[0]->s32_immediate());
+    EXPECT_EQ(Opcode::End, *instrs[1]->opcode);
+  }
+  EXPECT_EQ(3u, context.code_count);
+  ExpectNoErrors(errors);
+}
+
+TEST(BinaryParallelReadTest, DataCount) {
+  // A body with `data.drop 0`.
+  auto data = "\x01\x05\x00\xfc\x09\x00\x0b"_su8;
+  TestErrors errors;
+  Features features;
+  features.enable_bulk_memory();
+  Context context{features, errors};
+  context.declared_data_count = 1;
+  auto index = ReadCodeSectionIndex(data, context);
+  ThreadPool pool{2};
+  auto bodies = ReadFunctionBodiesParallel(index, context, pool);
+
+  ASSERT_EQ(1u, bodies.size());
+  EXPECT_TRUE(bodies[0].ok);
+  ASSERT_EQ(2u, bodies[0].instructions.size());
+  EXPECT_EQ(Opcode::DataDrop, *bodies[0].instructions[0]->opcode);
+  EXPECT_EQ(Opcode::End, *bodies[0].instructions[1]->opcode);
+  ExpectNoErrors(errors);
+}
+
+TEST(BinaryParallelReadTest, Empty) {
+  TestErrors errors;
+  Context context{errors};
+  auto index = ReadCodeSectionIndex("\x00"_su8, context);
+  ThreadPool pool{2};
+  EXPECT_TRUE(ReadFunctionBodiesParallel(index, context, pool).empty());
+  ExpectNoErrors(errors);
+}
+
+TEST(BinaryParallelReadTest, MatchesSequential) {
+  const std::vector<u8> bad{5, 37, 38, 99};
+  auto data = MakeCodeSection(100, bad);
+
+  // Read sequentially, as visit::Visit does.
+  TestErrors expected_errors;
+  std::vector<InstructionList> expected;
+  {
+    Context context{expected_errors};
+    auto sec = ReadCodeSection(SpanU8{data}, context);
+    for (const auto& code : sec.sequence) {
+      InstructionList instrs;
+      for (auto&& instr : ReadExpression(*code->body, context)) {
+        instrs.push_back(instr);
+      }
+      EndCode(code->body->data.last(0), context);
+      expected.push_back(instrs);
+    }
+  }
+
+  TestErrors errors;
+  Context context{errors};
+  auto index = ReadCodeSectionIndex(SpanU8{data}, context);
+  ThreadPool pool{4};
+  Index next = 0;
+  ForEachFunctionBodyParallel(index, context, pool, [&](FunctionBody& body) {
+    ASSERT_EQ(next, body.index);
+    ASSERT_LT(next, expected.size());
+    EXPECT_EQ(expected[next], body.instructions);
+    bool is_bad = std::find(bad.begin(), bad.end(), next) != bad.end();
+    EXPECT_EQ(!is_bad, body.ok);
+    ++next;
+  });
+
+  EXPECT_EQ(100u, next);
+  EXPECT_EQ(100u, context.code_count);
+  EXPECT_EQ(bad.size(), errors.errors.size());
+  ExpectErrors(expected_errors.errors, errors);
+}
@@ -28,6 +28,7 @@
 #include "wasp/binary/read/context.h"
 #include "wasp/binary/read/read_vector.h"
 
+#include "wasp/base/at.h"
 #include "wasp/base/concat.h"
 
 using namespace ::wasp;
@@ -50,6 +51,22 @@ class BinaryReadTest : public ::testing::Test {
     EXPECT_EQ(expected, **actual);
   }
 
+  // Like OK, but with extra bytes following `data`, so readers that look ahead
+  // (e.g. ReadVarInt) can take their fast path.
+  template <typename Func, typename T>
+  void OKWithTrailingBytes(Func&& func, const T& expected, SpanU8 data) {
+    std::vector<u8> buffer{data.begin(), data.end()};
+    buffer.resize(buffer.size() + 8, 0xff);
+    SpanU8 copy{buffer};
+    LocationBase location_base{copy};
+    auto actual = func(&copy, context);
+    ExpectNoErrors(errors);
+    EXPECT_EQ(8u, copy.size());
+    ASSERT_TRUE(actual.has_value());
+    EXPECT_EQ(data.size(), actual->loc().size());
+    EXPECT_EQ(expected, **actual);
+  }
+
   template <typename Func, typename... Args>
   void Fail(Func&& func,
             const ExpectedError& error,
@@ -64,6 +81,7 @@ class BinaryReadTest : public ::testing::Test {
 
   void FailUnknownOpcode(u8 code) {
     const u8 span_buffer[] = {code};
+    LocationBase location_base{span_buffer};
     auto msg = concat("Unknown opcode: ", code);
     Fail(Read<Opcode>, {{0, "opcode"}, {0, msg}}, SpanU8{span_buffer, 1});
   }
@@ -77,6 +95,7 @@ class BinaryReadTest : public ::testing::Test {
       code >>= 7;
     } while (code > 0);
 
+    LocationBase location_base{data};
     Fail(Read<Opcode>,
          {{0, "opcode"},
           {0, concat("Unknown opcode: ", prefix, " ", orig_code)}},
@@ -2905,6 +2924,8 @@ TEST_F(BinaryReadTest, Opcode_Unknown_misc_prefix) {
 
   // Test some longer codes too.
   FailUnknownOpcode(0xfc, 128);
+  FailUnknownOpcode(0xfc, 256);
+  FailUnknownOpcode(0xfc, 256 + 0x08);  // memory.init, if truncated to a u8.
   FailUnknownOpcode(0xfc, 16384);
   FailUnknownOpcode(0xfc, 2097152);
   FailUnknownOpcode(0xfc, 268435456);
@@ -3272,6 +3293,19 @@ TEST_F(BinaryReadTest, S32) {
   OK(Read<s32>, -837011344, "\xf0\xf0\xf0\xf0\x7c"_su8);
 }
 
+TEST_F(BinaryReadTest, S32_TrailingBytes) {
+  OKWithTrailingBytes(Read<s32>, 32, "\x20"_su8);
+  OKWithTrailingBytes(Read<s32>, -16, "\x70"_su8);
+  OKWithTrailingBytes(Read<s32>, 448, "\xc0\x03"_su8);
+  OKWithTrailingBytes(Read<s32>, -3648, "\xc0\x63"_su8);
+  OKWithTrailingBytes(Read<s32>, 33360, "\xd0\x84\x02"_su8);
+  OKWithTrailingBytes(Read<s32>, -753072, "\xd0\x84\x52"_su8);
+  OKWithTrailingBytes(Read<s32>, 101718048, "\xa0\xb0\xc0\x30"_su8);
+  OKWithTrailingBytes(Read<s32>, -32499680, "\xa0\xb0\xc0\x70"_su8);
+  OKWithTrailingBytes(Read<s32>, 1042036848, "\xf0\xf0\xf0\xf0\x03"_su8);
+  OKWithTrailingBytes(Read<s32>, -837011344, "\xf0\xf0\xf0\xf0\x7c"_su8);
+}
+
 TEST_F(BinaryReadTest, S32_TooLong) {
   Fail(Read<s32>,
        {{0, "s32"},
@@ -3285,6 +3319,30 @@ TEST_F(BinaryReadTest, S32_TooLong) {
          "Last byte of s32 must be sign extension: expected "
          "0x3 or 0x7b, got 0x73"}},
        "\xff\xff\xff\xff\x73"_su8);
+  Fail(Read<s32>,
+       {{0, "s32"},
+        {4,
+         "Last byte of s32 must be sign extension: expected "
+         "0x3 or 0x7b, got 0x73"}},
+       "\xff\xff\xff\xff\x73\x00\x00\x00"_su8);
+  Fail(Read<s32>,
+       {{0, "s32"},
+        {4,
+         "Last byte of s32 must be sign extension: expected "
+         "0x7 or 0x7f, got 0xff"}},
+       "\xff\xff\xff\xff\xff\xff\x00\x00"_su8);
+}
+
+TEST_F(BinaryReadTest, S32_TooLong_NoContext) {
+  TestErrors errors{false};
+  Context context{errors};
+  SpanU8 data = "\xf0\xf0\xf0\xf0\x15"_su8;
+  SpanU8 copy = data;
+  EXPECT_EQ(nullopt, Read<s32>(&copy, context));
+  ExpectError({{4,
+                "Last byte of s32 must be sign extension: expected "
+                "0x5 or 0x7d, got 0x15"}},
+              errors, data);
 }
 
 TEST_F(BinaryReadTest, S32_PastEnd) {
@@ -3321,6 +3379,27 @@ TEST_F(BinaryReadTest, S64) {
      "\xfe\xed\xfe\xed\xfe\xed\xfe\xed\x4e"_su8);
 }
 
+TEST_F(BinaryReadTest, S64_TrailingBytes) {
+  OKWithTrailingBytes(Read<s64>, 32, "\x20"_su8);
+  OKWithTrailingBytes(Read<s64>, -16, "\x70"_su8);
+  OKWithTrailingBytes(Read<s64>, -3648, "\xc0\x63"_su8);
+  OKWithTrailingBytes(Read<s64>, -753072, "\xd0\x84\x52"_su8);
+  OKWithTrailingBytes(Read<s64>, -837011344, "\xf0\xf0\xf0\xf0\x7c"_su8);
+  OKWithTrailingBytes(Read<s64>, 13893120096, "\xe0\xe0\xe0\xe0\x33"_su8);
+  OKWithTrailingBytes(Read<s64>, -287593715632,
+                      "\xd0\xd0\xd0\xd0\xd0\x77"_su8);
+  OKWithTrailingBytes(Read<s64>, 139105536057408,
+                      "\xc0\xc0\xc0\xc0\xc0\xd0\x1f"_su8);
+  OKWithTrailingBytes(Read<s64>, 1338117014066474,
+                      "\xaa\xaa\xaa\xaa\xaa\xa0\xb0\x02"_su8);
+  OKWithTrailingBytes(Read<s64>, -12172681868045014,
+                      "\xaa\xaa\xaa\xaa\xaa\xa0\xb0\x6a"_su8);
+  OKWithTrailingBytes(Read<s64>, 1070725794579330814,
+                      "\xfe\xed\xfe\xed\xfe\xed\xfe\xed\x0e"_su8);
+  OKWithTrailingBytes(Read<s64>, -3540960223848057090,
+                      "\xfe\xed\xfe\xed\xfe\xed\xfe\xed\x4e"_su8);
+}
+
 TEST_F(BinaryReadTest, S64_TooLong) {
   Fail(Read<s64>,
        {{0, "s64"},
@@ -3590,11 +3669,28 @@ TEST_F(BinaryReadTest, U32) {
   OK(Read<u32>, 1042036848u, "\xf0\xf0\xf0\xf0\x03"_su8);
 }
 
+TEST_F(BinaryReadTest, U32_TrailingBytes) {
+  OKWithTrailingBytes(Read<u32>, 32u, "\x20"_su8);
+  OKWithTrailingBytes(Read<u32>, 448u, "\xc0\x03"_su8);
+  OKWithTrailingBytes(Read<u32>, 33360u, "\xd0\x84\x02"_su8);
+  OKWithTrailingBytes(Read<u32>, 101718048u, "\xa0\xb0\xc0\x30"_su8);
+  OKWithTrailingBytes(Read<u32>, 1042036848u, "\xf0\xf0\xf0\xf0\x03"_su8);
+  OKWithTrailingBytes(Read<u32>, 0xffffffffu, "\xff\xff\xff\xff\x0f"_su8);
+}
+
 TEST_F(BinaryReadTest, U32_TooLong) {
   Fail(Read<u32>,
        {{0, "u32"},
         {4, "Last byte of u32 must be zero extension: expected 0x2, got 0x12"}},
        "\xf0\xf0\xf0\xf0\x12"_su8);
+  Fail(Read<u32>,
+       {{0, "u32"},
+        {4, "Last byte of u32 must be zero extension: expected 0x2, got 0x12"}},
+       "\xf0\xf0\xf0\xf0\x12\x00\x00\x00"_su8);
+  Fail(Read<u32>,
+       {{0, "u32"},
+        {4, "Last byte of u32 must be zero extension: expected 0x0, got 0x80"}},
+       "\x80\x80\x80\x80\x80\x00\x00\x00"_su8);
 }
 
 TEST_F(BinaryReadTest, U32_PastEnd) {
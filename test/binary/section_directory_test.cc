@@ -0,0 +1,100 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/binary/section_directory.h"
+
+#include "gtest/gtest.h"
+#include "test/test_utils.h"
+#include "wasp/base/features.h"
+#include "wasp/binary/lazy_module.h"
+
+using namespace ::wasp;
+using namespace ::wasp::binary;
+using namespace ::wasp::test;
+
+namespace {
+
+const SpanU8 kModule =
+    "\0asm\x01\0\0\0"_su8
+    "\x00\x06\x05\x61\x62\x63\x64\x65"_su8  // Custom section "abcde".
+    "\x01\x04\x01\x60\x00\x00"_su8          // Type section.
+    "\x03\x02\x01\x00"_su8                  // Function section.
+    "\x0a\x04\x01\x02\x00\x0b"_su8          // Code section.
+    "\x00\x0c\x0areloc.CODE\x00"_su8        // Custom section "reloc.CODE".
+    "\x00\x05\x04name"_su8                  // Custom section "name".
+    "\x00\x0c\x0areloc.DATA\x00"_su8;       // Custom section "reloc.DATA".
+
+}  // namespace
+
+TEST(BinarySectionDirectoryTest, Sections) {
+  TestErrors errors;
+  auto module = ReadModule(kModule, Features{}, errors);
+  SectionDirectory directory{module};
+
+  ASSERT_EQ(7u, directory.size());
+  EXPECT_TRUE(directory.sections()[0]->is_custom());
+  EXPECT_EQ(SectionId::Type, directory.sections()[1]->known()->id);
+  EXPECT_EQ(SectionId::Code, directory.sections()[3]->known()->id);
+  ExpectNoErrors(errors);
+}
+
+TEST(BinarySectionDirectoryTest, Find) {
+  TestErrors errors;
+  auto module = ReadModule(kModule, Features{}, errors);
+  SectionDirectory directory{module};
+
+  EXPECT_EQ(Index{1}, directory.FindIndex(SectionId::Type));
+  EXPECT_EQ(Index{3}, directory.FindIndex(SectionId::Code));
+  EXPECT_EQ(nullopt, directory.FindIndex(SectionId::Import));
+
+  auto code = directory.Find(SectionId::Code);
+  ASSERT_TRUE(code.has_value());
+  EXPECT_EQ("\x01\x02\x00\x0b"_su8, code->value().data);
+  EXPECT_EQ(nullopt, directory.Find(SectionId::Data));
+  ExpectNoErrors(errors);
+}
+
+TEST(BinarySectionDirectoryTest, FindCustom) {
+  TestErrors errors;
+  auto module = ReadModule(kModule, Features{}, errors);
+  SectionDirectory directory{module};
+
+  EXPECT_EQ(Index{5}, directory.FindCustomIndex("name"));
+  EXPECT_EQ(Index{0}, directory.FindCustomIndex("abcde"));
+  EXPECT_EQ(nullopt, directory.FindCustomIndex("linking"));
+  EXPECT_EQ(nullopt, directory.FindCustomIndex("abc"));
+
+  auto custom = directory.FindCustom("abcde");
+  ASSERT_TRUE(custom.has_value());
+  EXPECT_TRUE(custom->value().data.empty());
+  ExpectNoErrors(errors);
+}
+
+TEST(BinarySectionDirectoryTest, FindAllCustom) {
+  TestErrors errors;
+  auto module = ReadModule(kModule, Features{}, errors);
+  SectionDirectory directory{module};
+
+  auto relocs = directory.FindAllCustom("reloc.");
+  ASSERT_EQ(2u, relocs.size());
+  EXPECT_EQ("reloc.CODE", relocs[0]->name.value());
+  EXPECT_EQ("reloc.DATA", relocs[1]->name.value());
+
+  EXPECT_EQ(4u, directory.FindAllCustom("").size());
+  EXPECT_TRUE(directory.FindAllCustom(".debug_").empty());
+  ExpectNoErrors(errors);
+}
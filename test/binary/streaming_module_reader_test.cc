@@ -0,0 +1,181 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/binary/streaming_module_reader.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "test/test_utils.h"
+#include "wasp/base/concat.h"
+#include "wasp/base/features.h"
+#include "wasp/binary/formatters.h"
+#include "wasp/binary/lazy_module.h"
+#include "wasp/binary/visitor.h"
+
+using namespace ::wasp;
+using namespace ::wasp::binary;
+using namespace ::wasp::test;
+
+namespace {
+
+// (module
+//   (type (;0;) (func (param i32) (result i32)))
+//   (type (;1;) (func (param f32) (result f32)))
+//   (type (;2;) (func))
+//   (import "foo" "bar" (func (;0;) (type 0)))
+//   (func (;1;) (type 1) (param f32) (result f32)
+//     (f32.const 0x1.5p+5 (;=42;)))
+//   (func (;2;) (type 2))
+//   (table (;0;) 1 2 funcref)
+//   (memory (;0;) 1)
+//   (global (;0;) i32 (i32.const 1))
+//   (export "quux" (func 1))
+//   (start 2)
+//   (elem (;0;) (i32.const 0) 0 1)
+//   (data (;0;) (i32.const 2) "hello"))
+//
+// followed by a custom section named "abc".
+const u8 kTestModule[] = {
+    0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x01, 0x0e, 0x03, 0x60,
+    0x01, 0x7f, 0x01, 0x7f, 0x60, 0x01, 0x7d, 0x01, 0x7d, 0x60, 0x00, 0x00,
+    0x02, 0x0b, 0x01, 0x03, 0x66, 0x6f, 0x6f, 0x03, 0x62, 0x61, 0x72, 0x00,
+    0x00, 0x03, 0x03, 0x02, 0x01, 0x02, 0x04, 0x05, 0x01, 0x70, 0x01, 0x01,
+    0x02, 0x05, 0x03, 0x01, 0x00, 0x01, 0x06, 0x06, 0x01, 0x7f, 0x00, 0x41,
+    0x01, 0x0b, 0x07, 0x08, 0x01, 0x04, 0x71, 0x75, 0x75, 0x78, 0x00, 0x01,
+    0x08, 0x01, 0x02, 0x09, 0x08, 0x01, 0x00, 0x41, 0x00, 0x0b, 0x02, 0x00,
+    0x01, 0x0a, 0x0c, 0x02, 0x07, 0x00, 0x43, 0x00, 0x00, 0x28, 0x42, 0x0b,
+    0x02, 0x00, 0x0b, 0x0b, 0x0b, 0x01, 0x00, 0x41, 0x02, 0x0b, 0x05, 0x68,
+    0x65, 0x6c, 0x6c, 0x6f, 0x00, 0x04, 0x03, 0x61, 0x62, 0x63,
+};
+
+// Records the callbacks, ignoring locations.
+struct RecordingVisitor : visit::Visitor {
+  using Result = visit::Result;
+
+  Result BeginModule(const LazyModule&) { return Add("BeginModule"); }
+  Result EndModule(const LazyModule&) { return Add("EndModule"); }
+  Result OnSection(At<Section> section) {
+    if (section->is_known()) {
+      return Add(concat("OnSection ", section->known()->id));
+    }
+    return Add(concat("OnSection ", section->custom()->name));
+  }
+  Result OnType(const At<DefinedType>& x) { return Add(concat(*x)); }
+  Result OnImport(const At<Import>& x) { return Add(concat(*x)); }
+  Result OnFunction(const At<Function>& x) { return Add(concat(*x)); }
+  Result OnTable(const At<Table>& x) { return Add(concat(*x)); }
+  Result OnMemory(const At<Memory>& x) { return Add(concat(*x)); }
+  Result OnGlobal(const At<Global>& x) { return Add(concat(*x)); }
+  Result OnExport(const At<Export>& x) { return Add(concat(*x)); }
+  Result OnStart(const At<Start>& x) { return Add(concat(*x)); }
+  Result OnElement(const At<ElementSegment>& x) { return Add(concat(*x)); }
+  Result BeginCodeSection(LazyCodeSection sec) {
+    Add(concat("BeginCodeSection ", sec.count));
+    return skip_code ? Result::Skip : Result::Ok;
+  }
+  Result BeginCode(const At<Code>& x) { return Add(concat("BeginCode ", *x)); }
+  Result OnInstruction(const At<Instruction>& x) { return Add(concat(*x)); }
+  Result EndCode(const At<Code>&) { return Add("EndCode"); }
+  Result EndCodeSection(LazyCodeSection) { return Add("EndCodeSection"); }
+  Result OnData(const At<DataSegment>& x) { return Add(concat(*x)); }
+
+  Result Add(std::string event) {
+    events.push_back(event);
+    return Result::Ok;
+  }
+
+  bool skip_code = false;
+  std::vector<std::string> events;
+};
+
+std::vector<std::string> VisitWhole(SpanU8 data, bool skip_code = false) {
+  TestErrors errors;
+  RecordingVisitor visitor;
+  visitor.skip_code = skip_code;
+  auto module = ReadModule(data, Features{}, errors);
+  EXPECT_EQ(visit::Result::Ok, visit::Visit(module, visitor));
+  ExpectNoErrors(errors);
+  return visitor.events;
+}
+
+}  // namespace
+
+TEST(BinaryStreamingModuleReaderTest, MatchesVisit) {
+  SpanU8 data{kTestModule};
+  auto expected = VisitWhole(data);
+
+  for (size_t chunk_size : {1, 2, 3, 5, 8, 13, 64, 1000}) {
+    TestErrors errors;
+    RecordingVisitor visitor;
+    StreamingModuleReader<RecordingVisitor> reader{visitor, Features{},
+                                                   errors};
+    for (size_t i = 0; i < data.size(); i += chunk_size) {
+      auto chunk = data.subspan(i, std::min(chunk_size, data.size() - i));
+      EXPECT_EQ(visit::Result::Ok, reader.Push(chunk));
+    }
+    EXPECT_FALSE(reader.done());
+    EXPECT_EQ(visit::Result::Ok, reader.Finish());
+    EXPECT_TRUE(reader.done());
+
+    EXPECT_EQ(expected, visitor.events) << "chunk size: " << chunk_size;
+    ExpectNoErrors(errors);
+  }
+}
+
+TEST(BinaryStreamingModuleReaderTest, SkipCodeSection) {
+  SpanU8 data{kTestModule};
+  auto expected = VisitWhole(data, true);
+
+  TestErrors errors;
+  RecordingVisitor visitor;
+  visitor.skip_code = true;
+  StreamingModuleReader<RecordingVisitor> reader{visitor, Features{}, errors};
+  for (size_t i = 0; i < data.size(); ++i) {
+    EXPECT_EQ(visit::Result::Ok, reader.Push(data.subspan(i, 1)));
+  }
+  EXPECT_EQ(visit::Result::Ok, reader.Finish());
+
+  EXPECT_EQ(expected, visitor.events);
+  ExpectNoErrors(errors);
+}
+
+TEST(BinaryStreamingModuleReaderTest, Truncated) {
+  SpanU8 data{kTestModule};
+  // Cut the module off in the middle of each section.
+  for (size_t size : {4, 12, 40, 90, 95, 100, 110}) {
+    TestErrors errors;
+    RecordingVisitor visitor;
+    StreamingModuleReader<RecordingVisitor> reader{visitor, Features{},
+                                                   errors};
+    EXPECT_EQ(visit::Result::Ok, reader.Push(data.first(size)));
+    EXPECT_EQ(visit::Result::Fail, reader.Finish()) << "size: " << size;
+    EXPECT_FALSE(errors.errors.empty()) << "size: " << size;
+    EXPECT_EQ(visit::Result::Fail, reader.Push(data.subspan(size)));
+  }
+}
+
+TEST(BinaryStreamingModuleReaderTest, BadMagic) {
+  TestErrors errors;
+  RecordingVisitor visitor;
+  StreamingModuleReader<RecordingVisitor> reader{visitor, Features{}, errors};
+  // Like visit::Visit, a mismatched magic is reported but does not stop
+  // reading.
+  reader.Push("\0ASM\1\0\0\0"_su8);
+  EXPECT_EQ(1u, errors.errors.size());
+}
@@ -21,8 +21,10 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "test/test_utils.h"
+#include "wasp/base/concat.h"
 #include "wasp/base/features.h"
 #include "wasp/binary/lazy_module.h"
+#include "wasp/binary/read/context.h"
 
 using namespace ::wasp;
 using namespace ::wasp::binary;
@@ -282,3 +284,194 @@ TEST_F(BinaryVisitorTest, OkSkipFail) {
 
   EXPECT_EQ(Result::Fail, Visit(v));
 }
+
+namespace {
+
+struct ExportVisitor : visit::Visitor {
+  visit::Result OnExport(const At<Export>&) {
+    export_count++;
+    return visit::Result::Ok;
+  }
+
+  visit::Result BeginCode(const At<Code>&) {
+    code_count++;
+    return visit::Result::Ok;
+  }
+
+  int export_count = 0;
+  int code_count = 0;
+};
+
+struct DecodeAllExportVisitor : visit::DecodeAllVisitor {
+  visit::Result OnExport(const At<Export>&) { return visit::Result::Ok; }
+};
+
+using ExportInterest = visit::VisitorInterest<ExportVisitor>;
+static_assert(ExportInterest::Export);
+static_assert(ExportInterest::Code);
+static_assert(!ExportInterest::Instruction);
+static_assert(!ExportInterest::Import);
+static_assert(!ExportInterest::Data);
+
+using SkipInterest = visit::VisitorInterest<visit::SkipVisitor>;
+static_assert(!SkipInterest::Type);
+static_assert(!SkipInterest::Code);
+
+using MockInterest = visit::VisitorInterest<VisitorMock>;
+static_assert(MockInterest::Import);
+static_assert(MockInterest::Instruction);
+
+using DecodeAllInterest = visit::VisitorInterest<DecodeAllExportVisitor>;
+static_assert(DecodeAllInterest::Import);
+static_assert(DecodeAllInterest::Instruction);
+
+}  // namespace
+
+TEST_F(BinaryVisitorTest, UnobservedSectionsAreSkipped) {
+  ExportVisitor visitor;
+  EXPECT_EQ(visit::Result::Ok, Visit(visitor));
+  EXPECT_EQ(1, visitor.export_count);
+  EXPECT_EQ(kFunctionCount, visitor.code_count);
+  // The function, code and data counts still match.
+  ExpectNoErrors(errors);
+}
+
+TEST_F(BinaryVisitorTest, UnobservedSectionsAreNotDecoded) {
+  std::vector<u8> data(std::begin(kTestModule), std::end(kTestModule));
+  // Make the import kind invalid.
+  ASSERT_EQ(0x00, data[35]);
+  data[35] = 0x7f;
+
+  {
+    ExportVisitor visitor;
+    LazyModule module = ReadModule(SpanU8{data}, features, errors);
+    EXPECT_EQ(visit::Result::Ok, visit::Visit(module, visitor));
+    ExpectNoErrors(errors);
+  }
+
+  {
+    DecodeAllExportVisitor visitor;
+    LazyModule module = ReadModule(SpanU8{data}, features, errors);
+    EXPECT_EQ(visit::Result::Ok, visit::Visit(module, visitor));
+    EXPECT_FALSE(errors.errors.empty());
+  }
+}
+
+namespace {
+
+struct BatchVisitor : visit::Visitor {
+  visit::Result OnInstructions(span<const At<Instruction>> instrs) {
+    batch_sizes.push_back(instrs.size());
+    for (const auto& instr : instrs) {
+      opcodes.push_back(instr->opcode);
+    }
+    return fail ? visit::Result::Fail : visit::Result::Ok;
+  }
+
+  visit::Result EndCode(const At<Code>&) {
+    end_code_count++;
+    return visit::Result::Ok;
+  }
+
+  bool fail = false;
+  std::vector<size_t> batch_sizes;
+  std::vector<Opcode> opcodes;
+  int end_code_count = 0;
+};
+
+// Reports an error for each batch, so the order relative to read errors can be
+// checked.
+struct ReportingBatchVisitor : visit::Visitor {
+  explicit ReportingBatchVisitor(Errors& errors) : errors{errors} {}
+
+  visit::Result OnInstructions(span<const At<Instruction>> instrs) {
+    errors.OnError(Location{}, concat("visited ", instrs.size()));
+    return fail ? visit::Result::Fail : visit::Result::Ok;
+  }
+
+  Errors& errors;
+  bool fail = false;
+};
+
+static_assert(visit::VisitorInterest<BatchVisitor>::Instructions);
+static_assert(visit::VisitorInterest<BatchVisitor>::Instruction);
+static_assert(!visit::VisitorInterest<ExportVisitor>::Instructions);
+
+}  // namespace
+
+TEST_F(BinaryVisitorTest, OnInstructions) {
+  BatchVisitor visitor;
+  EXPECT_EQ(visit::Result::Ok, Visit(visitor));
+  // One batch per function body.
+  EXPECT_EQ((std::vector<size_t>{2, 1}), visitor.batch_sizes);
+  EXPECT_EQ((std::vector<Opcode>{Opcode::F32Const, Opcode::End, Opcode::End}),
+            visitor.opcodes);
+  EXPECT_EQ(kFunctionCount, visitor.end_code_count);
+  ExpectNoErrors(errors);
+}
+
+TEST_F(BinaryVisitorTest, OnInstructionsFailed) {
+  BatchVisitor visitor;
+  visitor.fail = true;
+  EXPECT_EQ(visit::Result::Fail, Visit(visitor));
+  EXPECT_EQ((std::vector<size_t>{2}), visitor.batch_sizes);
+  EXPECT_EQ(0, visitor.end_code_count);
+}
+
+TEST_F(BinaryVisitorTest, OnInstructionsBatchSize) {
+  // A single function with more instructions than fit in one batch.
+  const Index kNopCount = visit::kInstructionBatchSize + 10;
+  std::vector<u8> body(kNopCount, 0x01);  // nop
+  body.insert(body.begin(), 0x00);        // No locals.
+  body.push_back(0x0b);                   // end
+
+  std::vector<u8> data = {
+      0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00,  // Header.
+      0x01, 0x04, 0x01, 0x60, 0x00, 0x00,              // Type section.
+      0x03, 0x02, 0x01, 0x00,                          // Function section.
+  };
+  auto push_u32 = [](std::vector<u8>& out, u32 value) {
+    do {
+      u8 byte = value & 0x7f;
+      value >>= 7;
+      out.push_back(value ? byte | 0x80 : byte);
+    } while (value);
+  };
+  std::vector<u8> code = {0x01};  // Count.
+  push_u32(code, body.size());
+  code.insert(code.end(), body.begin(), body.end());
+  data.push_back(0x0a);  // Code section.
+  push_u32(data, code.size());
+  data.insert(data.end(), code.begin(), code.end());
+
+  BatchVisitor visitor;
+  LazyModule module = ReadModule(SpanU8{data}, features, errors);
+  EXPECT_EQ(visit::Result::Ok, visit::Visit(module, visitor));
+  EXPECT_EQ((std::vector<size_t>{visit::kInstructionBatchSize, 11}),
+            visitor.batch_sizes);
+  ExpectNoErrors(errors);
+}
+
+TEST_F(BinaryVisitorTest, OnInstructionsReadError) {
+  // nop, followed by an unknown opcode.
+  Context context{features, errors};
+  ReportingBatchVisitor visitor{errors};
+  EXPECT_EQ(visit::Result::Ok,
+            visit::VisitInstructionBatches("\x01\xff"_su8, context, visitor));
+  // The read error is reported after the nop has been visited.
+  ASSERT_EQ(2u, errors.errors.size());
+  EXPECT_EQ("visited 1", errors.errors[0].back().message);
+  EXPECT_EQ("Unknown opcode: 255", errors.errors[1].back().message);
+}
+
+TEST_F(BinaryVisitorTest, OnInstructionsReadErrorAfterFail) {
+  Context context{features, errors};
+  ReportingBatchVisitor visitor{errors};
+  visitor.fail = true;
+  EXPECT_EQ(visit::Result::Fail,
+            visit::VisitInstructionBatches("\x01\xff"_su8, context, visitor));
+  // Reading stops at the failure, as it does with OnInstruction, so the
+  // unknown opcode is never reported.
+  ASSERT_EQ(1u, errors.errors.size());
+  EXPECT_EQ("visited 1", errors.errors[0].back().message);
+}
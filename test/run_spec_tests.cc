@@ -26,6 +26,7 @@
 #include "src/tools/argparser.h"
 #include "src/tools/binary_errors.h"
 #include "src/tools/text_errors.h"
+#include "wasp/base/at.h"
 #include "wasp/base/enumerate.h"
 #include "wasp/base/error.h"
 #include "wasp/base/features.h"
@@ -156,6 +157,7 @@ void DoFile(const fs::path& path, const Features& features) {
     return;
   }
 
+  LocationBase location_base{*data};
   Tool tool{filename, *data, features};
   tool.Run();
 }
@@ -243,6 +245,7 @@ void Tool::OnAssertionCommand(text::Assertion& assertion) {
 void Tool::OnAssertMalformedText(Location loc,
                                  string_view filename,
                                  const Buffer& buffer) {
+  LocationBase location_base{buffer};
   text::Tokenizer tokenizer{buffer};
   tools::TextErrors nested_errors{filename, buffer};
   text::Context context{features, nested_errors};
@@ -261,10 +264,11 @@ void Tool::OnAssertMalformedText(Location loc,
 void Tool::OnAssertMalformedBinary(Location loc,
                                  string_view filename,
                                  const Buffer& buffer) {
+  LocationBase location_base{buffer};
   tools::BinaryErrors nested_errors{filename, buffer};
   binary::LazyModule module =
       binary::ReadModule(buffer, features, nested_errors);
-  binary::visit::Visitor visitor;
+  binary::visit::DecodeAllVisitor visitor;
   binary::visit::Visit(module, visitor);
   if (!nested_errors.has_error()) {
     errors.OnError(loc, "Expected malformed binary module.");
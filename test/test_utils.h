@@ -36,6 +36,8 @@ using ExpectedError = std::vector<ErrorWithPos>;
 
 class TestErrors : public Errors {
  public:
+  explicit TestErrors(bool track_context = true) : Errors{track_context} {}
+
   std::vector<Error> context_stack;
   std::vector<ErrorList> errors;
 
@@ -0,0 +1,203 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/valid/canonical_types.h"
+
+#include <set>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "test/binary/constants.h"
+
+using namespace ::wasp;
+using namespace ::wasp::valid;
+using namespace ::wasp::binary;
+using namespace ::wasp::binary::test;
+
+namespace {
+
+ValueType MakeRef(Index index, Null null = Null::No) {
+  return ValueType{ReferenceType{RefType{HeapType{Index{index}}, null}}};
+}
+
+DefinedType MakeStructType(const ValueTypeList& field_types,
+                           Mutability mut = Mutability::Const) {
+  FieldTypeList fields;
+  for (const auto& field_type : field_types) {
+    fields.push_back(FieldType{StorageType{field_type}, mut});
+  }
+  return DefinedType{StructType{fields}};
+}
+
+DefinedType MakeFunctionType(const ValueTypeList& params,
+                             const ValueTypeList& results) {
+  return DefinedType{FunctionType{params, results}};
+}
+
+}  // namespace
+
+TEST(ValidCanonicalTypesTest, Empty) {
+  EXPECT_EQ(std::vector<Index>{}, CanonicalizeTypes({}));
+}
+
+TEST(ValidCanonicalTypesTest, Finite) {
+  auto ids = CanonicalizeTypes({
+      MakeFunctionType({VT_I32}, {}),  // 0
+      MakeFunctionType({VT_I32}, {}),  // 1
+      MakeFunctionType({VT_I64}, {}),  // 2
+      MakeFunctionType({}, {VT_I32}),  // 3
+      MakeStructType({MakeRef(0)}),    // 4
+      MakeStructType({MakeRef(1)}),    // 5
+      MakeStructType({MakeRef(2)}),    // 6
+      DefinedType{StructType{}},       // 7
+      DefinedType{ArrayType{FieldType{StorageType{VT_I32}, Mutability::Const}}},
+  });
+
+  EXPECT_EQ(ids[0], ids[1]);
+  EXPECT_EQ(ids[4], ids[5]);
+
+  EXPECT_NE(ids[0], ids[2]);
+  EXPECT_NE(ids[0], ids[3]);
+  EXPECT_NE(ids[4], ids[6]);
+  EXPECT_NE(ids[7], ids[8]);
+}
+
+TEST(ValidCanonicalTypesTest, Distinct) {
+  auto ids = CanonicalizeTypes({
+      MakeStructType({VT_Funcref}),                   // 0
+      MakeStructType({VT_Funcref}, Mutability::Var),  // 1
+      MakeStructType({VT_RefFunc}),                   // 2
+      MakeStructType({MakeRef(4)}),                   // 3
+      MakeStructType({MakeRef(4, Null::Yes)}),        // 4
+      MakeStructType({VT_RTT_0_Func}),                // 5
+      MakeStructType({VT_RTT_1_Func}),                // 6
+      DefinedType{StructType{FieldTypeList{
+          FieldType{StorageType{PackedType::I8}, Mutability::Const}}}},
+  });
+
+  for (size_t i = 0; i < ids.size(); ++i) {
+    for (size_t j = i + 1; j < ids.size(); ++j) {
+      EXPECT_NE(ids[i], ids[j]) << i << " and " << j;
+    }
+  }
+}
+
+TEST(ValidCanonicalTypesTest, ReferenceTypeShorthand) {
+  // "funcref" is the same as "ref null func".
+  auto ids = CanonicalizeTypes({
+      MakeStructType({VT_Funcref}),
+      MakeStructType({VT_RefNullFunc}),
+  });
+  EXPECT_EQ(ids[0], ids[1]);
+}
+
+TEST(ValidCanonicalTypesTest, Recursive) {
+  auto ids = CanonicalizeTypes({
+      MakeFunctionType({}, {MakeRef(0)}),        // 0
+      MakeFunctionType({}, {MakeRef(1)}),        // 1
+      MakeFunctionType({VT_I32}, {MakeRef(0)}),  // 2
+      MakeFunctionType({VT_I32}, {MakeRef(1)}),  // 3
+  });
+
+  EXPECT_EQ(ids[0], ids[1]);
+  EXPECT_EQ(ids[2], ids[3]);
+  EXPECT_NE(ids[0], ids[2]);
+}
+
+TEST(ValidCanonicalTypesTest, MutuallyRecursive) {
+  auto ids = CanonicalizeTypes({
+      MakeFunctionType({VT_I32}, {MakeRef(0)}),  // 0
+      MakeFunctionType({VT_I32}, {MakeRef(2)}),  // 1
+      MakeFunctionType({VT_I32}, {MakeRef(1)}),  // 2
+      MakeStructType({MakeRef(4), VT_I32}),      // 3
+      MakeStructType({MakeRef(3), VT_I64}),      // 4
+      MakeStructType({MakeRef(6), VT_I32}),      // 5
+      MakeStructType({MakeRef(5), VT_I64}),      // 6
+  });
+
+  EXPECT_EQ(ids[0], ids[1]);
+  EXPECT_EQ(ids[0], ids[2]);
+  EXPECT_EQ(ids[3], ids[5]);
+  EXPECT_EQ(ids[4], ids[6]);
+  EXPECT_NE(ids[3], ids[4]);
+}
+
+TEST(ValidCanonicalTypesTest, RefersToRecursive) {
+  auto ids = CanonicalizeTypes({
+      MakeStructType({MakeRef(1)}),  // 0
+      MakeStructType({MakeRef(1)}),  // 1
+      MakeStructType({MakeRef(3)}),  // 2
+      DefinedType{StructType{}},     // 3
+  });
+
+  // Both types unfold to an infinite chain of structs.
+  EXPECT_EQ(ids[0], ids[1]);
+  // A finite type is never the same as a recursive one.
+  EXPECT_NE(ids[0], ids[2]);
+}
+
+TEST(ValidCanonicalTypesTest, IndexOutOfRange) {
+  auto ids = CanonicalizeTypes({
+      MakeStructType({MakeRef(5)}),  // 0
+      MakeStructType({MakeRef(5)}),  // 1
+      MakeStructType({MakeRef(6)}),  // 2
+  });
+
+  EXPECT_EQ(ids[0], ids[1]);
+  EXPECT_NE(ids[0], ids[2]);
+}
+
+TEST(ValidCanonicalTypesTest, SplitKeepsLargestPart) {
+  auto ids = CanonicalizeTypes({
+      MakeStructType({MakeRef(0), VT_I32}),  // 0
+      MakeStructType({MakeRef(1), VT_I64}),  // 1
+      MakeStructType({MakeRef(1), VT_I32}),  // 2
+      MakeStructType({MakeRef(1), VT_I32}),  // 3
+      MakeStructType({MakeRef(1), VT_I32}),  // 4
+  });
+
+  // 2, 3 and 4 are split from 0 only once 1 is split from all of them.
+  EXPECT_EQ(ids[2], ids[3]);
+  EXPECT_EQ(ids[2], ids[4]);
+  EXPECT_NE(ids[0], ids[1]);
+  EXPECT_NE(ids[0], ids[2]);
+  EXPECT_NE(ids[1], ids[2]);
+}
+
+TEST(ValidCanonicalTypesTest, LongChain) {
+  // Two copies of a chain of types that each refer to the next one. Only the
+  // last one differs, so each round of splitting separates one more type
+  // from the rest.
+  constexpr Index kLength = 20000;
+  std::vector<DefinedType> types;
+  for (Index copy = 0; copy < 2; ++copy) {
+    Index first = copy * kLength;
+    for (Index i = 0; i < kLength - 1; ++i) {
+      types.push_back(MakeStructType({MakeRef(first + i + 1), VT_I32}));
+    }
+    types.push_back(MakeStructType({MakeRef(first + kLength - 1), VT_I64}));
+  }
+
+  auto ids = CanonicalizeTypes(types);
+  ASSERT_EQ(size_t{2 * kLength}, ids.size());
+  for (Index i = 0; i < kLength; ++i) {
+    EXPECT_EQ(ids[i], ids[kLength + i]) << i;
+  }
+  std::set<Index> distinct(ids.begin(), ids.begin() + kLength);
+  EXPECT_EQ(size_t{kLength}, distinct.size());
+}
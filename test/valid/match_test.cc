@@ -266,7 +266,6 @@ TEST_F(ValidMatchTest, IsSame_ValueType_Simple) {
 }
 
 TEST_F(ValidMatchTest, IsSame_ValueType_Var) {
-  context.same_types.Reset(3);
   PushFunctionType({VT_F32}, {});  // 0
   PushFunctionType({VT_F32}, {});  // 1
   PushFunctionType({VT_I32}, {});  // 2
@@ -277,7 +276,6 @@ TEST_F(ValidMatchTest, IsSame_ValueType_Var) {
 }
 
 TEST_F(ValidMatchTest, IsSame_ValueType_VarRecursive) {
-  context.same_types.Reset(3);
   PushFunctionType({}, {VT_Ref0});        // 0
   PushFunctionType({}, {VT_Ref1});        // 1
   PushFunctionType({VT_I32}, {VT_Ref0});  // 2
@@ -288,7 +286,6 @@ TEST_F(ValidMatchTest, IsSame_ValueType_VarRecursive) {
 }
 
 TEST_F(ValidMatchTest, IsSame_ValueType_VarMutuallyRecursive) {
-  context.same_types.Reset(3);
   PushFunctionType({VT_I32}, {VT_Ref0});  // 0
   PushFunctionType({VT_I32}, {VT_Ref2});  // 1
   PushFunctionType({VT_I32}, {VT_Ref1});  // 2
@@ -677,6 +674,33 @@ TEST_F(ValidMatchTest, IsMatch_StructType_Subtyping) {
                           FieldType{StorageType{VT_I32}, Mutability::Var}}}));
 }
 
+TEST_F(ValidMatchTest, IsMatch_StructType_Recursive) {
+  auto field = [](Index index) {
+    return FieldType{StorageType{ValueType{ReferenceType{
+                         RefType{HeapType{Index{index}}, Null::No}}}},
+                     Mutability::Const};
+  };
+  auto i32_field = FieldType{StorageType{VT_I32}, Mutability::Const};
+  auto i64_field = FieldType{StorageType{VT_I64}, Mutability::Const};
+
+  PushStructType(StructType{FieldTypeList{field(0)}});             // 0
+  PushStructType(StructType{FieldTypeList{field(1), i32_field}});  // 1
+
+  EXPECT_TRUE(IsMatch(context, HeapType{Index{0}}, HeapType{Index{1}}));
+  EXPECT_FALSE(IsMatch(context, HeapType{Index{1}}, HeapType{Index{0}}));
+
+  // Checking whether 4 matches 2 assumes that it does, so 5 matches 3 while
+  // that assumption holds. That result must be discarded when 4 doesn't match
+  // 2, because of the i32 and i64 fields.
+  PushStructType(StructType{FieldTypeList{field(3), i64_field}});  // 2
+  PushStructType(StructType{FieldTypeList{field(2)}});             // 3
+  PushStructType(StructType{FieldTypeList{field(5), i32_field}});  // 4
+  PushStructType(StructType{FieldTypeList{field(4)}});             // 5
+
+  EXPECT_FALSE(IsMatch(context, HeapType{Index{2}}, HeapType{Index{4}}));
+  EXPECT_FALSE(IsMatch(context, HeapType{Index{3}}, HeapType{Index{5}}));
+}
+
 TEST_F(ValidMatchTest, IsMatch_ArrayType_Simple) {
   std::vector<ArrayType> types{
       ArrayType{FieldType{StorageType{VT_I32}, Mutability::Const}},
@@ -0,0 +1,117 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/valid/module_batch.h"
+
+#include <mutex>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "wasp/base/thread_pool.h"
+
+using namespace ::wasp;
+using namespace ::wasp::valid;
+
+namespace {
+
+const SpanU8 kValidModule =
+    "\0asm\x01\0\0\0"_su8
+    "\x01\x04\x01\x60\x00\x00"_su8   // (type (func))
+    "\x03\x02\x01\x00"_su8           // (func (type 0))
+    "\x0a\x04\x01\x02\x00\x0b"_su8;  // (code)
+
+const SpanU8 kInvalidModule =
+    "\0asm\x01\0\0\0"_su8
+    "\x01\x04\x01\x60\x00\x00"_su8           // (type (func))
+    "\x03\x02\x01\x00"_su8                   // (func (type 0))
+    "\x0a\x06\x01\x04\x00\x41\x00\x0b"_su8;  // (code i32.const 0)
+
+struct Result {
+  bool called = false;
+  bool read_file = false;
+  bool valid = false;
+  size_t error_count = 0;
+};
+
+std::vector<Result> RunBatch(ModuleBatch& batch, bool* all_valid) {
+  std::mutex mutex;
+  std::vector<Result> results(batch.size());
+  *all_valid = batch.Run([&](const ModuleBatchResult& result) {
+    std::lock_guard<std::mutex> lock{mutex};
+    auto& out = results[result.index];
+    EXPECT_FALSE(out.called);
+    out = Result{true, result.read_file, result.valid, result.errors.size()};
+  });
+  return results;
+}
+
+}  // namespace
+
+TEST(ValidModuleBatchTest, Basic) {
+  ThreadPool pool{4};
+  ModuleBatch batch{Features{}, pool};
+  for (int i = 0; i < 50; ++i) {
+    batch.Add(i % 5 == 3 ? kInvalidModule : kValidModule);
+  }
+  ASSERT_EQ(50u, batch.size());
+
+  // Run twice, to check that reusing the workers doesn't leak state between
+  // modules.
+  for (int run = 0; run < 2; ++run) {
+    bool all_valid = true;
+    auto results = RunBatch(batch, &all_valid);
+    EXPECT_FALSE(all_valid);
+    for (size_t i = 0; i < results.size(); ++i) {
+      EXPECT_TRUE(results[i].called) << i;
+      EXPECT_TRUE(results[i].read_file) << i;
+      EXPECT_EQ(i % 5 != 3, results[i].valid) << i;
+      EXPECT_EQ(i % 5 != 3, results[i].error_count == 0) << i;
+    }
+  }
+}
+
+TEST(ValidModuleBatchTest, AllValid) {
+  ThreadPool pool{2};
+  ModuleBatch batch{Features{}, pool};
+  batch.Add(kValidModule);
+  batch.Add(kValidModule);
+
+  bool all_valid = false;
+  auto results = RunBatch(batch, &all_valid);
+  EXPECT_TRUE(all_valid);
+
+  batch.Clear();
+  EXPECT_TRUE(batch.empty());
+  results = RunBatch(batch, &all_valid);
+  EXPECT_TRUE(all_valid);
+  EXPECT_TRUE(results.empty());
+}
+
+TEST(ValidModuleBatchTest, MissingFile) {
+  ThreadPool pool{2};
+  ModuleBatch batch{Features{}, pool};
+  batch.AddFile("this/file/does/not/exist.wasm");
+  batch.Add(kValidModule);
+
+  bool all_valid = true;
+  auto results = RunBatch(batch, &all_valid);
+  EXPECT_FALSE(all_valid);
+  ASSERT_EQ(2u, results.size());
+  EXPECT_FALSE(results[0].read_file);
+  EXPECT_FALSE(results[0].valid);
+  EXPECT_TRUE(results[1].valid);
+}
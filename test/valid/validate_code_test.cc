@@ -18,6 +18,7 @@
 #include "test/binary/constants.h"
 #include "test/valid/test_utils.h"
 #include "wasp/base/features.h"
+#include "wasp/binary/packed_instruction_stream.h"
 #include "wasp/valid/context.h"
 #include "wasp/valid/validate.h"
 
@@ -29,7 +30,7 @@ using namespace ::wasp::valid::test;
 
 TEST(ValidateCodeTest, BeginCode) {
   TestErrors errors;
-  Context context{errors};
+  valid::Context context{errors};
   context.types.push_back(DefinedType{FunctionType{}});
   context.defined_type_count = 1;
   context.functions.push_back(Function{0});
@@ -38,7 +39,7 @@ TEST(ValidateCodeTest, BeginCode) {
 
 TEST(ValidateCodeTest, BeginCode_CodeIndexOOB) {
   TestErrors errors;
-  Context context{errors};
+  valid::Context context{errors};
   context.types.push_back(DefinedType{FunctionType{}});
   context.functions.push_back(Function{0});
   context.code_count = 1;
@@ -47,7 +48,7 @@ TEST(ValidateCodeTest, BeginCode_CodeIndexOOB) {
 
 TEST(ValidateCodeTest, BeginCode_TypeIndexOOB) {
   TestErrors errors;
-  Context context{errors};
+  valid::Context context{errors};
   context.types.push_back(DefinedType{FunctionType{}});
   context.functions.push_back(Function{1});
   EXPECT_FALSE(BeginCode(context, Location{}));
@@ -55,7 +56,7 @@ TEST(ValidateCodeTest, BeginCode_TypeIndexOOB) {
 
 TEST(ValidateCodeTest, BeginCode_NonFunctionType) {
   TestErrors errors;
-  Context context{errors};
+  valid::Context context{errors};
   context.types.push_back(DefinedType{StructType{}});
   context.defined_type_count = 1;
   context.functions.push_back(Function{0});
@@ -64,6 +65,42 @@ TEST(ValidateCodeTest, BeginCode_NonFunctionType) {
 
 TEST(ValidateCodeTest, Locals) {
   TestErrors errors;
-  Context context{errors};
+  valid::Context context{errors};
   EXPECT_TRUE(Validate(context, Locals{10, VT_I32}, RequireDefaultable::Yes));
 }
+
+TEST(ValidateCodeTest, PackedInstructionStream) {
+  TestErrors errors;
+  valid::Context context{errors};
+  context.types.push_back(DefinedType{FunctionType{}});
+  context.defined_type_count = 1;
+  context.functions.push_back(Function{0});
+  EXPECT_TRUE(BeginCode(context, Location{}));
+
+  PackedInstructionStream stream;
+  stream.Append(Instruction{At{Opcode::Block}, At{BT_Void}});
+  stream.Append(Instruction{Opcode::I32Const, s32{0}});
+  stream.Append(Instruction{
+      At{Opcode::BrTable},
+      At{BrTableImmediate{{At{Index{0}}, At{Index{1}}}, At{Index{0}}}}});
+  stream.Append(Instruction{At{Opcode::End}});
+  stream.Append(Instruction{At{Opcode::End}});
+  EXPECT_TRUE(Validate(context, stream));
+  ExpectNoErrors(errors);
+}
+
+TEST(ValidateCodeTest, PackedInstructionStream_StopsAtFirstError) {
+  TestErrors errors;
+  valid::Context context{errors};
+  context.types.push_back(DefinedType{FunctionType{}});
+  context.defined_type_count = 1;
+  context.functions.push_back(Function{0});
+  EXPECT_TRUE(BeginCode(context, Location{}));
+
+  PackedInstructionStream stream;
+  stream.Append(Instruction{At{Opcode::I32Add}});
+  stream.Append(Instruction{At{Opcode::I32Add}});
+  EXPECT_FALSE(Validate(context, stream));
+  ExpectError({"instruction", "Expected stack to contain [i32 i32], got []"},
+              errors);
+}
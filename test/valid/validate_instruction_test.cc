@@ -65,8 +65,6 @@ class ValidateInstructionTest : public ::testing::Test {
 
   void IncrementDefinedTypeCount() {
     context.defined_type_count++;
-    context.same_types.Reset(context.defined_type_count);
-    context.match_types.Reset(context.defined_type_count);
   }
 
   Index AddFunctionType(const FunctionType& function_type) {
@@ -283,6 +281,38 @@ TEST_F(ValidateInstructionTest, Block_Param) {
               errors);
 }
 
+TEST_F(ValidateInstructionTest, Block_LabelTypes) {
+  auto index = AddFunctionType(FunctionType{{VT_I64}, {VT_I32, VT_F32}});
+  auto function_label_types = context.label_types.size();
+  Ok(I{O::I64Const, s64{}});
+  Ok(I{O::Block, BlockType(index)});
+  Ok(I{O::Loop, BT_I32});
+  EXPECT_EQ(function_label_types + 4, context.label_types.size());
+
+  const StackTypeList block_params = ToStackTypeList(ValueTypeList{VT_I64});
+  const StackTypeList block_results =
+      ToStackTypeList(ValueTypeList{VT_I32, VT_F32});
+  const StackTypeList loop_results = ToStackTypeList(ValueTypeList{VT_I32});
+  const auto& block_label = context.label_stack[context.label_stack.size() - 2];
+  EXPECT_EQ(StackTypeSpan{block_params}, context.GetParamTypes(block_label));
+  EXPECT_EQ(StackTypeSpan{block_results}, context.GetResultTypes(block_label));
+  // A loop's branch types are its param types, which are empty here.
+  EXPECT_EQ(StackTypeSpan{}, context.GetBrTypes(context.label_stack.back()));
+  EXPECT_EQ(StackTypeSpan{loop_results},
+            context.GetResultTypes(context.label_stack.back()));
+
+  Ok(I{O::I32Const, s32{}});
+  Ok(I{O::End});
+  EXPECT_EQ(function_label_types + 3, context.label_types.size());
+  Ok(I{O::Drop});
+  Ok(I{O::Drop});
+  Ok(I{O::I32Const, s32{}});
+  Ok(I{O::F32Const, f32{}});
+  Ok(I{O::End});
+  EXPECT_EQ(function_label_types, context.label_types.size());
+  ExpectNoErrors(errors);
+}
+
 TEST_F(ValidateInstructionTest, Loop_Void) {
   Ok(I{O::Loop, BT_Void});
   Ok(I{O::End});
@@ -1805,7 +1835,7 @@ TEST_F(ValidateInstructionTest, ReferenceTypes) {
 }
 
 TEST_F(ValidateInstructionTest, RefFunc) {
-  context.declared_functions.insert(0);
+  context.DeclareFunction(0);
   TestSignature(I{O::RefFunc, Index{0}}, {}, {VT_Ref0});
 }
 
@@ -2730,7 +2760,7 @@ TEST_F(ValidateInstructionTest, CallRef) {
 
 TEST_F(ValidateInstructionTest, CallRef_ParamTypeMismatch) {
   auto index = AddFunction(FunctionType{{VT_F32}, {}});
-  context.declared_functions.insert(index);
+  context.DeclareFunction(index);
 
   Ok(I{O::I32Const, s32{}});
   Ok(I{O::RefFunc, index});
@@ -2755,7 +2785,7 @@ TEST_F(ValidateInstructionTest, ReturnCallRef) {
 TEST_F(ValidateInstructionTest, ReturnCallRef_ResultType_Subtyping) {
   BeginFunction(FunctionType{{}, {VT_Funcref}});
   auto index = AddFunction(FunctionType{{}, {VT_Ref0}});
-  context.declared_functions.insert(index);
+  context.DeclareFunction(index);
 
   Ok(I{O::RefFunc, index});
   Ok(I{O::ReturnCallRef});
@@ -2765,7 +2795,7 @@ TEST_F(ValidateInstructionTest, ReturnCallRef_ResultType_Subtyping) {
 TEST_F(ValidateInstructionTest, ReturnCallRef_Unreachable) {
   BeginFunction(FunctionType{});
   auto index = AddFunction(FunctionType{});
-  context.declared_functions.insert(index);
+  context.DeclareFunction(index);
 
   Ok(I{O::RefFunc, index});
   Ok(I{O::ReturnCallRef});
@@ -2777,7 +2807,7 @@ TEST_F(ValidateInstructionTest, ReturnCallRef_Unreachable) {
 TEST_F(ValidateInstructionTest, ReturnCallRef_ParamTypeMismatch) {
   BeginFunction(FunctionType{});
   auto index = AddFunction(FunctionType{{VT_F32}, {}});
-  context.declared_functions.insert(index);
+  context.DeclareFunction(index);
 
   Ok(I{O::I32Const, s32{}});
   Ok(I{O::RefFunc, index});
@@ -2789,7 +2819,7 @@ TEST_F(ValidateInstructionTest, ReturnCallRef_ParamTypeMismatch) {
 TEST_F(ValidateInstructionTest, ReturnCallRef_ResultTypeMismatch) {
   BeginFunction(FunctionType{{}, {VT_F32}});
   auto index = AddFunction(FunctionType{{}, {VT_I32}});
-  context.declared_functions.insert(index);
+  context.DeclareFunction(index);
 
   Ok(I{O::RefFunc, index});
   Fail(I{O::ReturnCallRef});
@@ -219,7 +219,7 @@ TEST(ValidateTest, ConstantExpression_Funcref) {
       context, ConstantExpression{Instruction{Opcode::RefFunc, Index{0}}},
       VT_Funcref, 0));
 
-  EXPECT_EQ(1u, context.declared_functions.size());
+  EXPECT_TRUE(context.IsFunctionDeclared(0));
 }
 
 TEST(ValidateTest, DataCount) {
@@ -371,11 +371,11 @@ TEST(ValidateTest, ElementSegment_Declared) {
               {ElementExpression{Instruction{Opcode::RefFunc, Index{0}}}}}},
   };
 
-  EXPECT_EQ(0u, context.declared_functions.count(0));
+  EXPECT_FALSE(context.IsFunctionDeclared(0));
   for (const auto& element_segment : tests) {
     EXPECT_TRUE(Validate(context, element_segment));
   }
-  EXPECT_EQ(1u, context.declared_functions.count(0));
+  EXPECT_TRUE(context.IsFunctionDeclared(0));
 }
 
 TEST(ValidateTest, ElementSegment_RefType) {
@@ -490,7 +490,7 @@ TEST(ValidateTest, Export) {
   }
 
   // Exporting a function marks it as declared.
-  EXPECT_EQ(1u, context.declared_functions.size());
+  EXPECT_TRUE(context.IsFunctionDeclared(0));
 }
 
 TEST(ValidateTest, Export_IndexOOB) {
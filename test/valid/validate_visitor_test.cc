@@ -0,0 +1,146 @@
+//
+// Copyright 2020 WebAssembly Community Group participants
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "wasp/valid/validate_visitor.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "test/test_utils.h"
+#include "wasp/base/thread_pool.h"
+#include "wasp/binary/lazy_module.h"
+
+using namespace ::wasp;
+using namespace ::wasp::valid;
+using namespace ::wasp::test;
+
+namespace {
+
+void AppendU32(std::string& out, u32 value) {
+  do {
+    u8 byte = value & 0x7f;
+    value >>= 7;
+    out += static_cast<char>(value ? byte | 0x80 : byte);
+  } while (value);
+}
+
+void AppendSection(std::string& out, u8 id, const std::string& contents) {
+  out += static_cast<char>(id);
+  AppendU32(out, static_cast<u32>(contents.size()));
+  out += contents;
+}
+
+// Builds a module with `bodies.size()` functions of type (func).
+std::string MakeModule(const std::vector<std::string>& bodies) {
+  std::string module{"\0asm\x01\0\0\0", 8};
+  AppendSection(module, 1, std::string{"\x01\x60\x00\x00", 4});
+
+  std::string functions;
+  AppendU32(functions, static_cast<u32>(bodies.size()));
+  functions.append(bodies.size(), '\0');
+  AppendSection(module, 3, functions);
+
+  std::string code;
+  AppendU32(code, static_cast<u32>(bodies.size()));
+  for (const auto& body : bodies) {
+    AppendU32(code, static_cast<u32>(body.size() + 1));
+    code += '\0';  // No locals.
+    code += body;
+  }
+  AppendSection(module, 10, code);
+  return module;
+}
+
+SpanU8 ToSpan(const std::string& str) {
+  return SpanU8{reinterpret_cast<const u8*>(str.data()), str.size()};
+}
+
+binary::visit::Result Validate(SpanU8 data,
+                               ThreadPool* pool,
+                               TestErrors& errors) {
+  Features features;
+  auto module = binary::ReadModule(data, features, errors);
+  ValidateVisitor visitor{features, errors, pool};
+  return binary::visit::Visit(module, visitor);
+}
+
+// Validates `data` sequentially and in parallel, and checks that the results
+// and errors are the same.
+binary::visit::Result ExpectSameAsSequential(SpanU8 data) {
+  TestErrors sequential_errors;
+  auto sequential = Validate(data, nullptr, sequential_errors);
+
+  ThreadPool pool{4};
+  TestErrors parallel_errors;
+  auto parallel = Validate(data, &pool, parallel_errors);
+
+  EXPECT_EQ(sequential, parallel);
+  ExpectErrors(sequential_errors.errors, parallel_errors);
+  return parallel;
+}
+
+const std::string kValidBody{"\x01\x0b", 2};                   // nop
+const std::string kCallBody{"\x10\x00\x0b", 3};               // call 0
+const std::string kInvalidBody{"\x41\x00\x0b", 3};            // i32.const 0
+const std::string kUnclosedBody{"\x02\x40\x02\x40\x0b", 5};  // block block
+
+}  // namespace
+
+TEST(ValidValidateVisitorTest, Parallel_Valid) {
+  std::vector<std::string> bodies(300, kValidBody);
+  for (size_t i = 0; i < bodies.size(); i += 7) {
+    bodies[i] = kCallBody;
+  }
+  auto module = MakeModule(bodies);
+
+  ThreadPool pool{4};
+  TestErrors errors;
+  EXPECT_EQ(binary::visit::Result::Ok, Validate(ToSpan(module), &pool, errors));
+  ExpectNoErrors(errors);
+}
+
+TEST(ValidValidateVisitorTest, Parallel_Invalid) {
+  // Only the errors of the first invalid body are reported.
+  std::vector<std::string> bodies(300, kValidBody);
+  bodies[70] = kInvalidBody;
+  bodies[250] = kInvalidBody;
+  auto module = MakeModule(bodies);
+  EXPECT_EQ(binary::visit::Result::Fail,
+            ExpectSameAsSequential(ToSpan(module)));
+}
+
+TEST(ValidValidateVisitorTest, Parallel_UnclosedBlock) {
+  // An unclosed block affects how the following bodies are read.
+  std::vector<std::string> bodies(100, kValidBody);
+  bodies[40] = kUnclosedBody;
+  auto module = MakeModule(bodies);
+  ExpectSameAsSequential(ToSpan(module));
+
+  bodies[40] = kValidBody;
+  bodies.back() = kUnclosedBody;
+  module = MakeModule(bodies);
+  ExpectSameAsSequential(ToSpan(module));
+}
+
+TEST(ValidValidateVisitorTest, Parallel_Malformed) {
+  std::vector<std::string> bodies(100, kValidBody);
+  auto module = MakeModule(bodies);
+  // Truncate the last body.
+  module.pop_back();
+  ExpectSameAsSequential(ToSpan(module));
+}